@@ -171,9 +171,9 @@ void Action::commit(DirtyList* dirty_list) {
 							house->addTile(new_tile);
 						}
 					}
-					if (old_tile->spawnMonster) {
-						if (new_tile->spawnMonster) {
-							if (*old_tile->spawnMonster != *new_tile->spawnMonster) {
+					if (old_tile->getSpawnMonster()) {
+						if (new_tile->getSpawnMonster()) {
+							if (*old_tile->getSpawnMonster() != *new_tile->getSpawnMonster()) {
 								map.removeSpawnMonster(old_tile);
 								map.addSpawnMonster(new_tile);
 							}
@@ -181,12 +181,12 @@ void Action::commit(DirtyList* dirty_list) {
 							// Monster spawn has been removed
 							editor.getMap().removeSpawnMonster(old_tile);
 						}
-					} else if (new_tile->spawnMonster) {
+					} else if (new_tile->getSpawnMonster()) {
 						editor.getMap().addSpawnMonster(new_tile);
 					}
-					if (old_tile->spawnNpc) {
-						if (new_tile->spawnNpc) {
-							if (*old_tile->spawnNpc != *new_tile->spawnNpc) {
+					if (old_tile->getSpawnNpc()) {
+						if (new_tile->getSpawnNpc()) {
+							if (*old_tile->getSpawnNpc() != *new_tile->getSpawnNpc()) {
 								map.removeSpawnNpc(old_tile);
 								map.addSpawnNpc(new_tile);
 							}
@@ -194,7 +194,7 @@ void Action::commit(DirtyList* dirty_list) {
 							// SpawnMonster has been removed
 							map.removeSpawnNpc(old_tile);
 						}
-					} else if (new_tile->spawnNpc) {
+					} else if (new_tile->getSpawnNpc()) {
 						map.addSpawnNpc(new_tile);
 					}
 
@@ -214,11 +214,11 @@ void Action::commit(DirtyList* dirty_list) {
 						}
 					}
 
-					if (new_tile->spawnMonster) {
+					if (new_tile->getSpawnMonster()) {
 						map.addSpawnMonster(new_tile);
 					}
 
-					if (new_tile->spawnNpc) {
+					if (new_tile->getSpawnNpc()) {
 						map.addSpawnNpc(new_tile);
 					}
 				}
@@ -260,7 +260,7 @@ void Action::commit(DirtyList* dirty_list) {
 					new_tile->increaseWaypointCount();
 
 					Position old_pos = waypoint->pos;
-					waypoint->pos = data->position;
+					map.waypoints.moveWaypoint(waypoint, data->position);
 					data->position = old_pos;
 				}
 				break;
@@ -329,29 +329,29 @@ void Action::undo(DirtyList* dirty_list) {
 					}
 				}
 
-				if (old_tile->spawnMonster) {
-					if (new_tile->spawnMonster) {
-						if (*old_tile->spawnMonster != *new_tile->spawnMonster) {
+				if (old_tile->getSpawnMonster()) {
+					if (new_tile->getSpawnMonster()) {
+						if (*old_tile->getSpawnMonster() != *new_tile->getSpawnMonster()) {
 							map.removeSpawnMonster(new_tile);
 							map.addSpawnMonster(old_tile);
 						}
 					} else {
 						map.addSpawnMonster(old_tile);
 					}
-				} else if (new_tile->spawnMonster) {
+				} else if (new_tile->getSpawnMonster()) {
 					map.removeSpawnMonster(new_tile);
 				}
 
-				if (old_tile->spawnNpc) {
-					if (new_tile->spawnNpc) {
-						if (*old_tile->spawnNpc != *new_tile->spawnNpc) {
+				if (old_tile->getSpawnNpc()) {
+					if (new_tile->getSpawnNpc()) {
+						if (*old_tile->getSpawnNpc() != *new_tile->getSpawnNpc()) {
 							map.removeSpawnNpc(new_tile);
 							map.addSpawnNpc(old_tile);
 						}
 					} else {
 						map.addSpawnNpc(old_tile);
 					}
-				} else if (new_tile->spawnNpc) {
+				} else if (new_tile->getSpawnNpc()) {
 					map.removeSpawnNpc(new_tile);
 				}
 				*data = new_tile;
@@ -392,7 +392,7 @@ void Action::undo(DirtyList* dirty_list) {
 					new_tile->increaseWaypointCount();
 
 					Position old_pos = waypoint->pos;
-					waypoint->pos = data->position;
+					map.waypoints.moveWaypoint(waypoint, data->position);
 					data->position = old_pos;
 				}
 				break;
@@ -23,6 +23,7 @@
 BaseMap::BaseMap() :
 	allocator(),
 	tilecount(0),
+	snapshot(nullptr),
 	root(*this) {
 	////
 }
@@ -46,9 +47,384 @@ void BaseMap::clearVisible(uint32_t mask) {
 	root.clearVisible(mask);
 }
 
+MapCompactionStats BaseMap::compact() {
+	MapCompactionStats stats;
+	// Tiles held by the snapshot still point at their locations
+	if (snapshot) {
+		return stats;
+	}
+	// The root stays, even when the map is empty
+	compactNode(&root, 0, 0, 14, stats);
+	stats.bytes = stats.floors * sizeof(Floor) + stats.nodes * sizeof(QTreeNode);
+	return stats;
+}
+
+bool BaseMap::compactNode(QTreeNode* node, uint32_t x, uint32_t y, uint32_t shift, MapCompactionStats &stats) {
+	bool empty = true;
+	if (node->isLeaf) {
+		for (Floor*&floor : node->array) {
+			if (!floor) {
+				continue;
+			}
+
+			if (floor->occupied == 0 && std::all_of(std::begin(floor->locs), std::end(floor->locs), [](const TileLocation &location) { return location.isUnused(); })) {
+				allocator.freeFloor(floor);
+				floor = nullptr;
+				++stats.floors;
+			} else {
+				empty = false;
+			}
+		}
+		// Live clients keep track of what they've seen through the leaves
+		return empty && node->visible == 0;
+	}
+
+	for (uint32_t i = 0; i < rme::MapLayers; ++i) {
+		QTreeNode*&child = node->child[i];
+		if (!child) {
+			continue;
+		}
+
+		// Same layout as QTreeNode::getLeaf, x in the low and y in the high bits
+		const uint32_t child_x = x | ((i & 3) << shift);
+		const uint32_t child_y = y | ((i >> 2) << shift);
+		if (compactNode(child, child_x, child_y, shift - 2, stats)) {
+			if (child->isLeaf) {
+				leaves.remove(child_x, child_y);
+			}
+			allocator.freeNode(child);
+			child = nullptr;
+			++stats.nodes;
+		} else {
+			empty = false;
+		}
+	}
+	return empty;
+}
+
+namespace {
+	// Interleaves the bits of the leaf coordinates, x in the even bits
+	uint32_t getLeafMortonKey(uint32_t leaf_x, uint32_t leaf_y) noexcept {
+		uint32_t key = 0;
+		for (uint32_t bit = 0; bit < 16; ++bit) {
+			key |= ((leaf_x >> bit) & 1) << (bit * 2);
+			key |= ((leaf_y >> bit) & 1) << (bit * 2 + 1);
+		}
+		return key;
+	}
+
+	struct RelayoutLeaf {
+		uint32_t key;
+		int x, y;
+		QTreeNode* parent;
+		uint32_t index;
+	};
+}
+
+void BaseMap::relayout() {
+	if (snapshot) {
+		return;
+	}
+
+	MapAllocator fresh;
+	std::vector<RelayoutLeaf> list;
+
+	// Inner nodes are copied in depth first order, their leaves are only recorded
+	const std::function<void(QTreeNode*, uint32_t, uint32_t, uint32_t)> copyChildren = [&](QTreeNode* node, uint32_t x, uint32_t y, uint32_t shift) {
+		for (uint32_t i = 0; i < rme::MapLayers; ++i) {
+			QTreeNode* child = node->child[i];
+			if (!child) {
+				continue;
+			}
+
+			const uint32_t child_x = x | ((i & 3) << shift);
+			const uint32_t child_y = y | ((i >> 2) << shift);
+			if (child->isLeaf) {
+				list.push_back({ getLeafMortonKey(child_x >> 2, child_y >> 2), static_cast<int>(child_x), static_cast<int>(child_y), node, i });
+				continue;
+			}
+
+			QTreeNode* copy = fresh.allocateNode(*this);
+			copy->parent = node;
+			copy->visible = child->visible;
+			copy->tile_count = child->tile_count;
+			copy->content_hash = child->content_hash;
+			std::copy(std::begin(child->child), std::end(child->child), std::begin(copy->child));
+			node->child[i] = copy;
+			copyChildren(copy, child_x, child_y, shift - 2);
+		}
+	};
+	copyChildren(&root, 0, 0, 14);
+
+	std::sort(list.begin(), list.end(), [](const RelayoutLeaf &a, const RelayoutLeaf &b) {
+		return a.key < b.key;
+	});
+
+	std::vector<QTreeNode*> sorted;
+	sorted.reserve(list.size());
+	for (const RelayoutLeaf &entry : list) {
+		QTreeNode* leaf = entry.parent->child[entry.index];
+		QTreeNode* copy = fresh.allocateNode(*this);
+		copy->parent = entry.parent;
+		copy->visible = leaf->visible;
+		copy->tile_count = leaf->tile_count;
+		copy->content_hash = leaf->content_hash;
+		copy->isLeaf = true;
+		std::copy(std::begin(leaf->array), std::end(leaf->array), std::begin(copy->array));
+		entry.parent->child[entry.index] = copy;
+		leaves.insert(entry.x, entry.y, copy);
+		sorted.push_back(copy);
+	}
+
+	for (int z = 0; z < rme::MapLayers; ++z) {
+		for (QTreeNode* leaf : sorted) {
+			if (Floor* floor = leaf->array[z]) {
+				Floor* copy = fresh.allocateFloor(floor->x, floor->y, z);
+				copy->adopt(*floor);
+				leaf->array[z] = copy;
+			}
+		}
+	}
+
+	// Everything now lives in fresh, the old arenas go away with it without
+	// running any destructors, their contents have all been moved out
+	allocator.swap(fresh);
+}
+
+void BaseMap::collectLeaves(std::vector<QTreeNode*> &list) {
+	// Same depth first order as MapIterator
+	std::vector<QTreeNode*> stack;
+	stack.push_back(&root);
+	while (!stack.empty()) {
+		QTreeNode* node = stack.back();
+		stack.pop_back();
+		if (node->isLeaf) {
+			list.push_back(node);
+			continue;
+		}
+
+		for (int i = rme::MapMaxLayer; i >= 0; --i) {
+			if (QTreeNode* child = node->child[i]) {
+				stack.push_back(child);
+			}
+		}
+	}
+}
+
+uint64_t BaseMap::getContentHash() {
+	if (root.content_hash != 0) {
+		return root.content_hash;
+	}
+
+	// Stale nodes always have stale parents, so the stale leaves are found
+	// without walking the clean parts of the tree
+	std::vector<QTreeNode*> stale;
+	std::vector<QTreeNode*> stack;
+	stack.push_back(&root);
+	while (!stack.empty()) {
+		QTreeNode* node = stack.back();
+		stack.pop_back();
+		if (node->isLeaf) {
+			stale.push_back(node);
+			continue;
+		}
+
+		for (QTreeNode* child : node->child) {
+			if (child && child->content_hash == 0 && child->tile_count > 0) {
+				stack.push_back(child);
+			}
+		}
+	}
+
+	// Tile hashing is where the time goes, the few inner nodes above are
+	// combined afterwards on this thread
+	constexpr size_t LeavesPerBlock = 256;
+	const size_t block_count = (stale.size() + LeavesPerBlock - 1) / LeavesPerBlock;
+	parallelForBlocks(block_count, [&](size_t block) {
+		const size_t last = std::min(stale.size(), (block + 1) * LeavesPerBlock);
+		for (size_t i = block * LeavesPerBlock; i < last; ++i) {
+			stale[i]->getContentHash();
+		}
+	});
+	return root.getContentHash();
+}
+
+void BaseMap::invalidateContentHash(int x, int y, int z) {
+	QTreeNode* leaf = leaves.find(x, y);
+	if (leaf && leaf->array[z]) {
+		leaf->invalidateContentHash(leaf->array[z]);
+	}
+}
+
+void BaseMap::invalidateContentHashes() {
+	std::vector<QTreeNode*> stack;
+	stack.push_back(&root);
+	while (!stack.empty()) {
+		QTreeNode* node = stack.back();
+		stack.pop_back();
+		node->content_hash = 0;
+		if (node->isLeaf) {
+			for (Floor* floor : node->array) {
+				if (floor) {
+					floor->content_hash = 0;
+				}
+			}
+			continue;
+		}
+
+		for (QTreeNode* child : node->child) {
+			if (child) {
+				stack.push_back(child);
+			}
+		}
+	}
+}
+
+void BaseMap::getChangedFloors(BaseMap &other, PositionVector &floors) {
+	if (getContentHash() == other.getContentHash()) {
+		return;
+	}
+
+	// Empty nodes and floors count as missing, same as when hashing
+	const auto getNode = [](QTreeNode* node, uint32_t index) -> QTreeNode* {
+		QTreeNode* child = node ? node->child[index] : nullptr;
+		return child && child->tile_count > 0 ? child : nullptr;
+	};
+	const auto getFloor = [](QTreeNode* leaf, uint32_t z) -> Floor* {
+		Floor* floor = leaf ? leaf->array[z] : nullptr;
+		return floor && floor->occupied ? floor : nullptr;
+	};
+
+	const std::function<void(QTreeNode*, QTreeNode*, uint32_t, uint32_t, uint32_t)> compareChildren = [&](QTreeNode* mine, QTreeNode* theirs, uint32_t x, uint32_t y, uint32_t shift) {
+		if (mine ? mine->isLeaf : theirs->isLeaf) {
+			for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+				Floor* my_floor = getFloor(mine, z);
+				Floor* their_floor = getFloor(theirs, z);
+				if (!my_floor && !their_floor) {
+					continue;
+				}
+				if (!my_floor || !their_floor || my_floor->getContentHash() != their_floor->getContentHash()) {
+					floors.push_back(Position(x, y, z));
+				}
+			}
+			return;
+		}
+
+		for (uint32_t i = 0; i < rme::MapLayers; ++i) {
+			QTreeNode* my_child = getNode(mine, i);
+			QTreeNode* their_child = getNode(theirs, i);
+			if (!my_child && !their_child) {
+				continue;
+			}
+			if (my_child && their_child && my_child->getContentHash() == their_child->getContentHash()) {
+				continue;
+			}
+
+			// Same layout as QTreeNode::getLeaf, x in the low and y in the high bits
+			const uint32_t child_x = x | ((i & 3) << shift);
+			const uint32_t child_y = y | ((i >> 2) << shift);
+			compareChildren(my_child, their_child, child_x, child_y, shift - 2);
+		}
+	};
+	compareChildren(&root, &other.root, 0, 0, 14);
+}
+
+void BaseMap::addFloorTile(int x, int y, int z) noexcept {
+	FloorExtent &extent = extents[z];
+	if (extent.tile_count++ == 0) {
+		extent.min_x = extent.max_x = x;
+		extent.min_y = extent.max_y = y;
+		extent.dirty = false;
+		return;
+	}
+
+	extent.min_x = std::min(extent.min_x, x);
+	extent.min_y = std::min(extent.min_y, y);
+	extent.max_x = std::max(extent.max_x, x);
+	extent.max_y = std::max(extent.max_y, y);
+}
+
+void BaseMap::removeFloorTile(int x, int y, int z) noexcept {
+	FloorExtent &extent = extents[z];
+	if (--extent.tile_count == 0) {
+		extent = FloorExtent();
+	} else if (x == extent.min_x || x == extent.max_x || y == extent.min_y || y == extent.max_y) {
+		extent.dirty = true;
+	}
+}
+
+bool BaseMap::getFloorBounds(int z, Position &from, Position &to) const {
+	FloorExtent &extent = extents[z];
+	if (extent.tile_count == 0) {
+		return false;
+	}
+
+	if (extent.dirty) {
+		// Only the occupancy masks are looked at, tiles are never touched
+		extent.min_x = extent.min_y = 0xFFFF;
+		extent.max_x = extent.max_y = 0;
+		std::vector<const QTreeNode*> stack;
+		stack.push_back(&root);
+		while (!stack.empty()) {
+			const QTreeNode* node = stack.back();
+			stack.pop_back();
+			if (!node->isLeaf) {
+				for (const QTreeNode* child : node->child) {
+					if (child && child->tile_count > 0) {
+						stack.push_back(child);
+					}
+				}
+				continue;
+			}
+
+			const Floor* floor = node->array[z];
+			if (!floor || floor->occupied == 0) {
+				continue;
+			}
+			for (uint16_t mask = floor->occupied; mask != 0; mask &= mask - 1) {
+				const int index = std::countr_zero(mask);
+				const int x = floor->x + (index >> 2);
+				const int y = floor->y + (index & 3);
+				extent.min_x = std::min(extent.min_x, x);
+				extent.min_y = std::min(extent.min_y, y);
+				extent.max_x = std::max(extent.max_x, x);
+				extent.max_y = std::max(extent.max_y, y);
+			}
+		}
+		extent.dirty = false;
+	}
+
+	from = Position(extent.min_x, extent.min_y, z);
+	to = Position(extent.max_x, extent.max_y, z);
+	return true;
+}
+
+bool BaseMap::getBounds(Position &from, Position &to) const {
+	bool found = false;
+	for (int z = rme::MapMinLayer; z <= rme::MapMaxLayer; ++z) {
+		Position floor_from, floor_to;
+		if (!getFloorBounds(z, floor_from, floor_to)) {
+			continue;
+		}
+
+		if (!found) {
+			from = floor_from;
+			to = floor_to;
+			found = true;
+			continue;
+		}
+		from.x = std::min(from.x, floor_from.x);
+		from.y = std::min(from.y, floor_from.y);
+		to.x = std::max(to.x, floor_to.x);
+		to.y = std::max(to.y, floor_to.y);
+		to.z = z;
+	}
+	return found;
+}
+
 Tile* BaseMap::createTile(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	TileLocation* loc = leaf->createTile(x, y, z);
 	if (loc->get()) {
 		return loc->get();
@@ -60,7 +436,7 @@ Tile* BaseMap::createTile(int x, int y, int z) {
 
 TileLocation* BaseMap::getTileL(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
-	QTreeNode* leaf = root.getLeaf(x, y);
+	QTreeNode* leaf = leaves.find(x, y);
 	if (leaf) {
 		Floor* floor = leaf->getFloor(z);
 		if (floor) {
@@ -87,7 +463,7 @@ const TileLocation* BaseMap::getTileL(const Position &pos) const {
 TileLocation* BaseMap::createTileL(int x, int y, int z) {
 	ASSERT(z < rme::MapLayers);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Floor* floor = leaf->createFloor(x, y, z);
 	uint32_t offsetX = x & 3;
 	uint32_t offsetY = y & 3;
@@ -104,11 +480,15 @@ void BaseMap::setTile(int x, int y, int z, Tile* new_tile, bool remove) {
 	ASSERT(!new_tile || new_tile->getY() == y);
 	ASSERT(!new_tile || new_tile->getZ() == z);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Tile* old_tile = leaf->setTile(x, y, z, new_tile);
 
-	if ((remove && old_tile) || new_tile) {
-		updateUniqueIds(remove ? old_tile : nullptr, new_tile);
+	if (old_tile && snapshot) {
+		snapshot->preserve(old_tile);
+	}
+	if (old_tile || new_tile) {
+		saved_blocks.forget(x, y);
+		updateTileIndexes(x, y, z, old_tile, new_tile);
 	}
 
 	if (remove) {
@@ -133,11 +513,15 @@ Tile* BaseMap::swapTile(int x, int y, int z, Tile* new_tile) {
 	ASSERT(!new_tile || new_tile->getY() == y);
 	ASSERT(!new_tile || new_tile->getZ() == z);
 
-	QTreeNode* leaf = root.getLeafForce(x, y);
+	QTreeNode* leaf = createLeaf(x, y);
 	Tile* old_tile = leaf->setTile(x, y, z, new_tile);
 
+	if (old_tile && snapshot) {
+		snapshot->preserve(old_tile);
+	}
 	if (old_tile || new_tile) {
-		updateUniqueIds(old_tile, new_tile);
+		saved_blocks.forget(x, y);
+		updateTileIndexes(x, y, z, old_tile, new_tile);
 	}
 
 	return old_tile;
@@ -179,42 +563,34 @@ MapIterator BaseMap::begin() {
 		MapIterator::NodeIndex &current = it.nodestack.back();
 		QTreeNode* node = current.node;
 		int &index = current.index;
-		// printf("Contemplating %p of %p (stack size %d)\n", node, this, it.nodestack.size());
 
 		bool unwind = false;
-		for (; index < 16; ++index) {
-			// printf("\tChecking index %d of %p\n", index, node);
-			if (QTreeNode* child = node->child[index]) {
-				if (child->isLeaf) {
-					QTreeNode* leaf = child;
-					// printf("\t%p is leaf\n", child);
-					for (it.local_z = 0; it.local_z < rme::MapLayers; ++it.local_z) {
-						if (Floor* floor = leaf->array[it.local_z]) {
-							for (it.local_i = 0; it.local_i < 16; ++it.local_i) {
-								// printf("\tit(%d;%d;%d)\n", it.local_x, it.local_y, it.local_z);
-								TileLocation &t = floor->locs[it.local_i];
-								if (t.get()) {
-									// printf("return it\n");
-									it.current_tile = &t;
-									return it;
-								}
-							}
-						}
+		for (; index < rme::MapLayers; ++index) {
+			QTreeNode* child = node->child[index];
+			// Empty subtrees are skipped without looking inside
+			if (!child || child->tile_count == 0) {
+				continue;
+			}
+
+			if (child->isLeaf) {
+				for (it.local_z = 0; it.local_z < rme::MapLayers; ++it.local_z) {
+					if (uint16_t occupied = child->getOccupancy(it.local_z)) {
+						it.local_i = std::countr_zero(occupied);
+						it.current_tile = &child->array[it.local_z]->locs[it.local_i];
+						return it;
 					}
-				} else {
-					// printf("\tAdding %p\n", child);
-					++index;
-					it.nodestack.push_back(MapIterator::NodeIndex(child));
-					unwind = true;
-					break;
 				}
+			} else {
+				++index;
+				it.nodestack.push_back(MapIterator::NodeIndex(child));
+				unwind = true;
+				break;
 			}
 		}
 		if (unwind) {
 			continue;
 		}
 
-		// printf("Discarding dead node %p\n", node);
 		it.nodestack.pop_back();
 		if (it.nodestack.empty()) {
 			break;
@@ -239,73 +615,48 @@ TileLocation* MapIterator::operator->() {
 }
 
 MapIterator &MapIterator::operator++() {
-	// printf("MapIterator::operator++");
-	bool increased = false;
-	bool first = true;
+	// local_z and local_i point at the current tile, only the locations after
+	// it are left on that leaf. Further leaves start over with local_i at -1.
 	while (true) {
 		MapIterator::NodeIndex &current = nodestack.back();
 		QTreeNode* node = current.node;
 		int &index = current.index;
-		// printf("Contemplating %p (stack size %d)\n", node, nodestack.size());
 
 		bool unwind = false;
 		for (; index < rme::MapLayers; ++index) {
-			// printf("\tChecking index %d of %p\n", index, node);
-			if (QTreeNode* child = node->child[index]) {
-				if (child->isLeaf) {
-					QTreeNode* leaf = child;
-					// printf("\t%p is leaf\n", child);
-					for (; local_z < rme::MapLayers; ++local_z) {
-						// printf("\t\tIterating over Z:%d of %p", local_z, child);
-						if (Floor* floor = leaf->array[local_z]) {
-							// printf("\n");
-							for (; local_i < rme::MapLayers; ++local_i) {
-								// printf("\t\tIterating over Y:%d of %p\n", local_y, child);
-								TileLocation &t = floor->locs[local_i];
-								if (t.get()) {
-									if (increased) {
-										// printf("Modified %p to %p\n", current_tile, t);
-										current_tile = &t;
-										return *this;
-									} else {
-										increased = true;
-									}
-								} else if (first) {
-									increased = true;
-									first = false;
-								}
-							}
-
-							if (local_i > rme::MapMaxLayer) {
-								// printf("\t\tReset local_x\n");
-								local_i = 0;
-							}
-						} else {
-							// printf(":dead floor\n");
-						}
-					}
-					if (local_z == rme::MapLayers) {
-						// printf("\t\tReset local_z\n");
-						local_z = 0;
+			QTreeNode* child = node->child[index];
+			if (!child || child->tile_count == 0) {
+				// Whatever is skipped lies after the current tile
+				local_z = 0;
+				local_i = -1;
+				continue;
+			}
+
+			if (child->isLeaf) {
+				for (; local_z < rme::MapLayers; ++local_z) {
+					const uint32_t remaining = child->getOccupancy(local_z) & (~0u << (local_i + 1));
+					if (remaining) {
+						local_i = std::countr_zero(remaining);
+						current_tile = &child->array[local_z]->locs[local_i];
+						return *this;
 					}
-				} else {
-					// printf("\tAdding %p\n", child);
-					++index;
-					nodestack.push_back(MapIterator::NodeIndex(child));
-					unwind = true;
-					break;
+					local_i = -1;
 				}
+				local_z = 0;
+			} else {
+				++index;
+				nodestack.push_back(MapIterator::NodeIndex(child));
+				unwind = true;
+				break;
 			}
 		}
 		if (unwind) {
 			continue;
 		}
 
-		// printf("Discarding dead node %p\n", node);
 		nodestack.pop_back();
 		if (nodestack.size() == 0) {
 			// Set all values to "end"
-			// printf("END\n");
 			local_z = -1;
 			local_i = -1;
 			return *this;
@@ -23,6 +23,11 @@
 #include "filehandle.h"
 #include "map_allocator.h"
 #include "tile.h"
+#include "map_snapshot.h"
+#include "saved_tile_blocks.h"
+#include "parallel_for.h"
+
+#include <bit>
 
 // Class declarations
 class QTreeNode;
@@ -83,6 +88,12 @@ private:
 	friend class BaseMap;
 };
 
+struct MapCompactionStats {
+	size_t floors = 0; // Floors freed
+	size_t nodes = 0; // Leaves and inner nodes freed
+	size_t bytes = 0; // Memory handed back to the map allocator
+};
+
 class BaseMap {
 public:
 	BaseMap();
@@ -111,12 +122,41 @@ public:
 
 	// Get a Quad Tree Leaf from the map
 	QTreeNode* getLeaf(int x, int y) {
-		return root.getLeaf(x, y);
+		return leaves.find(x, y);
 	}
 	QTreeNode* createLeaf(int x, int y) {
-		return root.getLeafForce(x, y);
+		QTreeNode* leaf = leaves.find(x, y);
+		return leaf ? leaf : root.getLeafForce(x, y);
 	}
 
+	// Area visitors, bounds are inclusive and floors go from min_z to max_z
+	// Only allocated leaves and floors are visited, empty 4x4 blocks are skipped.
+	// Calls func(TileLocation&), with create set missing floors are allocated first.
+	template <typename Func>
+	void forEachLocationInArea(int start_x, int start_y, int end_x, int end_y, int min_z, int max_z, Func &&func, bool create = false);
+	// Calls func(Tile*) for every tile in the area
+	template <typename Func>
+	void forEachTileInArea(int start_x, int start_y, int end_x, int end_y, int min_z, int max_z, Func &&func);
+	template <typename Func>
+	void forEachTileInArea(int start_x, int start_y, int end_x, int end_y, int min_z, int max_z, Func &&func) const;
+
+	// Parallel whole map traversal
+	// The leaves are cut into blocks in iteration order and spread over all
+	// threads. Each block folds its tiles into its own default constructed
+	// Accumulator through visit(Accumulator&, Tile*), the partial results are
+	// then merged into init in block order with merge(Accumulator&, Accumulator&),
+	// so the result is the same however many threads ran. visit must not
+	// modify the map structure.
+	// progress(done, total) is called on the calling thread only.
+	template <typename Accumulator, typename Visit, typename Merge>
+	Accumulator parallelForEachTile(Accumulator init, Visit &&visit, Merge &&merge, const std::function<void(size_t, size_t)> &progress = nullptr);
+	// Appends all leaves in iteration order
+	void collectLeaves(std::vector<QTreeNode*> &list);
+	// Calls func(Tile*) for every tile of the 64x64 block starting at x, y
+	// (all floors), in the same order as MapIterator
+	template <typename Func>
+	void forEachTileInBlock(int x, int y, Func &&func);
+
 	// Assigns a tile, it might seem pointless to provide position, but it is not, as the passed tile may be nullptr
 	void setTile(int x, int y, int z, Tile* new_tile, bool remove = false);
 	void setTile(const Position &position, Tile* new_tile, bool remove = false);
@@ -128,18 +168,100 @@ public:
 	// Clears the visiblity according to the mask passed
 	void clearVisible(uint32_t mask);
 
+	// Attaches a snapshot that tiles are preserved for before they change, see
+	// MapSnapshot. Only one at a time, nullptr detaches it again.
+	void setSnapshot(MapSnapshot* new_snapshot) noexcept {
+		snapshot = new_snapshot;
+	}
+	MapSnapshot* getSnapshot() const noexcept {
+		return snapshot;
+	}
+	// Has to be called before tiles on the map are changed in place rather
+	// than replaced through setTile / swapTile
+	void prepareTileChanges() {
+		if (snapshot) {
+			snapshot->preserveAll();
+		}
+		saved_blocks.forgetAll();
+	}
+	void prepareTileChange(const Tile* tile) {
+		if (snapshot) {
+			snapshot->preserve(tile);
+		}
+		saved_blocks.forget(tile->getX(), tile->getY());
+	}
+
+	SavedTileBlocks &getSavedTileBlocks() noexcept {
+		return saved_blocks;
+	}
+
+	// Frees every floor whose locations are all unused, then every node left
+	// without floors or children. Spawn and waypoint counts and house exits
+	// keep their floor alive, so do leaves a live client is watching.
+	// Detached tiles still point at their old location, nothing outside the
+	// map (undo history, selection) may hold on to one of its tiles.
+	// Does nothing while a snapshot is attached.
+	MapCompactionStats compact();
+	// Moves all nodes and floors into fresh memory, leaves in Morton (Z) order
+	// and floors grouped by z in that same order, so that neighbouring leaves
+	// end up next to each other in memory. Every Tile pointer stays valid but
+	// locations move, the same restrictions as for compact() apply.
+	void relayout();
+
 	uint64_t getTileCount() const noexcept {
 		return tilecount;
 	}
+	uint64_t getTileCount(int z) const noexcept {
+		return extents[z].tile_count;
+	}
+
+	// Per floor bounds, kept up to date as tiles are placed and removed
+	// Removing a tile on the edge only flags the floor, its bounds are then
+	// recomputed from the tree the next time they are asked for.
+	// Both return false if there are no tiles (on that floor).
+	bool getFloorBounds(int z, Position &from, Position &to) const;
+	bool getBounds(Position &from, Position &to) const;
+
+	// Merkle tree of content hashes over the quad tree
+	// Floors and nodes cache the hash of everything below them and replacing a
+	// tile marks its floor and the path to the root as stale, so rehashing
+	// after an edit only touches that path. Tiles modified in place have to be
+	// invalidated by hand. Hashes are only comparable within one process.
+	uint64_t getContentHash();
+	void invalidateContentHash(int x, int y, int z);
+	void invalidateContentHashes();
+	// Appends the first position of every 4x4 floor that differs from the
+	// same floor of other, only subtrees whose hashes differ are visited
+	void getChangedFloors(BaseMap &other, PositionVector &floors);
 
 public:
 	MapAllocator allocator;
 
 protected:
-	virtual void updateUniqueIds(Tile* old_tile, Tile* new_tile) { }
+	struct FloorExtent {
+		uint64_t tile_count = 0;
+		int min_x = 0, min_y = 0;
+		int max_x = -1, max_y = -1;
+		// A tile on the edge was removed, the bounds may be too large
+		bool dirty = false;
+	};
+
+	// Called by QTreeNode whenever a location gains or loses its tile
+	void addFloorTile(int x, int y, int z) noexcept;
+	void removeFloorTile(int x, int y, int z) noexcept;
+
+	// Called whenever the tile at x, y, z is replaced, either one may be nullptr
+	virtual void updateTileIndexes(int x, int y, int z, Tile* old_tile, Tile* new_tile) { }
+
+	// Returns true if node ended up empty, x/y is its first tile and shift selects its children
+	bool compactNode(QTreeNode* node, uint32_t x, uint32_t y, uint32_t shift, MapCompactionStats &stats);
 
 	uint64_t tilecount;
+	mutable FloorExtent extents[rme::MapLayers];
+	MapSnapshot* snapshot;
+	SavedTileBlocks saved_blocks;
 
+	QTreeLeafIndex leaves; // Direct lookup of the leaves in root
 	QTreeNode root; // The Quad Tree root
 
 	friend class QTreeNode;
@@ -165,4 +287,122 @@ inline const Tile* BaseMap::getTile(const Position &pos) const {
 	return l ? l->get() : nullptr;
 }
 
+template <typename Func>
+void BaseMap::forEachLocationInArea(int start_x, int start_y, int end_x, int end_y, int min_z, int max_z, Func &&func, bool create) {
+	start_x = std::max(start_x, 0);
+	start_y = std::max(start_y, 0);
+	end_x = std::min(end_x, 0xFFFF);
+	end_y = std::min(end_y, 0xFFFF);
+	min_z = std::max(min_z, 0);
+	max_z = std::min(max_z, rme::MapMaxLayer);
+
+	const auto visitLeaf = [&](QTreeNode* leaf, int leaf_x, int leaf_y) {
+		const int from_x = std::max(start_x, leaf_x);
+		const int to_x = std::min(end_x, leaf_x + 3);
+		const int from_y = std::max(start_y, leaf_y);
+		const int to_y = std::min(end_y, leaf_y + 3);
+		for (int z = min_z; z <= max_z; ++z) {
+			Floor* floor = create ? leaf->createFloor(leaf_x, leaf_y, z) : leaf->array[z];
+			if (!floor) {
+				continue;
+			}
+
+			for (int x = from_x; x <= to_x; ++x) {
+				for (int y = from_y; y <= to_y; ++y) {
+					func(floor->locs[(x & 3) * 4 + (y & 3)]);
+				}
+			}
+		}
+	};
+
+	if (create) {
+		for (int leaf_x = start_x & ~3; leaf_x <= end_x; leaf_x += 4) {
+			for (int leaf_y = start_y & ~3; leaf_y <= end_y; leaf_y += 4) {
+				visitLeaf(createLeaf(leaf_x, leaf_y), leaf_x, leaf_y);
+			}
+		}
+	} else {
+		leaves.forEachLeaf(start_x, start_y, end_x, end_y, visitLeaf);
+	}
+}
+
+template <typename Func>
+void BaseMap::forEachTileInArea(int start_x, int start_y, int end_x, int end_y, int min_z, int max_z, Func &&func) {
+	forEachLocationInArea(start_x, start_y, end_x, end_y, min_z, max_z, [&](TileLocation &location) {
+		if (Tile* tile = location.get()) {
+			func(tile);
+		}
+	});
+}
+
+template <typename Func>
+void BaseMap::forEachTileInArea(int start_x, int start_y, int end_x, int end_y, int min_z, int max_z, Func &&func) const {
+	// Don't create static const maps!
+	BaseMap* self = const_cast<BaseMap*>(this);
+	self->forEachTileInArea(start_x, start_y, end_x, end_y, min_z, max_z, [&](Tile* tile) {
+		func(static_cast<const Tile*>(tile));
+	});
+}
+
+template <typename Func>
+void BaseMap::forEachTileInBlock(int x, int y, Func &&func) {
+	QTreeNode* node = &root;
+	for (int shift = 14; shift >= 6 && node; shift -= 2) {
+		node = node->child[((x >> shift) & 3) | (((y >> shift) & 3) << 2)];
+	}
+	if (!node || node->tile_count == 0) {
+		return;
+	}
+
+	// Two levels of nodes below the block, then the leaves
+	for (QTreeNode* middle : node->child) {
+		if (!middle || middle->tile_count == 0) {
+			continue;
+		}
+		for (QTreeNode* leaf : middle->child) {
+			if (!leaf || leaf->tile_count == 0) {
+				continue;
+			}
+			for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+				for (uint32_t occupied = leaf->getOccupancy(z); occupied != 0; occupied &= occupied - 1) {
+					func(leaf->array[z]->locs[std::countr_zero(occupied)].get());
+				}
+			}
+		}
+	}
+}
+
+template <typename Accumulator, typename Visit, typename Merge>
+Accumulator BaseMap::parallelForEachTile(Accumulator init, Visit &&visit, Merge &&merge, const std::function<void(size_t, size_t)> &progress) {
+	// Enough leaves per block to hide the scheduling cost, and enough
+	// blocks to keep every thread busy until the end
+	constexpr size_t LeavesPerBlock = 256;
+
+	std::vector<QTreeNode*> list;
+	collectLeaves(list);
+
+	const size_t block_count = (list.size() + LeavesPerBlock - 1) / LeavesPerBlock;
+	std::vector<Accumulator> partials(block_count);
+	parallelForBlocks(block_count, [&](size_t block) {
+		Accumulator &partial = partials[block];
+		const size_t last = std::min(list.size(), (block + 1) * LeavesPerBlock);
+		for (size_t i = block * LeavesPerBlock; i < last; ++i) {
+			QTreeNode* leaf = list[i];
+			if (leaf->tile_count == 0) {
+				continue;
+			}
+			for (uint32_t z = 0; z < rme::MapLayers; ++z) {
+				for (uint32_t occupied = leaf->getOccupancy(z); occupied != 0; occupied &= occupied - 1) {
+					visit(partial, leaf->array[z]->locs[std::countr_zero(occupied)].get());
+				}
+			}
+		}
+	}, progress);
+
+	for (Accumulator &partial : partials) {
+		merge(init, partial);
+	}
+	return init;
+}
+
 #endif
@@ -113,7 +113,7 @@ void BrowseTileListBox::RemoveSelected() {
 
 void BrowseTileListBox::UpdateItems() {
 	int n = 0;
-	for (ItemVector::reverse_iterator it = edit_tile->items.rbegin(); it != edit_tile->items.rend(); ++it) {
+	for (TileItemVector::reverse_iterator it = edit_tile->items.rbegin(); it != edit_tile->items.rend(); ++it) {
 		items[n] = (*it);
 		++n;
 	}
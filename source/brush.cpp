@@ -441,7 +441,7 @@ bool DoorBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void DoorBrush::undraw(BaseMap* map, Tile* tile) {
-	for (ItemVector::iterator it = tile->items.begin(); it != tile->items.end(); ++it) {
+	for (TileItemVector::iterator it = tile->items.begin(); it != tile->items.end(); ++it) {
 		Item* item = *it;
 		if (item->isBrushDoor()) {
 			item->getWallBrush()->draw(map, tile, nullptr);
@@ -454,7 +454,7 @@ void DoorBrush::undraw(BaseMap* map, Tile* tile) {
 }
 
 void DoorBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
-	for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
+	for (TileItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
 		Item* item = *item_iter;
 		if (!item->isWall()) {
 			++item_iter;
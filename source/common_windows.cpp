@@ -211,24 +211,24 @@ struct MapConversionContext {
 	NpcMap npcType;
 
 	void operator()(Map &map, Tile* tile, long long done) {
-		if (tile->monster) {
-			MonsterMap::iterator f = monsterType.find(tile->monster->getName());
+		if (tile->getMonster()) {
+			MonsterMap::iterator f = monsterType.find(tile->getMonster()->getName());
 			if (f == monsterType.end()) {
 				MonsterInfo info = {
-					tile->monster->getName(),
-					tile->monster->getLookType()
+					tile->getMonster()->getName(),
+					tile->getMonster()->getLookType()
 				};
-				monsterType[tile->monster->getName()] = info;
+				monsterType[tile->getMonster()->getName()] = info;
 			}
 		}
-		if (tile->npc) {
-			NpcMap::iterator f = npcType.find(tile->npc->getName());
+		if (tile->getNpc()) {
+			NpcMap::iterator f = npcType.find(tile->getNpc()->getName());
 			if (f == npcType.end()) {
 				NpcInfo info = {
-					tile->npc->getName(),
-					tile->npc->getLookType()
+					tile->getNpc()->getName(),
+					tile->getNpc()->getLookType()
 				};
-				npcType[tile->npc->getName()] = info;
+				npcType[tile->getNpc()->getName()] = info;
 			}
 		}
 	}
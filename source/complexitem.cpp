@@ -20,6 +20,7 @@
 #include "complexitem.h"
 
 #include "iomap.h"
+#include "content_hash.h"
 
 // Container
 Container::Container(const uint16_t type) :
@@ -44,6 +45,14 @@ Item* Container::deepCopy() const {
 	return copy;
 }
 
+void Container::hashContent(ContentHasher &hasher) const {
+	Item::hashContent(hasher);
+	hasher.add(contents.size());
+	for (const Item* item : contents) {
+		item->hashContent(hasher);
+	}
+}
+
 Item* Container::getItem(size_t index) const {
 	if (index >= 0 && index < contents.size()) {
 		return contents.at(index);
@@ -66,6 +75,13 @@ Item* Teleport::deepCopy() const {
 	return copy;
 }
 
+void Teleport::hashContent(ContentHasher &hasher) const {
+	Item::hashContent(hasher);
+	hasher.add(destination.x);
+	hasher.add(destination.y);
+	hasher.add(destination.z);
+}
+
 // Door
 Door::Door(const uint16_t type) :
 	Item(type, 0),
@@ -81,6 +97,11 @@ Item* Door::deepCopy() const {
 	return copy;
 }
 
+void Door::hashContent(ContentHasher &hasher) const {
+	Item::hashContent(hasher);
+	hasher.add(doorId);
+}
+
 // Depot
 Depot::Depot(const uint16_t type) :
 	Item(type, 0),
@@ -95,3 +116,8 @@ Item* Depot::deepCopy() const {
 	}
 	return copy;
 }
+
+void Depot::hashContent(ContentHasher &hasher) const {
+	Item::hashContent(hasher);
+	hasher.add(depotId);
+}
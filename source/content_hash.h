@@ -0,0 +1,62 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_CONTENT_HASH_H
+#define RME_CONTENT_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Order dependent 64 bit hash of map content
+// Not meant to resist attacks, only to tell apart two versions of the same
+// tiles. The result is never 0, which marks a hash that needs recomputing.
+class ContentHasher {
+public:
+	void add(uint64_t value) noexcept {
+		state = mix((state + 0x9E3779B97F4A7C15ull) ^ value);
+	}
+	void add(const std::string &value) noexcept {
+		add(value.size());
+		const char* data = value.data();
+		size_t left = value.size();
+		while (left > 0) {
+			uint64_t word = 0;
+			const size_t chunk = left < sizeof(word) ? left : sizeof(word);
+			std::memcpy(&word, data, chunk);
+			add(word);
+			data += chunk;
+			left -= chunk;
+		}
+	}
+
+	uint64_t get() const noexcept {
+		return state != 0 ? state : 1;
+	}
+
+private:
+	// splitmix64 finalizer
+	static uint64_t mix(uint64_t value) noexcept {
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+		return value ^ (value >> 31);
+	}
+
+	uint64_t state = 0;
+};
+
+#endif
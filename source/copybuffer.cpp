@@ -71,7 +71,7 @@ void CopyBuffer::copy(Editor &editor, int floor) {
 		Tile* copied_tile = tiles->allocator(newlocation);
 
 		if (tile->ground && tile->ground->isSelected()) {
-			copied_tile->house_id = tile->house_id;
+			copied_tile->setHouseID(tile->getHouseID());
 			copied_tile->setMapFlags(tile->getMapFlags());
 		}
 
@@ -83,18 +83,18 @@ void CopyBuffer::copy(Editor &editor, int floor) {
 		}
 
 		// Monster
-		if (tile->monster && tile->monster->isSelected()) {
-			copied_tile->monster = tile->monster->deepCopy();
+		if (tile->getMonster() && tile->getMonster()->isSelected()) {
+			copied_tile->setMonster(tile->getMonster()->deepCopy());
 		}
-		if (tile->spawnMonster && tile->spawnMonster->isSelected()) {
-			copied_tile->spawnMonster = tile->spawnMonster->deepCopy();
+		if (tile->getSpawnMonster() && tile->getSpawnMonster()->isSelected()) {
+			copied_tile->setSpawnMonster(tile->getSpawnMonster()->deepCopy());
 		}
 		// Npc
-		if (tile->npc && tile->npc->isSelected()) {
-			copied_tile->npc = tile->npc->deepCopy();
+		if (tile->getNpc() && tile->getNpc()->isSelected()) {
+			copied_tile->setNpc(tile->getNpc()->deepCopy());
 		}
-		if (tile->spawnNpc && tile->spawnNpc->isSelected()) {
-			copied_tile->spawnNpc = tile->spawnNpc->deepCopy();
+		if (tile->getSpawnNpc() && tile->getSpawnNpc()->isSelected()) {
+			copied_tile->setSpawnNpc(tile->getSpawnNpc()->deepCopy());
 		}
 
 		tiles->setTile(copied_tile);
@@ -139,8 +139,8 @@ void CopyBuffer::cut(Editor &editor, int floor) {
 		Tile* copied_tile = tiles->allocator(tile->getLocation());
 
 		if (tile->ground && tile->ground->isSelected()) {
-			copied_tile->house_id = newtile->house_id;
-			newtile->house_id = 0;
+			copied_tile->setHouseID(newtile->getHouseID());
+			newtile->setHouseID(0);
 			copied_tile->setMapFlags(tile->getMapFlags());
 			newtile->setMapFlags(TILESTATE_NONE);
 		}
@@ -153,25 +153,25 @@ void CopyBuffer::cut(Editor &editor, int floor) {
 		}
 
 		// Monster
-		if (newtile->monster && newtile->monster->isSelected()) {
-			copied_tile->monster = newtile->monster;
-			newtile->monster = nullptr;
+		if (newtile->getMonster() && newtile->getMonster()->isSelected()) {
+			copied_tile->setMonster(newtile->getMonster());
+			newtile->setMonster(nullptr);
 		}
 
-		if (newtile->spawnMonster && newtile->spawnMonster->isSelected()) {
-			copied_tile->spawnMonster = newtile->spawnMonster;
-			newtile->spawnMonster = nullptr;
+		if (newtile->getSpawnMonster() && newtile->getSpawnMonster()->isSelected()) {
+			copied_tile->setSpawnMonster(newtile->getSpawnMonster());
+			newtile->setSpawnMonster(nullptr);
 		}
 
 		// Npc
-		if (newtile->npc && newtile->npc->isSelected()) {
-			copied_tile->npc = newtile->npc;
-			newtile->npc = nullptr;
+		if (newtile->getNpc() && newtile->getNpc()->isSelected()) {
+			copied_tile->setNpc(newtile->getNpc());
+			newtile->setNpc(nullptr);
 		}
 
-		if (newtile->spawnNpc && newtile->spawnNpc->isSelected()) {
-			copied_tile->spawnNpc = newtile->spawnNpc;
-			newtile->spawnNpc = nullptr;
+		if (newtile->getSpawnNpc() && newtile->getSpawnNpc()->isSelected()) {
+			copied_tile->setSpawnNpc(newtile->getSpawnNpc());
+			newtile->setSpawnNpc(nullptr);
 		}
 
 		tiles->setTile(copied_tile->getPosition(), copied_tile);
@@ -41,6 +41,8 @@
 #include "live_client.h"
 #include "live_action.h"
 
+#include <thread>
+
 Editor::Editor(CopyBuffer &copybuffer) :
 	live_server(nullptr),
 	live_client(nullptr),
@@ -159,6 +161,8 @@ Editor::Editor(CopyBuffer &copybuffer, LiveClient* client) :
 }
 
 Editor::~Editor() {
+	waitForSave();
+
 	if (IsLive()) {
 		CloseLiveServer();
 	}
@@ -255,17 +259,47 @@ void Editor::clearChanges() {
 	map.clearChanges();
 }
 
-void Editor::saveMap(FileName filename, bool showdialog) {
-	std::string savefile = filename.GetFullPath().mb_str(wxConvUTF8).data();
+// A save that is under way, outlives Editor::saveMap when the map is
+// written out on another thread
+struct EditorSaveJob {
+	std::string savefile;
+	std::string map_path;
 	bool save_as = false;
 	bool save_otgz = false;
 
+	// The auxilliary file names the map had when it was saved
+	std::string housefile;
+	std::string spawnmonsterfile;
+	std::string spawnnpcfile;
+	std::string zonefile;
+
+	// Temporary backups of the files being replaced
+	std::string backup_otbm;
+	std::string backup_house;
+	std::string backup_spawn;
+	std::string backup_spawn_npc;
+	std::string backup_zones;
+
+	std::unique_ptr<IOMapOTBM> saver;
+	std::unique_ptr<OTBMSaveSnapshot> snapshot;
+	std::thread thread;
+	bool success = false;
+};
+
+void Editor::saveMap(FileName filename, bool showdialog) {
+	// One save at a time, the backups of both would get mixed up
+	waitForSave();
+
+	std::shared_ptr<EditorSaveJob> job = std::make_shared<EditorSaveJob>();
+	std::string &savefile = job->savefile;
+	savefile = filename.GetFullPath().mb_str(wxConvUTF8).data();
+
 	if (savefile.empty()) {
 		savefile = map.filename;
 
 		FileName c1(wxstr(savefile));
 		FileName c2(wxstr(map.filename));
-		save_as = c1 != c2;
+		job->save_as = c1 != c2;
 	}
 
 	// If not named yet, propagate the file name to the auxilliary files
@@ -284,56 +318,57 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 
 		map.unnamed = false;
 	}
+	job->housefile = map.housefile;
+	job->spawnmonsterfile = map.spawnmonsterfile;
+	job->spawnnpcfile = map.spawnnpcfile;
+	job->zonefile = map.zonefile;
 
 	// File object to convert between local paths etc.
 	FileName converter;
 	converter.Assign(wxstr(savefile));
-	std::string map_path = nstr(converter.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME));
+	const std::string &map_path = job->map_path = nstr(converter.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME));
 
 	// Make temporary backups
-	// converter.Assign(wxstr(savefile));
-	std::string backup_otbm, backup_house, backup_spawn, backup_spawn_npc, backup_zones;
-
 	if (converter.GetExt() == "otgz") {
-		save_otgz = true;
+		job->save_otgz = true;
 		if (converter.FileExists()) {
-			backup_otbm = map_path + nstr(converter.GetName()) + ".otgz~";
-			std::remove(backup_otbm.c_str());
-			std::rename(savefile.c_str(), backup_otbm.c_str());
+			job->backup_otbm = map_path + nstr(converter.GetName()) + ".otgz~";
+			std::remove(job->backup_otbm.c_str());
+			std::rename(savefile.c_str(), job->backup_otbm.c_str());
 		}
 	} else {
 		if (converter.FileExists()) {
-			backup_otbm = map_path + nstr(converter.GetName()) + ".otbm~";
-			std::remove(backup_otbm.c_str());
-			std::rename(savefile.c_str(), backup_otbm.c_str());
+			job->backup_otbm = map_path + nstr(converter.GetName()) + ".otbm~";
+			std::remove(job->backup_otbm.c_str());
+			std::rename(savefile.c_str(), job->backup_otbm.c_str());
 		}
 
 		converter.SetFullName(wxstr(map.housefile));
 		if (converter.FileExists()) {
-			backup_house = map_path + nstr(converter.GetName()) + ".xml~";
-			std::remove(backup_house.c_str());
-			std::rename((map_path + map.housefile).c_str(), backup_house.c_str());
+			job->backup_house = map_path + nstr(converter.GetName()) + ".xml~";
+			std::remove(job->backup_house.c_str());
+			std::rename((map_path + map.housefile).c_str(), job->backup_house.c_str());
 		}
 
 		converter.SetFullName(wxstr(map.spawnmonsterfile));
 		if (converter.FileExists()) {
-			backup_spawn = map_path + nstr(converter.GetName()) + ".xml~";
-			std::remove(backup_spawn.c_str());
-			std::rename((map_path + map.spawnmonsterfile).c_str(), backup_spawn.c_str());
+			job->backup_spawn = map_path + nstr(converter.GetName()) + ".xml~";
+			std::remove(job->backup_spawn.c_str());
+			std::rename((map_path + map.spawnmonsterfile).c_str(), job->backup_spawn.c_str());
 		}
 
 		converter.SetFullName(wxstr(map.spawnnpcfile));
 		if (converter.FileExists()) {
-			backup_spawn_npc = map_path + nstr(converter.GetName()) + ".xml~";
-			std::remove(backup_spawn_npc.c_str());
-			std::rename((map_path + map.spawnnpcfile).c_str(), backup_spawn_npc.c_str());
+			job->backup_spawn_npc = map_path + nstr(converter.GetName()) + ".xml~";
+			std::remove(job->backup_spawn_npc.c_str());
+			std::rename((map_path + map.spawnnpcfile).c_str(), job->backup_spawn_npc.c_str());
 		}
 
 		converter.SetFullName(wxstr(map.zonefile));
 		if (converter.FileExists()) {
-			backup_zones = map_path + nstr(converter.GetName()) + ".xml~";
-			std::remove(backup_zones.c_str());
-			std::rename((map_path + map.zonefile).c_str(), backup_zones.c_str());
+			job->backup_zones = map_path + nstr(converter.GetName()) + ".xml~";
+			std::remove(job->backup_zones.c_str());
+			std::rename((map_path + map.zonefile).c_str(), job->backup_zones.c_str());
 		}
 	}
 
@@ -341,82 +376,150 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 	{
 		std::string n = nstr(g_gui.GetLocalDataDirectory()) + ".saving.txt";
 		std::ofstream f(n.c_str(), std::ios::trunc | std::ios::out);
-		f << backup_otbm << std::endl
-		  << backup_house << std::endl
-		  << backup_spawn << std::endl
-		  << backup_spawn_npc << std::endl;
+		f << job->backup_otbm << std::endl
+		  << job->backup_house << std::endl
+		  << job->backup_spawn << std::endl
+		  << job->backup_spawn_npc << std::endl;
+	}
+
+	// Set up the Map paths
+	wxFileName fn = wxstr(savefile);
+	map.filename = fn.GetFullPath().mb_str(wxConvUTF8);
+	map.name = fn.GetFullName().mb_str(wxConvUTF8);
+
+	job->saver.reset(newd IOMapOTBM(map.getVersion()));
+
+	// Compressed maps are written in one go
+	if (g_settings.getInteger(Config::SAVE_IN_BACKGROUND) && !job->save_otgz) {
+		// Everything but the tiles is put together right away, the tiles are
+		// kept as they are now while the map is written out
+		job->snapshot.reset(job->saver->takeSnapshot(map, fn));
+		map.setSnapshot(&job->snapshot->tiles);
+		clearChanges();
+		g_gui.SetStatusText("Saving map...");
+
+		save_job = job;
+		std::weak_ptr<EditorSaveJob> weak_job = job;
+		job->thread = std::thread([this, weak_job, raw_job = job.get()]() {
+			int last_done = -1;
+			raw_job->success = raw_job->saver->saveSnapshot(*raw_job->snapshot, [&last_done](int done) {
+				if (done != last_done) {
+					last_done = done;
+					wxTheApp->CallAfter([done]() {
+						g_gui.SetStatusText(wxString::Format("Saving map... %d%%", done));
+					});
+				}
+			});
+
+			// Dropped if the editor already waited for the save
+			wxTheApp->CallAfter([this, weak_job]() {
+				std::shared_ptr<EditorSaveJob> job = weak_job.lock();
+				if (job && job == save_job) {
+					waitForSave();
+				}
+			});
+		});
+		return;
 	}
 
-	{
+	if (showdialog) {
+		g_gui.CreateLoadBar("Saving OTBM map...");
+	}
 
-		// Set up the Map paths
-		wxFileName fn = wxstr(savefile);
-		map.filename = fn.GetFullPath().mb_str(wxConvUTF8);
-		map.name = fn.GetFullName().mb_str(wxConvUTF8);
+	// Perform the actual save
+	job->success = job->saver->saveMap(map, fn);
 
-		if (showdialog) {
-			g_gui.CreateLoadBar("Saving OTBM map...");
-		}
+	if (showdialog) {
+		g_gui.DestroyLoadBar();
+	}
 
-		// Perform the actual save
-		IOMapOTBM mapsaver(map.getVersion());
-		bool success = mapsaver.saveMap(map, fn);
+	finishSave(*job);
+	if (job->success) {
+		clearChanges();
+	}
+}
 
-		if (showdialog) {
-			g_gui.DestroyLoadBar();
-		}
+void Editor::waitForSave() {
+	if (!save_job) {
+		return;
+	}
 
-		// Check for errors...
-		if (!success) {
-			// Rename the temporary backup files back to their previous names
-			if (!backup_otbm.empty()) {
-				converter.SetFullName(wxstr(savefile));
-				std::string otbm_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_otbm.c_str(), std::string(otbm_filename + (save_otgz ? ".otgz" : ".otbm")).c_str());
-			}
+	std::shared_ptr<EditorSaveJob> job = std::move(save_job);
+	if (job->thread.joinable()) {
+		job->thread.join();
+	}
+	map.setSnapshot(nullptr);
+	// Lets go of the previous file first, it may be one of the backups removed below
+	job->saver->finishSnapshot(map, *job->snapshot, job->success);
+	job->snapshot.reset();
 
-			if (!backup_house.empty()) {
-				converter.SetFullName(wxstr(map.housefile));
-				std::string house_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_house.c_str(), std::string(house_filename + ".xml").c_str());
-			}
+	finishSave(*job);
+	if (job->success) {
+		g_gui.SetStatusText("Map saved.");
+	} else {
+		// The changes were cleared when the save started
+		map.doChange();
+		g_gui.SetStatusText("");
+	}
+	g_gui.UpdateTitle();
+}
 
-			if (!backup_spawn.empty()) {
-				converter.SetFullName(wxstr(map.spawnmonsterfile));
-				std::string spawn_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_spawn.c_str(), std::string(spawn_filename + ".xml").c_str());
-			}
+void Editor::finishSave(EditorSaveJob &job) {
+	const std::string &savefile = job.savefile;
+	const std::string &map_path = job.map_path;
+	FileName converter;
+	converter.Assign(wxstr(savefile));
 
-			if (!backup_spawn_npc.empty()) {
-				converter.SetFullName(wxstr(map.spawnnpcfile));
-				std::string spawnnpc_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_spawn_npc.c_str(), std::string(spawnnpc_filename + ".xml").c_str());
-			}
+	// Check for errors...
+	if (!job.success) {
+		// Rename the temporary backup files back to their previous names
+		if (!job.backup_otbm.empty()) {
+			converter.SetFullName(wxstr(savefile));
+			std::string otbm_filename = map_path + nstr(converter.GetName());
+			std::rename(job.backup_otbm.c_str(), std::string(otbm_filename + (job.save_otgz ? ".otgz" : ".otbm")).c_str());
+		}
 
-			if (!backup_zones.empty()) {
-				converter.SetFullName(wxstr(map.zonefile));
-				std::string zones_filename = map_path + nstr(converter.GetName());
-				std::rename(backup_zones.c_str(), std::string(zones_filename + ".xml").c_str());
-			}
+		if (!job.backup_house.empty()) {
+			converter.SetFullName(wxstr(job.housefile));
+			std::string house_filename = map_path + nstr(converter.GetName());
+			std::rename(job.backup_house.c_str(), std::string(house_filename + ".xml").c_str());
+		}
 
-			// Display the error
-			g_gui.PopupDialog("Error", "Could not save, unable to open target for writing.", wxOK);
+		if (!job.backup_spawn.empty()) {
+			converter.SetFullName(wxstr(job.spawnmonsterfile));
+			std::string spawn_filename = map_path + nstr(converter.GetName());
+			std::rename(job.backup_spawn.c_str(), std::string(spawn_filename + ".xml").c_str());
 		}
 
-		// Remove temporary save runfile
-		{
-			std::string n = nstr(g_gui.GetLocalDataDirectory()) + ".saving.txt";
-			std::remove(n.c_str());
+		if (!job.backup_spawn_npc.empty()) {
+			converter.SetFullName(wxstr(job.spawnnpcfile));
+			std::string spawnnpc_filename = map_path + nstr(converter.GetName());
+			std::rename(job.backup_spawn_npc.c_str(), std::string(spawnnpc_filename + ".xml").c_str());
 		}
 
-		// If failure, don't run the rest of the function
-		if (!success) {
-			return;
+		if (!job.backup_zones.empty()) {
+			converter.SetFullName(wxstr(job.zonefile));
+			std::string zones_filename = map_path + nstr(converter.GetName());
+			std::rename(job.backup_zones.c_str(), std::string(zones_filename + ".xml").c_str());
 		}
+
+		// Display the error
+		g_gui.PopupDialog("Error", "Could not save, unable to open target for writing.", wxOK);
+	}
+
+	// Remove temporary save runfile
+	{
+		std::string n = nstr(g_gui.GetLocalDataDirectory()) + ".saving.txt";
+		std::remove(n.c_str());
+	}
+
+	// If failure, don't run the rest of the function
+	if (!job.success) {
+		return;
 	}
 
 	// Move to permanent backup
-	if (!save_as && g_settings.getInteger(Config::ALWAYS_MAKE_BACKUP)) {
+	if (!job.save_as && g_settings.getInteger(Config::ALWAYS_MAKE_BACKUP)) {
 		std::string backup_path = map_path + "backups/";
 		ensureBackupDirectoryExists(backup_path);
 		// Move temporary backups to their proper files
@@ -437,45 +540,43 @@ void Editor::saveMap(FileName filename, bool showdialog) {
 		date << "-" << current_time->tm_min;
 		date << "-" << current_time->tm_sec;
 
-		if (!backup_otbm.empty()) {
+		if (!job.backup_otbm.empty()) {
 			converter.SetFullName(wxstr(savefile));
 			std::string otbm_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_otbm.c_str(), std::string(otbm_filename + "." + date.str() + (save_otgz ? ".otgz" : ".otbm")).c_str());
+			std::rename(job.backup_otbm.c_str(), std::string(otbm_filename + "." + date.str() + (job.save_otgz ? ".otgz" : ".otbm")).c_str());
 		}
 
-		if (!backup_house.empty()) {
-			converter.SetFullName(wxstr(map.housefile));
+		if (!job.backup_house.empty()) {
+			converter.SetFullName(wxstr(job.housefile));
 			std::string house_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_house.c_str(), std::string(house_filename + "." + date.str() + ".xml").c_str());
+			std::rename(job.backup_house.c_str(), std::string(house_filename + "." + date.str() + ".xml").c_str());
 		}
 
-		if (!backup_spawn.empty()) {
-			converter.SetFullName(wxstr(map.spawnmonsterfile));
+		if (!job.backup_spawn.empty()) {
+			converter.SetFullName(wxstr(job.spawnmonsterfile));
 			std::string spawn_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_spawn.c_str(), std::string(spawn_filename + "." + date.str() + ".xml").c_str());
+			std::rename(job.backup_spawn.c_str(), std::string(spawn_filename + "." + date.str() + ".xml").c_str());
 		}
 
-		if (!backup_spawn_npc.empty()) {
-			converter.SetFullName(wxstr(map.spawnnpcfile));
+		if (!job.backup_spawn_npc.empty()) {
+			converter.SetFullName(wxstr(job.spawnnpcfile));
 			std::string spawnnpc_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_spawn_npc.c_str(), std::string(spawnnpc_filename + "." + date.str() + ".xml").c_str());
+			std::rename(job.backup_spawn_npc.c_str(), std::string(spawnnpc_filename + "." + date.str() + ".xml").c_str());
 		}
 
-		if (!backup_zones.empty()) {
-			converter.SetFullName(wxstr(map.zonefile));
+		if (!job.backup_zones.empty()) {
+			converter.SetFullName(wxstr(job.zonefile));
 			std::string zones_filename = backup_path + nstr(converter.GetName());
-			std::rename(backup_zones.c_str(), std::string(zones_filename + "." + date.str() + ".xml").c_str());
+			std::rename(job.backup_zones.c_str(), std::string(zones_filename + "." + date.str() + ".xml").c_str());
 		}
 	} else {
 		// Delete the temporary files
-		std::remove(backup_otbm.c_str());
-		std::remove(backup_house.c_str());
-		std::remove(backup_spawn.c_str());
-		std::remove(backup_spawn_npc.c_str());
-		std::remove(backup_zones.c_str());
+		std::remove(job.backup_otbm.c_str());
+		std::remove(job.backup_house.c_str());
+		std::remove(job.backup_spawn.c_str());
+		std::remove(job.backup_spawn_npc.c_str());
+		std::remove(job.backup_zones.c_str());
 	}
-
-	clearChanges();
 }
 
 bool Editor::importMiniMap(FileName filename, int import, int import_x_offset, int import_y_offset, int import_z_offset) {
@@ -679,8 +780,8 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 				case IMPORT_MERGE: {
 					Tile* imported_tile = imported_map.getTile(oldSpawnMonsterPos);
 					if (imported_tile) {
-						ASSERT(imported_tile->spawnMonster);
-						spawn_monster_map[newSpawnMonsterPos] = imported_tile->spawnMonster;
+						ASSERT(imported_tile->getSpawnMonster());
+						spawn_monster_map[newSpawnMonsterPos] = imported_tile->getSpawnMonster();
 
 						SpawnNpcPositionList::iterator next = siter;
 						bool cont = true;
@@ -721,8 +822,8 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 				case IMPORT_MERGE: {
 					Tile* importedTile = imported_map.getTile(oldSpawnNpcPos);
 					if (importedTile) {
-						ASSERT(importedTile->spawnNpc);
-						spawn_npc_map[newSpawnNpcPos] = importedTile->spawnNpc;
+						ASSERT(importedTile->getSpawnNpc());
+						spawn_npc_map[newSpawnNpcPos] = importedTile->getSpawnNpc();
 
 						SpawnNpcPositionList::iterator next = siter;
 						bool cont = true;
@@ -757,6 +858,7 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 	}
 
 	map.waypoints.waypoints.insert(imported_map.waypoints.begin(), imported_map.waypoints.end());
+	map.waypoints.rebuildIndex();
 	imported_map.waypoints.waypoints.clear();
 
 	uint64_t tiles_merged = 0;
@@ -815,7 +917,7 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 		}
 
 		if (offset != Position(0, 0, 0)) {
-			for (ItemVector::iterator iter = import_tile->items.begin(); iter != import_tile->items.end(); ++iter) {
+			for (TileItemVector::iterator iter = import_tile->items.begin(); iter != import_tile->items.end(); ++iter) {
 				Item* item = *iter;
 				if (Teleport* teleport = dynamic_cast<Teleport*>(item)) {
 					teleport->setDestination(teleport->getDestination() + offset);
@@ -827,7 +929,7 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 		if (old_tile) {
 			map.removeSpawnMonster(old_tile);
 		}
-		import_tile->spawnMonster = nullptr;
+		import_tile->setSpawnMonster(nullptr);
 
 		map.setTile(new_pos, import_tile, true);
 	}
@@ -839,11 +941,13 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 		if (!tile) {
 			tile = map.allocator(location);
 			map.setTile(pos, tile);
-		} else if (tile->spawnMonster) {
+		} else if (tile->getSpawnMonster()) {
 			map.removeSpawnMonsterInternal(tile);
-			delete tile->spawnMonster;
+			delete tile->getSpawnMonster();
 		}
-		tile->spawnMonster = spawn_monster_iter->second;
+		map.beginCreatureChange(tile);
+		tile->setSpawnMonster(spawn_monster_iter->second);
+		map.endCreatureChange(tile);
 
 		map.addSpawnMonster(tile);
 	}
@@ -855,11 +959,13 @@ bool Editor::importMap(FileName filename, int import_x_offset, int import_y_offs
 		if (!tile) {
 			tile = map.allocator(location);
 			map.setTile(pos, tile);
-		} else if (tile->spawnNpc) {
+		} else if (tile->getSpawnNpc()) {
 			map.removeSpawnNpcInternal(tile);
-			delete tile->spawnNpc;
+			delete tile->getSpawnNpc();
 		}
-		tile->spawnNpc = spawn_npc_iter->second;
+		map.beginCreatureChange(tile);
+		tile->setSpawnNpc(spawn_npc_iter->second);
+		map.endCreatureChange(tile);
 
 		map.addSpawnNpc(tile);
 	}
@@ -894,6 +1000,7 @@ void Editor::borderizeSelection() {
 }
 
 void Editor::borderizeMap(bool showdialog) {
+	map.prepareTileChanges();
 	if (showdialog) {
 		g_gui.CreateLoadBar("Borderizing map...");
 	}
@@ -911,6 +1018,8 @@ void Editor::borderizeMap(bool showdialog) {
 		++tiles_done;
 	}
 
+	map.rebuildTileIndexes();
+
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
 	}
@@ -945,6 +1054,7 @@ void Editor::randomizeSelection() {
 }
 
 void Editor::randomizeMap(bool showdialog) {
+	map.prepareTileChanges();
 	if (showdialog) {
 		g_gui.CreateLoadBar("Randomizing map...");
 	}
@@ -982,12 +1092,15 @@ void Editor::randomizeMap(bool showdialog) {
 		++tiles_done;
 	}
 
+	map.rebuildTileIndexes();
+
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
 	}
 }
 
 void Editor::clearInvalidHouseTiles(bool showdialog) {
+	map.prepareTileChanges();
 	if (showdialog) {
 		g_gui.CreateLoadBar("Clearing invalid house tiles...");
 	}
@@ -1030,6 +1143,7 @@ void Editor::clearInvalidHouseTiles(bool showdialog) {
 		if (tile->isHouseTile()) {
 			if (houses.getHouse(tile->getHouseID()) == nullptr) {
 				tile->setHouse(nullptr);
+				map.invalidateContentHash(tile->getX(), tile->getY(), tile->getZ());
 			}
 		}
 		++tiles_done;
@@ -1087,29 +1201,29 @@ void Editor::moveSelection(const Position &offset) {
 		}
 
 		// Move monster spawns
-		if (new_tile->spawnMonster && new_tile->spawnMonster->isSelected()) {
-			storage_tile->spawnMonster = new_tile->spawnMonster;
-			new_tile->spawnMonster = nullptr;
+		if (new_tile->getSpawnMonster() && new_tile->getSpawnMonster()->isSelected()) {
+			storage_tile->setSpawnMonster(new_tile->getSpawnMonster());
+			new_tile->setSpawnMonster(nullptr);
 		}
 		// Move monster
-		if (new_tile->monster && new_tile->monster->isSelected()) {
-			storage_tile->monster = new_tile->monster;
-			new_tile->monster = nullptr;
+		if (new_tile->getMonster() && new_tile->getMonster()->isSelected()) {
+			storage_tile->setMonster(new_tile->getMonster());
+			new_tile->setMonster(nullptr);
 		}
 		// Move npc
-		if (new_tile->npc && new_tile->npc->isSelected()) {
-			storage_tile->npc = new_tile->npc;
-			new_tile->npc = nullptr;
+		if (new_tile->getNpc() && new_tile->getNpc()->isSelected()) {
+			storage_tile->setNpc(new_tile->getNpc());
+			new_tile->setNpc(nullptr);
 		}
 		// Move npc spawns
-		if (new_tile->spawnNpc && new_tile->spawnNpc->isSelected()) {
-			storage_tile->spawnNpc = new_tile->spawnNpc;
-			new_tile->spawnNpc = nullptr;
+		if (new_tile->getSpawnNpc() && new_tile->getSpawnNpc()->isSelected()) {
+			storage_tile->setSpawnNpc(new_tile->getSpawnNpc());
+			new_tile->setSpawnNpc(nullptr);
 		}
 
 		if (storage_tile->ground) {
-			storage_tile->house_id = new_tile->house_id;
-			new_tile->house_id = 0;
+			storage_tile->setHouseID(new_tile->getHouseID());
+			new_tile->setHouseID(0);
 			storage_tile->setMapFlags(new_tile->getMapFlags());
 			new_tile->setMapFlags(TILESTATE_NONE);
 			borderize = true;
@@ -1335,24 +1449,24 @@ void Editor::destroySelection() {
 				delete *iit;
 			}
 			// Monster
-			if (newtile->monster && newtile->monster->isSelected()) {
-				delete newtile->monster;
-				newtile->monster = nullptr;
+			if (newtile->getMonster() && newtile->getMonster()->isSelected()) {
+				delete newtile->getMonster();
+				newtile->setMonster(nullptr);
 			}
 
-			if (newtile->spawnMonster && newtile->spawnMonster->isSelected()) {
-				delete newtile->spawnMonster;
-				newtile->spawnMonster = nullptr;
+			if (newtile->getSpawnMonster() && newtile->getSpawnMonster()->isSelected()) {
+				delete newtile->getSpawnMonster();
+				newtile->setSpawnMonster(nullptr);
 			}
 			// Npc
-			if (newtile->npc && newtile->npc->isSelected()) {
-				delete newtile->npc;
-				newtile->npc = nullptr;
+			if (newtile->getNpc() && newtile->getNpc()->isSelected()) {
+				delete newtile->getNpc();
+				newtile->setNpc(nullptr);
 			}
 
-			if (newtile->spawnNpc && newtile->spawnNpc->isSelected()) {
-				delete newtile->spawnNpc;
-				newtile->spawnNpc = nullptr;
+			if (newtile->getSpawnNpc() && newtile->getSpawnNpc()->isSelected()) {
+				delete newtile->getSpawnNpc();
+				newtile->setSpawnNpc(nullptr);
 			}
 
 			if (g_settings.getInteger(Config::USE_AUTOMAGIC)) {
@@ -1476,7 +1590,7 @@ void Editor::drawInternal(Position offset, bool alt, bool dodraw) {
 				if (tile) {
 					bool place = true;
 					if (!doodad_brush->placeOnDuplicate() && !alt) {
-						for (ItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
+						for (TileItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
 							if (doodad_brush->ownsItem(*iter)) {
 								place = false;
 								break;
@@ -1501,7 +1615,7 @@ void Editor::drawInternal(Position offset, bool alt, bool dodraw) {
 				if (tile && !tile->isBlocking()) {
 					bool place = true;
 					if (!doodad_brush->placeOnDuplicate() && !alt) {
-						for (ItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
+						for (TileItemVector::const_iterator iter = tile->items.begin(); iter != tile->items.end(); ++iter) {
 							if (doodad_brush->ownsItem(*iter)) {
 								place = false;
 								break;
@@ -28,6 +28,7 @@
 
 class BaseMap;
 class CopyBuffer;
+struct EditorSaveJob;
 class LiveClient;
 class LiveServer;
 class LiveSocket;
@@ -76,6 +77,8 @@ public: // Functions
 
 	// Map handling
 	void saveMap(FileName filename, bool showdialog); // "" means default filename
+	// Blocks until a save running in the background is done
+	void waitForSave();
 
 	Map &getMap() noexcept {
 		return map;
@@ -160,10 +163,14 @@ protected:
 	Editor &operator=(const Editor &);
 
 private:
+	// Restores or keeps the backups once the files are written
+	void finishSave(EditorSaveJob &job);
+
 	friend class MapCanvas;
 	Map map;
 	Selection selection;
 	ActionQueue* actionQueue;
+	std::shared_ptr<EditorSaveJob> save_job;
 };
 
 inline void Editor::draw(const Position &offset, bool alt) {
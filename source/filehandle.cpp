@@ -19,6 +19,16 @@
 
 #include "filehandle.h"
 
+#ifdef __WINDOWS__
+	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
 uint8_t NodeFileWriteHandle::NODE_START = ::NODE_START;
 uint8_t NodeFileWriteHandle::NODE_END = ::NODE_END;
 uint8_t NodeFileWriteHandle::ESCAPE_CHAR = ::ESCAPE_CHAR;
@@ -142,6 +152,7 @@ bool FileReadHandle::getLongString(std::string &str) {
 
 NodeFileReadHandle::NodeFileReadHandle() :
 	last_was_start(false),
+	contiguous(false),
 	cache(nullptr),
 	cache_size(32768),
 	cache_length(0),
@@ -187,6 +198,7 @@ void MemoryNodeFileReadHandle::assign(const uint8_t* data, size_t size) {
 	root_node = nullptr;
 	// Highly volatile, but we know we're not gonna modify
 	cache = const_cast<uint8_t*>(data);
+	contiguous = true;
 	cache_size = cache_length = size;
 	local_read_index = 0;
 }
@@ -299,11 +311,132 @@ BinaryNode* DiskNodeFileReadHandle::getRootNode() {
 	}
 }
 
+//=============================================================================
+// Memory mapped node file read handle
+
+MappedNodeFileReadHandle::MappedNodeFileReadHandle(const std::string &name, const std::vector<std::string> &acceptable_identifiers) :
+	mapping(nullptr),
+	mapped_size(0) {
+#ifdef __WINDOWS__
+	mapping_handle = nullptr;
+	HANDLE handle = CreateFileW(string2wstring(name).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		error_code = FILE_COULD_NOT_OPEN;
+		return;
+	}
+	LARGE_INTEGER file_size;
+	if (GetFileSizeEx(handle, &file_size) && file_size.QuadPart >= 4) {
+		mapping_handle = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_handle) {
+			mapping = static_cast<uint8_t*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+			mapped_size = static_cast<size_t>(file_size.QuadPart);
+		}
+	}
+	CloseHandle(handle);
+#else
+	int descriptor = open(name.c_str(), O_RDONLY);
+	if (descriptor == -1) {
+		error_code = FILE_COULD_NOT_OPEN;
+		return;
+	}
+	struct stat file_stat;
+	if (fstat(descriptor, &file_stat) == 0 && file_stat.st_size >= 4) {
+		void* view = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+		if (view != MAP_FAILED) {
+			// The file is read front to back exactly once
+			madvise(view, file_stat.st_size, MADV_SEQUENTIAL);
+			mapping = static_cast<uint8_t*>(view);
+			mapped_size = file_stat.st_size;
+		}
+	}
+	::close(descriptor);
+#endif
+	if (!mapping) {
+		close();
+		error_code = FILE_COULD_NOT_OPEN;
+		return;
+	}
+
+	// 0x00 00 00 00 is accepted as a wildcard version
+	const char* ver = reinterpret_cast<const char*>(mapping);
+	if (ver[0] != 0 || ver[1] != 0 || ver[2] != 0 || ver[3] != 0) {
+		bool accepted = false;
+		for (const std::string &identifier : acceptable_identifiers) {
+			if (memcmp(ver, identifier.c_str(), 4) == 0) {
+				accepted = true;
+				break;
+			}
+		}
+
+		if (!accepted) {
+			close();
+			error_code = FILE_SYNTAX_ERROR;
+			return;
+		}
+	}
+
+	contiguous = true;
+	cache = mapping + 4;
+	cache_size = cache_length = mapped_size - 4;
+	local_read_index = 0;
+}
+
+MappedNodeFileReadHandle::~MappedNodeFileReadHandle() {
+	close();
+}
+
+void MappedNodeFileReadHandle::close() {
+	// Nodes may point into the mapping
+	freeNode(root_node);
+	root_node = nullptr;
+	if (mapping) {
+#ifdef __WINDOWS__
+		UnmapViewOfFile(mapping);
+#else
+		munmap(mapping, mapped_size);
+#endif
+		mapping = nullptr;
+	}
+#ifdef __WINDOWS__
+	if (mapping_handle) {
+		CloseHandle(mapping_handle);
+		mapping_handle = nullptr;
+	}
+#endif
+	cache = nullptr;
+	cache_size = cache_length = 0;
+	local_read_index = 0;
+	mapped_size = 0;
+}
+
+bool MappedNodeFileReadHandle::renewCache() {
+	return false;
+}
+
+BinaryNode* MappedNodeFileReadHandle::getRootNode() {
+	assert(root_node == nullptr); // You should never do this twice
+	if (local_read_index >= cache_length) {
+		error_code = FILE_READ_ERROR;
+		return nullptr;
+	}
+	if (cache[local_read_index++] != NODE_START) {
+		error_code = FILE_SYNTAX_ERROR;
+		return nullptr;
+	}
+	last_was_start = true;
+	root_node = getNode(nullptr);
+	root_node->load();
+	return root_node;
+}
+
 //=============================================================================
 // Binary file node
 
 BinaryNode::BinaryNode(NodeFileReadHandle* file, BinaryNode* parent) :
+	payload(nullptr),
+	payload_size(0),
 	read_offset(0),
+	node_begin(0),
 	file(file),
 	parent(parent),
 	child(nullptr) {
@@ -327,21 +460,21 @@ BinaryNode* BinaryNode::getChild() {
 }
 
 bool BinaryNode::getRAW(uint8_t* ptr, size_t sz) {
-	if (read_offset + sz > data.size()) {
-		read_offset = data.size();
+	if (read_offset + sz > payload_size) {
+		read_offset = payload_size;
 		return false;
 	}
-	memcpy(ptr, data.data() + read_offset, sz);
+	memcpy(ptr, payload + read_offset, sz);
 	read_offset += sz;
 	return true;
 }
 
 bool BinaryNode::getRAW(std::string &str, size_t sz) {
-	if (read_offset + sz > data.size()) {
-		read_offset = data.size();
+	if (read_offset + sz > payload_size) {
+		read_offset = payload_size;
 		return false;
 	}
-	str.assign(data.data() + read_offset, sz);
+	str.assign(reinterpret_cast<const char*>(payload) + read_offset, sz);
 	read_offset += sz;
 	return true;
 }
@@ -362,6 +495,42 @@ bool BinaryNode::getLongString(std::string &str) {
 	return getRAW(str, len);
 }
 
+bool BinaryNode::skipSubtree(const uint8_t*&begin, size_t &size) {
+	ASSERT(file);
+	if (!file->contiguous || child || file->error_code != FILE_NO_ERROR) {
+		return false;
+	}
+
+	const uint8_t* cache = file->cache;
+	const size_t cache_length = file->cache_length;
+	size_t index = file->local_read_index;
+	if (file->last_was_start) {
+		// Inside our first child, the subtree ends when we are closed too
+		size_t depth = 2;
+		while (depth > 0) {
+			if (index >= cache_length) {
+				file->error_code = FILE_PREMATURE_END;
+				return false;
+			}
+
+			const uint8_t op = cache[index++];
+			if (op == ESCAPE_CHAR) {
+				++index;
+			} else if (op == NODE_START) {
+				++depth;
+			} else if (op == NODE_END) {
+				--depth;
+			}
+		}
+	}
+
+	begin = cache + node_begin;
+	size = index - node_begin;
+	file->local_read_index = index;
+	file->last_was_start = false;
+	return true;
+}
+
 BinaryNode* BinaryNode::advance() {
 	// Advance this to the next position
 	ASSERT(file);
@@ -424,6 +593,46 @@ BinaryNode* BinaryNode::advance() {
 
 void BinaryNode::load() {
 	ASSERT(file);
+	uint8_t* cache = file->cache;
+	size_t &local_read_index = file->local_read_index;
+
+	if (file->contiguous) {
+		// Read until next node starts, as long as nothing is escaped the node
+		// is used right where it lies
+		node_begin = local_read_index - 1;
+		const uint8_t* start = cache + local_read_index;
+		const uint8_t* end = cache + file->cache_length;
+		const uint8_t* cursor = start;
+		while (cursor != end && *cursor < ESCAPE_CHAR) {
+			++cursor;
+		}
+
+		if (cursor == end) {
+			payload = start;
+			payload_size = cursor - start;
+			local_read_index = file->cache_length;
+			file->error_code = FILE_PREMATURE_END;
+			return;
+		}
+		if (*cursor != ESCAPE_CHAR) {
+			payload = start;
+			payload_size = cursor - start;
+			local_read_index = cursor - cache + 1;
+			file->last_was_start = *cursor == NODE_START;
+			return;
+		}
+
+		// Unescape the rest into our own buffer
+		data.assign(reinterpret_cast<const char*>(start), cursor - start);
+		local_read_index = cursor - cache;
+	}
+
+	loadEscaped();
+	payload = reinterpret_cast<const uint8_t*>(data.data());
+	payload_size = data.size();
+}
+
+void BinaryNode::loadEscaped() {
 	// Read until next node starts
 	uint8_t*&cache = file->cache;
 	size_t &cache_length = file->cache_length;
@@ -437,6 +646,17 @@ void BinaryNode::load() {
 			}
 		}
 
+		// Plain bytes are copied in runs
+		size_t run_end = local_read_index;
+		while (run_end < cache_length && cache[run_end] < ESCAPE_CHAR) {
+			++run_end;
+		}
+		data.append(reinterpret_cast<const char*>(cache) + local_read_index, run_end - local_read_index);
+		local_read_index = run_end;
+		if (local_read_index >= cache_length) {
+			continue;
+		}
+
 		uint8_t op = cache[local_read_index];
 		++local_read_index;
 
@@ -468,11 +688,95 @@ void BinaryNode::load() {
 			default:
 				break;
 		}
-		// std::cout << "Appending..." << std::endl;
 		data.append(1, op);
 	}
 }
 
+//=============================================================================
+// File range read handle
+
+FileRangeReadHandle::FileRangeReadHandle(const std::string &name) {
+#ifdef __WINDOWS__
+	handle = CreateFileW(string2wstring(name).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) {
+		handle = nullptr;
+	}
+#else
+	descriptor = open(name.c_str(), O_RDONLY);
+#endif
+}
+
+FileRangeReadHandle::~FileRangeReadHandle() {
+#ifdef __WINDOWS__
+	if (handle) {
+		CloseHandle(handle);
+	}
+#else
+	if (descriptor != -1) {
+		::close(descriptor);
+	}
+#endif
+}
+
+bool FileRangeReadHandle::isOpen() const {
+#ifdef __WINDOWS__
+	return handle != nullptr;
+#else
+	return descriptor != -1;
+#endif
+}
+
+bool FileRangeReadHandle::read(uint64_t offset, uint8_t* ptr, size_t sz) const {
+	if (!isOpen()) {
+		return false;
+	}
+
+	while (sz != 0) {
+#ifdef __WINDOWS__
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = static_cast<DWORD>(offset);
+		overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+		DWORD done = 0;
+		if (!ReadFile(handle, ptr, static_cast<DWORD>(std::min<size_t>(sz, 0x40000000)), &done, &overlapped) || done == 0) {
+			return false;
+		}
+#else
+		const ssize_t done = pread(descriptor, ptr, sz, static_cast<off_t>(offset));
+		if (done == -1 && errno == EINTR) {
+			continue;
+		}
+		if (done <= 0) {
+			return false;
+		}
+#endif
+		ptr += done;
+		offset += done;
+		sz -= done;
+	}
+	return true;
+}
+
+bool FileRangeReadHandle::isSameFile(const std::string &name) const {
+	if (!isOpen()) {
+		return false;
+	}
+
+#ifdef __WINDOWS__
+	HANDLE other = CreateFileW(string2wstring(name).c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (other == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	BY_HANDLE_FILE_INFORMATION lhs, rhs;
+	const bool same = GetFileInformationByHandle(handle, &lhs) && GetFileInformationByHandle(other, &rhs)
+		&& lhs.dwVolumeSerialNumber == rhs.dwVolumeSerialNumber && lhs.nFileIndexHigh == rhs.nFileIndexHigh && lhs.nFileIndexLow == rhs.nFileIndexLow;
+	CloseHandle(other);
+	return same;
+#else
+	struct stat lhs, rhs;
+	return fstat(descriptor, &lhs) == 0 && stat(name.c_str(), &rhs) == 0 && lhs.st_dev == rhs.st_dev && lhs.st_ino == rhs.st_ino;
+#endif
+}
+
 //=============================================================================
 // node file binary write handle
 
@@ -599,7 +903,7 @@ MemoryNodeFileWriteHandle::~MemoryNodeFileWriteHandle() {
 }
 
 void MemoryNodeFileWriteHandle::reset() {
-	memset(cache, 0xAA, cache_size);
+	// Keeps the memory around, nothing past the write index is ever read
 	local_write_index = 0;
 }
 
@@ -715,3 +1019,17 @@ bool NodeFileWriteHandle::addRAW(const uint8_t* ptr, size_t sz) {
 	writeBytes(ptr, sz);
 	return error_code == FILE_NO_ERROR;
 }
+
+bool NodeFileWriteHandle::addEncodedNodes(const uint8_t* ptr, size_t sz) {
+	while (sz != 0) {
+		const size_t chunk = std::min(sz, cache_size - local_write_index);
+		memcpy(cache + local_write_index, ptr, chunk);
+		local_write_index += chunk;
+		ptr += chunk;
+		sz -= chunk;
+		if (local_write_index >= cache_size) {
+			renewCache();
+		}
+	}
+	return error_code == FILE_NO_ERROR;
+}
@@ -124,6 +124,7 @@ protected:
 class NodeFileReadHandle;
 class DiskNodeFileReadHandle;
 class MemoryNodeFileReadHandle;
+class MappedNodeFileReadHandle;
 
 class BinaryNode {
 public:
@@ -146,8 +147,8 @@ public:
 		return getType(u64);
 	}
 	FORCEINLINE bool skip(size_t sz) {
-		if (read_offset + sz > data.size()) {
-			read_offset = data.size();
+		if (read_offset + sz > payload_size) {
+			read_offset = payload_size;
 			return false;
 		}
 		read_offset += sz;
@@ -162,28 +163,43 @@ public:
 	// Returns this on success, nullptr on failure
 	BinaryNode* advance();
 
+	// Steps over all children without loading them and hands out the raw
+	// bytes of this node, children included. Only works on handles holding
+	// the whole file and before any child was read. The bytes stay valid as
+	// long as the handle and can be read again with MemoryNodeFileReadHandle.
+	bool skipSubtree(const uint8_t*&begin, size_t &size);
+
 protected:
 	template <class T>
 	bool getType(T &ref) {
-		if (read_offset + sizeof(ref) > data.size()) {
-			read_offset = data.size();
+		if (read_offset + sizeof(ref) > payload_size) {
+			read_offset = payload_size;
 			return false;
 		}
-		ref = *(T*)(data.data() + read_offset);
+		memcpy(&ref, payload + read_offset, sizeof(ref));
 
 		read_offset += sizeof(ref);
 		return true;
 	}
 
 	void load();
+	void loadEscaped();
+
+	// The node's bytes, either straight in the handle's cache or, when
+	// escape bytes had to be removed, in data
+	const uint8_t* payload;
+	size_t payload_size;
 	std::string data;
 	size_t read_offset;
+	// Where the node starts in a contiguous handle's cache
+	size_t node_begin;
 	NodeFileReadHandle* file;
 	BinaryNode* parent;
 	BinaryNode* child;
 
 	friend class DiskNodeFileReadHandle;
 	friend class MemoryNodeFileReadHandle;
+	friend class MappedNodeFileReadHandle;
 };
 
 class NodeFileReadHandle : public FileHandle {
@@ -196,6 +212,14 @@ public:
 	virtual size_t size() = 0;
 	virtual size_t tell() = 0;
 
+	bool isContiguous() const {
+		return contiguous;
+	}
+	// Where a pointer into the cache of a contiguous handle lies in the file
+	virtual size_t getFileOffset(const uint8_t* ptr) const {
+		return ptr - cache;
+	}
+
 protected:
 	BinaryNode* getNode(BinaryNode* parent);
 	void freeNode(BinaryNode* node);
@@ -203,6 +227,9 @@ protected:
 	virtual bool renewCache() = 0;
 
 	bool last_was_start;
+	// The cache holds the whole file and outlives the nodes, so nodes may
+	// point into it instead of copying their bytes
+	bool contiguous;
 	uint8_t* cache;
 	size_t cache_size;
 	size_t cache_length;
@@ -266,6 +293,67 @@ protected:
 	uint8_t* index;
 };
 
+// Maps the whole file into memory
+// Nodes without escaped bytes are read in place, so loading a map barely
+// copies anything. Check isOk(), mapping may fail where plain reads work.
+class MappedNodeFileReadHandle : public NodeFileReadHandle {
+public:
+	MappedNodeFileReadHandle(const std::string &name, const std::vector<std::string> &acceptable_identifiers);
+	virtual ~MappedNodeFileReadHandle();
+
+	virtual void close();
+	virtual BinaryNode* getRootNode();
+
+	virtual size_t size() {
+		return mapped_size;
+	}
+	virtual size_t tell() {
+		return mapping ? local_read_index + 4 : 0;
+	}
+	virtual bool isOpen() {
+		return mapping != nullptr;
+	}
+	virtual bool isOk() {
+		return isOpen() && error_code == FILE_NO_ERROR;
+	}
+	virtual size_t getFileOffset(const uint8_t* ptr) const {
+		return ptr - mapping;
+	}
+
+protected:
+	virtual bool renewCache();
+
+	uint8_t* mapping;
+	size_t mapped_size;
+#ifdef __WINDOWS__
+	void* mapping_handle;
+#endif
+};
+
+// Reads pieces of a file at any offset, from any number of threads at once
+// The file stays readable while the handle is open, even after it has been
+// renamed or deleted, so a map can be saved over the file it is read from.
+class FileRangeReadHandle {
+public:
+	explicit FileRangeReadHandle(const std::string &name);
+	~FileRangeReadHandle();
+
+	FileRangeReadHandle(const FileRangeReadHandle &) = delete;
+	FileRangeReadHandle &operator=(const FileRangeReadHandle &) = delete;
+
+	bool isOpen() const;
+	bool read(uint64_t offset, uint8_t* ptr, size_t sz) const;
+	// True if the name refers to the open file, whatever it is called now
+	bool isSameFile(const std::string &name) const;
+
+private:
+#ifdef __WINDOWS__
+	void* handle;
+#else
+	int descriptor;
+#endif
+};
+
 class FileWriteHandle : public FileHandle {
 public:
 	explicit FileWriteHandle(const std::string &name);
@@ -324,6 +412,9 @@ public:
 	bool addRAW(const char* c) {
 		return addRAW(reinterpret_cast<const uint8_t*>(c), strlen(c));
 	}
+	// Appends complete nodes that are already escaped, like the memory of a
+	// MemoryNodeFileWriteHandle
+	bool addEncodedNodes(const uint8_t* ptr, size_t sz);
 
 protected:
 	virtual void renewCache() = 0;
@@ -90,10 +90,12 @@ House::House(Map &map) :
 }
 
 void House::clean() {
-	for (PositionList::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
-		Tile* tile = map->getTile(*pos_iter);
+	for (const Position &position : tiles) {
+		Tile* tile = map->getTile(position);
 		if (tile) {
+			map->prepareTileChange(tile);
 			tile->setHouse(nullptr);
+			map->invalidateContentHash(position.x, position.y, position.z);
 		}
 	}
 
@@ -105,39 +107,80 @@ void House::clean() {
 
 size_t House::size() const {
 	size_t count = 0;
-	for (PositionList::const_iterator pos_iter = tiles.begin(); pos_iter != tiles.end(); ++pos_iter) {
-		auto tile = map->getTile(*pos_iter);
-		auto topItem = tile->getTopItem();
-		if (tile && (!tile->getWall() || tile->getTable() || topItem->isDoor())) {
+	for (const Position &position : tiles) {
+		const Tile* tile = map->getTile(position);
+		if (tile && (!tile->getWall() || tile->getTable() || tile->getTopItem()->isDoor())) {
 			++count;
 		}
 	}
 	return count;
 }
 
+bool House::getBounds(Position &from, Position &to) const {
+	if (tiles.empty()) {
+		return false;
+	}
+
+	if (bounds_dirty) {
+		bounds_from = bounds_to = *tiles.begin();
+		for (const Position &position : tiles) {
+			bounds_from.x = std::min(bounds_from.x, position.x);
+			bounds_from.y = std::min(bounds_from.y, position.y);
+			bounds_from.z = std::min(bounds_from.z, position.z);
+			bounds_to.x = std::max(bounds_to.x, position.x);
+			bounds_to.y = std::max(bounds_to.y, position.y);
+			bounds_to.z = std::max(bounds_to.z, position.z);
+		}
+		bounds_dirty = false;
+	}
+
+	from = bounds_from;
+	to = bounds_to;
+	return true;
+}
+
 void House::addTile(Tile* tile) {
 	ASSERT(tile);
 	tile->setHouse(this);
-	tiles.push_back(tile->getPosition());
+
+	const Position position = tile->getPosition();
+	if (!tiles.insert(position).second || bounds_dirty) {
+		return;
+	}
+
+	if (tiles.size() == 1) {
+		bounds_from = bounds_to = position;
+		return;
+	}
+
+	bounds_from.x = std::min(bounds_from.x, position.x);
+	bounds_from.y = std::min(bounds_from.y, position.y);
+	bounds_from.z = std::min(bounds_from.z, position.z);
+	bounds_to.x = std::max(bounds_to.x, position.x);
+	bounds_to.y = std::max(bounds_to.y, position.y);
+	bounds_to.z = std::max(bounds_to.z, position.z);
 }
 
 void House::removeTile(Tile* tile) {
 	ASSERT(tile);
-	for (PositionList::iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
-		if (*tile_iter == tile->getPosition()) {
-			tiles.erase(tile_iter);
-			tile->setHouse(nullptr);
-			return;
-		}
+	const Position position = tile->getPosition();
+	if (tiles.erase(position) == 0) {
+		return;
+	}
+	tile->setHouse(nullptr);
+
+	if (position.x == bounds_from.x || position.y == bounds_from.y || position.z == bounds_from.z
+		|| position.x == bounds_to.x || position.y == bounds_to.y || position.z == bounds_to.z) {
+		bounds_dirty = true;
 	}
 }
 
 uint8_t House::getEmptyDoorID() const {
 	std::set<uint8_t> taken;
-	for (PositionList::const_iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
-		if (const Tile* tile = map->getTile(*tile_iter)) {
-			for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
-				if (Door* door = dynamic_cast<Door*>(*item_iter)) {
+	for (const Position &position : tiles) {
+		if (const Tile* tile = map->getTile(position)) {
+			for (const Item* item : tile->items.peek()) {
+				if (const Door* door = dynamic_cast<const Door*>(item)) {
 					taken.insert(door->getDoorID());
 				}
 			}
@@ -155,12 +198,12 @@ uint8_t House::getEmptyDoorID() const {
 }
 
 Position House::getDoorPositionByID(uint8_t id) const {
-	for (PositionList::const_iterator tile_iter = tiles.begin(); tile_iter != tiles.end(); ++tile_iter) {
-		if (const Tile* tile = map->getTile(*tile_iter)) {
-			for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
-				if (Door* door = dynamic_cast<Door*>(*item_iter)) {
+	for (const Position &position : tiles) {
+		if (const Tile* tile = map->getTile(position)) {
+			for (const Item* item : tile->items.peek()) {
+				if (const Door* door = dynamic_cast<const Door*>(item)) {
 					if (door->getDoorID() == id) {
-						return *tile_iter;
+						return position;
 					}
 				}
 			}
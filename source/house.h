@@ -20,6 +20,8 @@
 
 #include "position.h"
 
+#include <unordered_set>
+
 class Map;
 class Tile;
 class Door;
@@ -33,6 +35,16 @@ public:
 	void clean();
 	void addTile(Tile* tile);
 	void removeTile(Tile* tile);
+	bool hasTile(const Position &position) const {
+		return tiles.count(position) != 0;
+	}
+	// Number of tiles belonging to the house
+	size_t getTileCount() const noexcept {
+		return tiles.size();
+	}
+	// Bounding box of the house tiles, returns false if there are none
+	bool getBounds(Position &from, Position &to) const;
+	// Tiles a player can stand on (sqm)
 	size_t size() const;
 	std::string getDescription();
 
@@ -55,9 +67,14 @@ public:
 
 protected:
 	Map* map;
-	PositionList tiles;
+	std::unordered_set<Position> tiles;
 	Position exit;
 
+	// Only grown by addTile, removing a tile on the edge marks it for a recount
+	mutable Position bounds_from;
+	mutable Position bounds_to;
+	mutable bool bounds_dirty = false;
+
 	friend class Houses;
 };
 
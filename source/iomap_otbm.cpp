@@ -31,10 +31,30 @@
 #include "town.h"
 
 #include "iomap_otbm.h"
+#include "parallel_for.h"
 
 typedef uint8_t attribute_t;
 typedef uint32_t flags_t;
 
+// A tile decoded off the map, waiting to be put in place
+struct OTBMLoadedTile {
+	Position position;
+	Tile* tile;
+	uint32_t house_id;
+};
+
+// One OTBM_TILE_AREA node, its raw bytes and what was decoded from them
+struct OTBMTileArea {
+	const uint8_t* begin = nullptr;
+	size_t size = 0;
+	Position base;
+	std::vector<OTBMLoadedTile> tiles;
+	wxArrayString warnings;
+};
+
+// Blocks serialized before they are written out
+constexpr size_t OTBMSaveBlockWindow = 64;
+
 // H4X
 void reform(Map* map, Tile* tile, Item* item) {
 	/*
@@ -525,6 +545,8 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 					error("Could not load OTBM file inside archive");
 					return false;
 				}
+				// Nothing to copy blocks from when saving
+				map.getSavedTileBlocks().clear();
 
 				otbm_loaded = true;
 			} else if (entryName == "world/houses.xml") {
@@ -617,15 +639,31 @@ bool IOMapOTBM::loadMap(Map &map, const FileName &filename) {
 	}
 #endif
 
-	DiskNodeFileReadHandle f(nstr(filename.GetFullPath()), StringVector(1, "OTBM"));
-	if (!f.isOk()) {
-		error(("Couldn't open file for reading\nThe error reported was: " + wxstr(f.getErrorMessage())).wc_str());
+	// Nodes are read straight out of the mapped file, plain reads are only
+	// used when the file can't be mapped
+	std::unique_ptr<NodeFileReadHandle> f(newd MappedNodeFileReadHandle(nstr(filename.GetFullPath()), StringVector(1, "OTBM")));
+	if (f->error_code == FILE_COULD_NOT_OPEN) {
+		f.reset(newd DiskNodeFileReadHandle(nstr(filename.GetFullPath()), StringVector(1, "OTBM")));
+	}
+	if (!f->isOk()) {
+		error(("Couldn't open file for reading\nThe error reported was: " + wxstr(f->getErrorMessage())).wc_str());
 		return false;
 	}
 
-	if (!loadMap(map, f)) {
+	if (!loadMap(map, *f)) {
 		return false;
 	}
+	// Blocks found while loading are copied from the file from now on
+	std::shared_ptr<FileRangeReadHandle> source;
+	if (f->isContiguous()) {
+		source = std::make_shared<FileRangeReadHandle>(nstr(filename.GetFullPath()));
+	}
+	if (source && source->isOpen()) {
+		map.getSavedTileBlocks().setFile(std::move(source));
+	} else {
+		map.getSavedTileBlocks().clear();
+	}
+	f.reset();
 
 	// Read auxilliary files
 	if (!loadHouses(map, filename)) {
@@ -753,12 +791,21 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 		}
 	}
 
+	// With the whole file at hand tile areas are only located while walking
+	// the nodes, they are decoded on all threads afterwards and put on the
+	// map in file order so the result never depends on scheduling.
+	const bool parallel_areas = f.isContiguous();
+	std::vector<OTBMTileArea> tile_areas;
+	// Save blocks that can't be copied from this file
+	std::unordered_set<uint32_t> broken_blocks;
+
 	int nodes_loaded = 0;
 
 	for (BinaryNode* mapNode = mapHeaderNode->getChild(); mapNode != nullptr; mapNode = mapNode->advance()) {
 		++nodes_loaded;
 		if (nodes_loaded % 15 == 0) {
-			g_gui.SetLoadDone(static_cast<int32_t>(100.0 * f.tell() / f.size()));
+			const double done = double(f.tell()) / f.size();
+			g_gui.SetLoadDone(static_cast<int32_t>(parallel_areas ? 10.0 * done : 100.0 * done));
 		}
 
 		uint8_t node_type;
@@ -767,130 +814,16 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 			continue;
 		}
 		if (node_type == OTBM_TILE_AREA) {
-			uint16_t base_x, base_y;
-			uint8_t base_z;
-			if (!mapNode->getU16(base_x) || !mapNode->getU16(base_y) || !mapNode->getU8(base_z)) {
-				warning("Invalid map node, no base coordinate");
+			OTBMTileArea area;
+			if (parallel_areas && mapNode->skipSubtree(area.begin, area.size)) {
+				tile_areas.push_back(std::move(area));
 				continue;
 			}
-
-			for (BinaryNode* tileNode = mapNode->getChild(); tileNode != nullptr; tileNode = tileNode->advance()) {
-				Tile* tile = nullptr;
-				uint8_t tile_type;
-				if (!tileNode->getByte(tile_type)) {
-					warning("Invalid tile type");
-					continue;
-				}
-				if (tile_type == OTBM_TILE || tile_type == OTBM_HOUSETILE) {
-					// printf("Start\n");
-					uint8_t x_offset, y_offset;
-					if (!tileNode->getU8(x_offset) || !tileNode->getU8(y_offset)) {
-						warning("Could not read position of tile");
-						continue;
-					}
-					const Position pos(base_x + x_offset, base_y + y_offset, base_z);
-
-					if (map.getTile(pos)) {
-						warning("Duplicate tile at %d:%d:%d, discarding duplicate", pos.x, pos.y, pos.z);
-						continue;
-					}
-
-					tile = map.allocator(map.createTileL(pos));
-					House* house = nullptr;
-					if (tile_type == OTBM_HOUSETILE) {
-						uint32_t house_id;
-						if (!tileNode->getU32(house_id)) {
-							warning("House tile without house data, discarding tile");
-							delete tile;
-							continue;
-						}
-						if (house_id) {
-							house = map.houses.getHouse(house_id);
-							if (!house) {
-								house = newd House(map);
-								house->id = house_id;
-								map.houses.addHouse(house);
-							}
-						} else {
-							warning("Invalid house id from tile %d:%d:%d", pos.x, pos.y, pos.z);
-						}
-					}
-
-					// printf("So far so good\n");
-
-					uint8_t attribute;
-					while (tileNode->getU8(attribute)) {
-						switch (attribute) {
-							case OTBM_ATTR_TILE_FLAGS: {
-								uint32_t flags = 0;
-								if (!tileNode->getU32(flags)) {
-									warning("Invalid tile flags of tile on %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								tile->setMapFlags(flags);
-								break;
-							}
-							case OTBM_ATTR_ITEM: {
-								Item* item = Item::Create_OTBM(*this, tileNode);
-								if (item == nullptr) {
-									warning("Invalid item at tile %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								tile->addItem(item);
-								break;
-							}
-							default: {
-								warning("Unknown tile attribute at %d:%d:%d", pos.x, pos.y, pos.z);
-								break;
-							}
-						}
-					}
-
-					// printf("Didn't die in loop\n");
-
-					for (BinaryNode* childNode = tileNode->getChild(); childNode != nullptr; childNode = childNode->advance()) {
-						Item* item = nullptr;
-						uint8_t node_type;
-						if (!childNode->getByte(node_type)) {
-							warning("Unknown item type %d:%d:%d", pos.x, pos.y, pos.z);
-							continue;
-						}
-						if (node_type == OTBM_ITEM) {
-							item = Item::Create_OTBM(*this, childNode);
-							if (item) {
-								if (!item->unserializeItemNode_OTBM(*this, childNode)) {
-									warning("Couldn't unserialize item attributes at %d:%d:%d", pos.x, pos.y, pos.z);
-								}
-								// reform(&map, tile, item);
-								tile->addItem(item);
-							}
-						} else if (node_type == OTBM_TILE_ZONE) {
-							uint16_t zone_count;
-							if (!childNode->getU16(zone_count)) {
-								warning("Invalid zone count at %d:%d:%d", pos.x, pos.y, pos.z);
-								continue;
-							}
-							for (uint16_t i = 0; i < zone_count; ++i) {
-								uint16_t zone_id;
-								if (!childNode->getU16(zone_id)) {
-									warning("Invalid zone id at %d:%d:%d", pos.x, pos.y, pos.z);
-									continue;
-								}
-								tile->addZone(zone_id);
-							}
-						} else {
-							warning("Unknown type of tile child node");
-						}
-					}
-
-					tile->update();
-					if (house) {
-						house->addTile(tile);
-					}
-
-					map.setTile(pos.x, pos.y, pos.z, tile);
-				} else {
-					warning("Unknown type of tile node");
-				}
+			decodeTileArea(mapNode, area);
+			for (const OTBMLoadedTile &loaded : area.tiles) {
+				broken_blocks.insert(SavedTileBlocks::getBlockKey(loaded.position));
 			}
+			mergeTileArea(map, area);
 		} else if (node_type == OTBM_TOWNS) {
 			for (BinaryNode* townNode = mapNode->getChild(); townNode != nullptr; townNode = townNode->advance()) {
 				Town* town = nullptr;
@@ -973,12 +906,244 @@ bool IOMapOTBM::loadMap(Map &map, NodeFileReadHandle &f) {
 		}
 	}
 
+	parallelForBlocks(
+		tile_areas.size(),
+		[this, &tile_areas](size_t index) {
+			OTBMTileArea &area = tile_areas[index];
+			MemoryNodeFileReadHandle handle(area.begin, area.size);
+			BinaryNode* areaNode = handle.getRootNode();
+			if (areaNode && areaNode->skip(1)) { // Skip the type byte
+				decodeTileArea(areaNode, area);
+			}
+		},
+		[](size_t done, size_t count) {
+			g_gui.SetLoadDone(static_cast<int32_t>(10 + 80 * done / count));
+		}
+	);
+
+	// Tile areas laid out the way they are saved are grouped into blocks,
+	// which are copied as they are when the map is saved again, see
+	// SavedTileBlocks. Areas out of order, split where a save would not split
+	// them or with anything off about their tiles leave their squares out.
+	std::vector<SavedTileBlocks::Block> loaded_blocks;
+	SavedTileBlocks::Block block;
+	bool in_block = false;
+	bool block_broken = false;
+	bool seen_tiles = false;
+	uint64_t last_key = 0;
+	Position last_base(-1, -1, -1);
+	const auto endBlock = [&]() {
+		if (in_block && !block_broken) {
+			loaded_blocks.push_back(block);
+		}
+		in_block = false;
+	};
+
+	for (size_t index = 0; index < tile_areas.size(); ++index) {
+		if (index % 64 == 0) {
+			g_gui.SetLoadDone(static_cast<int32_t>(90 + 10 * index / tile_areas.size()));
+		}
+
+		OTBMTileArea &area = tile_areas[index];
+		if (area.tiles.empty()) {
+			mergeTileArea(map, area);
+			continue;
+		}
+
+		bool canonical = (area.base.x & 0xFF) == 0 && (area.base.y & 0xFF) == 0 && area.base != last_base;
+		for (const OTBMLoadedTile &loaded : area.tiles) {
+			const uint64_t key = MapSnapshot::getIterationKey(loaded.position);
+			if (seen_tiles && key <= last_key) {
+				canonical = false;
+			}
+			seen_tiles = true;
+			last_key = std::max(last_key, key);
+		}
+		last_base = area.base;
+
+		const Position first = area.tiles.front().position;
+		const Position last = area.tiles.back().position;
+		const uint32_t tile_count = area.tiles.size();
+		const uint64_t offset = f.getFileOffset(area.begin);
+		if (!in_block || SavedTileBlocks::getBlockKey(first) != SavedTileBlocks::getBlockKey(block.first)) {
+			endBlock();
+			in_block = true;
+			block_broken = false;
+			block = { first, last, tile_count, { offset, area.size } };
+		} else {
+			block_broken |= block.range.offset + block.range.size != offset;
+			block.last = last;
+			block.tile_count += tile_count;
+			block.range.size += area.size;
+		}
+
+		if (!canonical) {
+			for (const OTBMLoadedTile &loaded : area.tiles) {
+				broken_blocks.insert(SavedTileBlocks::getBlockKey(loaded.position));
+			}
+		}
+		if (!mergeTileArea(map, area) || !canonical) {
+			block_broken = true;
+		}
+	}
+	endBlock();
+
+	SavedTileBlocks &saved_blocks = map.getSavedTileBlocks();
+	saved_blocks.reset(nullptr, getTileFormat());
+	for (const SavedTileBlocks::Block &loaded_block : loaded_blocks) {
+		saved_blocks.add(loaded_block);
+	}
+	for (uint32_t key : broken_blocks) {
+		saved_blocks.forgetBlock(key);
+	}
+
 	if (!f.isOk()) {
 		warning(wxstr(f.getErrorMessage()).wc_str());
 	}
 	return true;
 }
 
+void IOMapOTBM::decodeTileArea(BinaryNode* areaNode, OTBMTileArea &area) const {
+	uint16_t base_x, base_y;
+	uint8_t base_z;
+	if (!areaNode->getU16(base_x) || !areaNode->getU16(base_y) || !areaNode->getU8(base_z)) {
+		area.warnings.push_back("Invalid map node, no base coordinate");
+		return;
+	}
+	area.base = Position(base_x, base_y, base_z);
+
+	for (BinaryNode* tileNode = areaNode->getChild(); tileNode != nullptr; tileNode = tileNode->advance()) {
+		uint8_t tile_type;
+		if (!tileNode->getByte(tile_type)) {
+			area.warnings.push_back("Invalid tile type");
+			continue;
+		}
+		if (tile_type != OTBM_TILE && tile_type != OTBM_HOUSETILE) {
+			area.warnings.push_back("Unknown type of tile node");
+			continue;
+		}
+
+		uint8_t x_offset, y_offset;
+		if (!tileNode->getU8(x_offset) || !tileNode->getU8(y_offset)) {
+			area.warnings.push_back("Could not read position of tile");
+			continue;
+		}
+		const Position pos(base_x + x_offset, base_y + y_offset, base_z);
+
+		uint32_t house_id = 0;
+		if (tile_type == OTBM_HOUSETILE) {
+			if (!tileNode->getU32(house_id)) {
+				area.warnings.push_back("House tile without house data, discarding tile");
+				continue;
+			}
+			if (!house_id) {
+				area.warnings.push_back(wxString::Format("Invalid house id from tile %d:%d:%d", pos.x, pos.y, pos.z));
+			}
+		}
+
+		// The tile gets its location once it is put on the map
+		Tile* tile = newd Tile(pos.x, pos.y, pos.z);
+
+		uint8_t attribute;
+		while (tileNode->getU8(attribute)) {
+			switch (attribute) {
+				case OTBM_ATTR_TILE_FLAGS: {
+					uint32_t flags = 0;
+					if (!tileNode->getU32(flags)) {
+						area.warnings.push_back(wxString::Format("Invalid tile flags of tile on %d:%d:%d", pos.x, pos.y, pos.z));
+					}
+					tile->setMapFlags(flags);
+					break;
+				}
+				case OTBM_ATTR_ITEM: {
+					Item* item = Item::Create_OTBM(*this, tileNode);
+					if (item == nullptr) {
+						area.warnings.push_back(wxString::Format("Invalid item at tile %d:%d:%d", pos.x, pos.y, pos.z));
+					}
+					tile->addItem(item);
+					break;
+				}
+				default: {
+					area.warnings.push_back(wxString::Format("Unknown tile attribute at %d:%d:%d", pos.x, pos.y, pos.z));
+					break;
+				}
+			}
+		}
+
+		for (BinaryNode* childNode = tileNode->getChild(); childNode != nullptr; childNode = childNode->advance()) {
+			Item* item = nullptr;
+			uint8_t node_type;
+			if (!childNode->getByte(node_type)) {
+				area.warnings.push_back(wxString::Format("Unknown item type %d:%d:%d", pos.x, pos.y, pos.z));
+				continue;
+			}
+			if (node_type == OTBM_ITEM) {
+				item = Item::Create_OTBM(*this, childNode);
+				if (item) {
+					if (!item->unserializeItemNode_OTBM(*this, childNode)) {
+						area.warnings.push_back(wxString::Format("Couldn't unserialize item attributes at %d:%d:%d", pos.x, pos.y, pos.z));
+					}
+					tile->addItem(item);
+				}
+			} else if (node_type == OTBM_TILE_ZONE) {
+				uint16_t zone_count;
+				if (!childNode->getU16(zone_count)) {
+					area.warnings.push_back(wxString::Format("Invalid zone count at %d:%d:%d", pos.x, pos.y, pos.z));
+					continue;
+				}
+				for (uint16_t i = 0; i < zone_count; ++i) {
+					uint16_t zone_id;
+					if (!childNode->getU16(zone_id)) {
+						area.warnings.push_back(wxString::Format("Invalid zone id at %d:%d:%d", pos.x, pos.y, pos.z));
+						continue;
+					}
+					tile->addZone(zone_id);
+				}
+			} else {
+				area.warnings.push_back("Unknown type of tile child node");
+			}
+		}
+
+		// Nothing points to the items yet, plain ones can go into their slots
+		tile->packItems();
+		tile->update();
+		area.tiles.push_back({ pos, tile, house_id });
+	}
+}
+
+bool IOMapOTBM::mergeTileArea(Map &map, OTBMTileArea &area) {
+	bool merged = area.warnings.empty();
+	for (const wxString &message : area.warnings) {
+		warnings.push_back(message);
+	}
+
+	for (const OTBMLoadedTile &loaded : area.tiles) {
+		const Position &pos = loaded.position;
+		Tile* tile = loaded.tile;
+		if (map.getTile(pos)) {
+			warning("Duplicate tile at %d:%d:%d, discarding duplicate", pos.x, pos.y, pos.z);
+			delete tile;
+			merged = false;
+			continue;
+		}
+
+		tile->setLocation(map.createTileL(pos));
+		if (loaded.house_id) {
+			House* house = map.houses.getHouse(loaded.house_id);
+			if (!house) {
+				house = newd House(map);
+				house->id = loaded.house_id;
+				map.houses.addHouse(house);
+			}
+			house->addTile(tile);
+		}
+		map.setTile(pos.x, pos.y, pos.z, tile);
+	}
+	area.tiles.clear();
+	area.warnings.clear();
+	return merged;
+}
+
 bool IOMapOTBM::loadSpawnsMonster(Map &map, const FileName &dir) {
 	std::string fn = (const char*)(dir.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME).mb_str(wxConvUTF8));
 	fn += map.spawnmonsterfile;
@@ -1025,7 +1190,7 @@ bool IOMapOTBM::loadSpawnsMonster(Map &map, pugi::xml_document &doc) {
 		}
 
 		Tile* tile = map.getTile(spawnPosition);
-		if (tile && tile->spawnMonster) {
+		if (tile && tile->getSpawnMonster()) {
 			warning("Duplicate monster spawn on position %d:%d:%d\n", tile->getX(), tile->getY(), tile->getZ());
 			continue;
 		}
@@ -1036,7 +1201,9 @@ bool IOMapOTBM::loadSpawnsMonster(Map &map, pugi::xml_document &doc) {
 			map.setTile(spawnPosition, tile);
 		}
 
-		tile->spawnMonster = spawnMonster;
+		map.beginCreatureChange(tile);
+		tile->setSpawnMonster(spawnMonster);
+		map.endCreatureChange(tile);
 		map.addSpawnMonster(tile);
 
 		for (pugi::xml_node monsterNode = spawnNode.first_child(); monsterNode; monsterNode = monsterNode.next_sibling()) {
@@ -1096,7 +1263,7 @@ bool IOMapOTBM::loadSpawnsMonster(Map &map, pugi::xml_document &doc) {
 				break;
 			}
 
-			if (monsterTile->monster) {
+			if (monsterTile->getMonster()) {
 				wxString err;
 				err << "Duplicate monster \"" << name << "\" at " << monsterPosition.x << ":" << monsterPosition.y << ":" << monsterPosition.z << " was discarded.";
 				warnings.Add(err);
@@ -1111,15 +1278,17 @@ bool IOMapOTBM::loadSpawnsMonster(Map &map, pugi::xml_document &doc) {
 			Monster* monster = newd Monster(type);
 			monster->setDirection(direction);
 			monster->setSpawnMonsterTime(spawntime);
-			monsterTile->monster = monster;
+			map.beginCreatureChange(monsterTile);
+			monsterTile->setMonster(monster);
 
 			if (monsterTile->getLocation()->getSpawnMonsterCount() == 0) {
 				// No monster spawn, create a newd one
-				ASSERT(monsterTile->spawnMonster == nullptr);
+				ASSERT(monsterTile->getSpawnMonster() == nullptr);
 				SpawnMonster* spawnMonster = newd SpawnMonster(1);
-				monsterTile->spawnMonster = spawnMonster;
+				monsterTile->setSpawnMonster(spawnMonster);
 				map.addSpawnMonster(monsterTile);
 			}
+			map.endCreatureChange(monsterTile);
 		}
 	}
 	return true;
@@ -1290,7 +1459,7 @@ bool IOMapOTBM::loadSpawnsNpc(Map &map, pugi::xml_document &doc) {
 		}
 
 		Tile* spawnTile = map.getTile(spawnPosition);
-		if (spawnTile && spawnTile->spawnNpc) {
+		if (spawnTile && spawnTile->getSpawnNpc()) {
 			warning("Duplicate npc spawn on position %d:%d:%d\n", spawnTile->getX(), spawnTile->getY(), spawnTile->getZ());
 			continue;
 		}
@@ -1301,7 +1470,9 @@ bool IOMapOTBM::loadSpawnsNpc(Map &map, pugi::xml_document &doc) {
 			map.setTile(spawnPosition, spawnTile);
 		}
 
-		spawnTile->spawnNpc = spawnNpc;
+		map.beginCreatureChange(spawnTile);
+		spawnTile->setSpawnNpc(spawnNpc);
+		map.endCreatureChange(spawnTile);
 		map.addSpawnNpc(spawnTile);
 
 		for (pugi::xml_node npcNode = spawnNpcNode.first_child(); npcNode; npcNode = npcNode.next_sibling()) {
@@ -1361,7 +1532,7 @@ bool IOMapOTBM::loadSpawnsNpc(Map &map, pugi::xml_document &doc) {
 				break;
 			}
 
-			if (npcTile->npc) {
+			if (npcTile->getNpc()) {
 				wxString err;
 				err << "Duplicate npc \"" << name << "\" at " << npcPosition.x << ":" << npcPosition.y << ":" << npcPosition.z << " was discarded.";
 				warnings.Add(err);
@@ -1376,15 +1547,17 @@ bool IOMapOTBM::loadSpawnsNpc(Map &map, pugi::xml_document &doc) {
 			Npc* npc = newd Npc(type);
 			npc->setDirection(direction);
 			npc->setSpawnNpcTime(spawntime);
-			npcTile->npc = npc;
+			map.beginCreatureChange(npcTile);
+			npcTile->setNpc(npc);
 
 			if (npcTile->getLocation()->getSpawnNpcCount() == 0) {
 				// No npc spawn, create a newd one
-				ASSERT(npcTile->spawnNpc == nullptr);
+				ASSERT(npcTile->getSpawnNpc() == nullptr);
 				SpawnNpc* spawnNpc = newd SpawnNpc(1);
-				npcTile->spawnNpc = spawnNpc;
+				npcTile->setSpawnNpc(spawnNpc);
 				map.addSpawnNpc(npcTile);
 			}
+			map.endCreatureChange(npcTile);
 		}
 	}
 	return true;
@@ -1506,34 +1679,115 @@ bool IOMapOTBM::saveMap(Map &map, const FileName &identifier) {
 	}
 #endif
 
-	DiskNodeFileWriteHandle f(
-		nstr(identifier.GetFullPath()),
-		(g_settings.getInteger(Config::SAVE_WITH_OTB_MAGIC_NUMBER) ? "OTBM" : std::string(4, '\0'))
-	);
+	// Same as saving in the background, only nothing changes in the meantime
+	std::unique_ptr<OTBMSaveSnapshot> snapshot(takeSnapshot(map, identifier));
+	const bool success = saveSnapshot(*snapshot, [](int done) {
+		g_gui.SetLoadDone(done);
+	});
+	finishSnapshot(map, *snapshot, success);
+	return success;
+}
 
-	if (!f.isOk()) {
-		error("Can not open file %s for writing", (const char*)identifier.GetFullPath().mb_str(wxConvUTF8));
-		return false;
-	}
+OTBMSaveSnapshot::OTBMSaveSnapshot(BaseMap &map) :
+	tiles(map, SavedTileBlocks::BlockShift) {
+	////
+}
 
-	if (!saveMap(map, f)) {
-		return false;
+uint64_t IOMapOTBM::getTileFormat() const {
+	return (uint64_t(version.otbm) << 48) | (uint64_t(g_items.MajorVersion) << 24) | uint64_t(g_items.MinorVersion);
+}
+
+OTBMSaveSnapshot* IOMapOTBM::takeSnapshot(Map &map, const FileName &identifier) {
+	OTBMSaveSnapshot* snapshot = newd OTBMSaveSnapshot(map);
+	snapshot->filename = nstr(identifier.GetFullPath());
+	snapshot->identifier = g_settings.getInteger(Config::SAVE_WITH_OTB_MAGIC_NUMBER) ? "OTBM" : std::string(4, '\0');
+	snapshot->format = getTileFormat();
+
+	// Blocks untouched since the last save or load are copied from that file
+	SavedTileBlocks &saved_blocks = map.getSavedTileBlocks();
+	if (saved_blocks.getFile() && saved_blocks.getFormat() == snapshot->format) {
+		MapSnapshot &tiles = snapshot->tiles;
+		snapshot->source = saved_blocks.getFile();
+		snapshot->source_blocks.resize(tiles.getBlockCount());
+		for (size_t block = 0; block < tiles.getBlockCount(); ++block) {
+			if (tiles.getBlockStart(block) != tiles.getBlockStart(block + 1)) {
+				const uint32_t tile_count = tiles.getBlockStart(block + 1) - tiles.getBlockStart(block);
+				snapshot->source_blocks[block] = saved_blocks.find(tiles.getBlockPosition(block), tiles.getBlockLastPosition(block), tile_count);
+			}
+		}
 	}
+	saved_blocks.beginSave();
 
-	g_gui.SetLoadDone(99, "Saving monster spawns...");
-	saveSpawns(map, identifier);
+	saveMapHeader(map, snapshot->head);
+	saveMapFooter(map, snapshot->tail);
 
-	g_gui.SetLoadDone(99, "Saving houses...");
-	saveHouses(map, identifier);
+	const wxString path = identifier.GetPath(wxPATH_GET_SEPARATOR | wxPATH_GET_VOLUME);
+	snapshot->spawns.filename = (path + wxString(map.spawnmonsterfile.c_str(), wxConvUTF8)).wc_str();
+	snapshot->spawns.valid = saveSpawns(map, snapshot->spawns.document);
+	snapshot->houses.filename = (path + wxString(map.housefile.c_str(), wxConvUTF8)).wc_str();
+	snapshot->houses.valid = saveHouses(map, snapshot->houses.document);
+	snapshot->zones.filename = (path + wxString(map.zonefile.c_str(), wxConvUTF8)).wc_str();
+	snapshot->zones.valid = saveZones(map, snapshot->zones.document);
+	snapshot->npcs.filename = (path + wxString(map.spawnnpcfile.c_str(), wxConvUTF8)).wc_str();
+	snapshot->npcs.valid = saveSpawnsNpc(map, snapshot->npcs.document);
+	return snapshot;
+}
 
-	g_gui.SetLoadDone(99, "Saving zones...");
-	saveZones(map, identifier);
+bool IOMapOTBM::saveSnapshot(OTBMSaveSnapshot &snapshot, const std::function<void(int)> &progress) {
+	// Opening the file for writing would wipe the blocks we copy
+	if (snapshot.source && snapshot.source->isSameFile(snapshot.filename)) {
+		snapshot.source.reset();
+		snapshot.source_blocks.clear();
+	}
+
+	{
+		DiskNodeFileWriteHandle f(snapshot.filename, snapshot.identifier);
+		if (!f.isOk()) {
+			error("Can not open file %s for writing", snapshot.filename.c_str());
+			return false;
+		}
+
+		f.addEncodedNodes(snapshot.head.getMemory(), snapshot.head.getSize());
+		saveTiles(snapshot, f, snapshot.identifier.size() + snapshot.head.getSize(), progress);
+		f.addEncodedNodes(snapshot.tail.getMemory(), snapshot.tail.getSize());
+		if (!f.isOk()) {
+			error("Could not write to file %s", snapshot.filename.c_str());
+			return false;
+		}
+	}
 
-	g_gui.SetLoadDone(99, "Saving npcs spawns...");
-	saveSpawnsNpc(map, identifier);
+	for (OTBMSaveSnapshot::XmlFile* file : { &snapshot.spawns, &snapshot.houses, &snapshot.zones, &snapshot.npcs }) {
+		if (file->valid) {
+			file->document.save_file(file->filename.c_str(), "\t", pugi::format_default, pugi::encoding_utf8);
+		}
+	}
 	return true;
 }
 
+void IOMapOTBM::finishSnapshot(Map &map, OTBMSaveSnapshot &snapshot, bool success) {
+	std::shared_ptr<FileRangeReadHandle> file;
+	std::vector<SavedTileBlocks::Block> blocks;
+	if (success) {
+		file = std::make_shared<FileRangeReadHandle>(snapshot.filename);
+		const MapSnapshot &tiles = snapshot.tiles;
+		blocks.reserve(snapshot.written_blocks.size());
+		for (size_t block = 0; block < snapshot.written_blocks.size(); ++block) {
+			if (tiles.getBlockStart(block) != tiles.getBlockStart(block + 1)) {
+				const uint32_t tile_count = tiles.getBlockStart(block + 1) - tiles.getBlockStart(block);
+				blocks.push_back({ tiles.getBlockPosition(block), tiles.getBlockLastPosition(block), tile_count, snapshot.written_blocks[block] });
+			}
+		}
+	}
+
+	SavedTileBlocks &saved_blocks = map.getSavedTileBlocks();
+	if (file && !file->isOpen()) {
+		// Nothing to copy from next time
+		saved_blocks.clear();
+		file.reset();
+	}
+	saved_blocks.finishSave(std::move(file), snapshot.format, std::move(blocks));
+}
+
 bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 	/* STOP!
 	 * Before you even think about modifying this, please reconsider.
@@ -1546,180 +1800,233 @@ bool IOMapOTBM::saveMap(Map &map, NodeFileWriteHandle &f) {
 	 * format.
 	 */
 
-	const IOMapOTBM &self = *this;
+	saveMapHeader(map, f);
 
+	// Not attached to the map, nothing changes while we write
+	OTBMSaveSnapshot snapshot(map);
+	saveTiles(snapshot, f, 0, [](int done) {
+		g_gui.SetLoadDone(done);
+	});
+
+	saveMapFooter(map, f);
+	return true;
+}
+
+void IOMapOTBM::saveMapHeader(Map &map, NodeFileWriteHandle &f) {
 	FileName tmpName;
 	MapVersion mapVersion = map.getVersion();
 
 	f.addNode(0);
-	{
-		f.addU32(mapVersion.otbm); // Version
+	f.addU32(mapVersion.otbm); // Version
 
-		f.addU16(map.width);
-		f.addU16(map.height);
+	f.addU16(map.width);
+	f.addU16(map.height);
 
-		f.addU32(g_items.MajorVersion);
-		f.addU32(g_items.MinorVersion);
+	f.addU32(g_items.MajorVersion);
+	f.addU32(g_items.MinorVersion);
 
-		f.addNode(OTBM_MAP_DATA);
-		{
-			f.addByte(OTBM_ATTR_DESCRIPTION);
-			// Neither SimOne's nor OpenTibia cares for additional description tags
-			f.addString("Saved with Remere's Map Editor " + __RME_VERSION__);
+	f.addNode(OTBM_MAP_DATA);
+	f.addByte(OTBM_ATTR_DESCRIPTION);
+	// Neither SimOne's nor OpenTibia cares for additional description tags
+	f.addString("Saved with Remere's Map Editor " + __RME_VERSION__);
 
-			f.addU8(OTBM_ATTR_DESCRIPTION);
-			f.addString(map.description);
+	f.addU8(OTBM_ATTR_DESCRIPTION);
+	f.addString(map.description);
 
-			tmpName.Assign(wxstr(map.spawnmonsterfile));
-			f.addU8(OTBM_ATTR_EXT_SPAWN_MONSTER_FILE);
-			f.addString(nstr(tmpName.GetFullName()));
+	tmpName.Assign(wxstr(map.spawnmonsterfile));
+	f.addU8(OTBM_ATTR_EXT_SPAWN_MONSTER_FILE);
+	f.addString(nstr(tmpName.GetFullName()));
 
-			tmpName.Assign(wxstr(map.spawnnpcfile));
-			f.addU8(OTBM_ATTR_EXT_SPAWN_NPC_FILE);
-			f.addString(nstr(tmpName.GetFullName()));
+	tmpName.Assign(wxstr(map.spawnnpcfile));
+	f.addU8(OTBM_ATTR_EXT_SPAWN_NPC_FILE);
+	f.addString(nstr(tmpName.GetFullName()));
 
-			tmpName.Assign(wxstr(map.housefile));
-			f.addU8(OTBM_ATTR_EXT_HOUSE_FILE);
-			f.addString(nstr(tmpName.GetFullName()));
+	tmpName.Assign(wxstr(map.housefile));
+	f.addU8(OTBM_ATTR_EXT_HOUSE_FILE);
+	f.addString(nstr(tmpName.GetFullName()));
 
-			tmpName.Assign(wxstr(map.zonefile));
-			f.addU8(OTBM_ATTR_EXT_ZONE_FILE);
-			f.addString(nstr(tmpName.GetFullName()));
+	tmpName.Assign(wxstr(map.zonefile));
+	f.addU8(OTBM_ATTR_EXT_ZONE_FILE);
+	f.addString(nstr(tmpName.GetFullName()));
+}
 
-			// Start writing tiles
-			uint32_t tiles_saved = 0;
-			bool first = true;
+void IOMapOTBM::saveTiles(OTBMSaveSnapshot &snapshot, NodeFileWriteHandle &f, uint64_t offset, const std::function<void(int)> &progress) const {
+	// Blocks are serialized on all threads into their own buffers and
+	// written out in order, the output only depends on the tiles. Blocks that
+	// are known to be unchanged are copied from the file the map came from.
+	// Only a window of blocks is kept in memory at a time.
+	MapSnapshot &tiles = snapshot.tiles;
+	const size_t block_count = tiles.getBlockCount();
+	snapshot.written_blocks.assign(block_count, SavedTileBlocks::Range());
+	std::vector<std::unique_ptr<MemoryNodeFileWriteHandle>> buffers(std::min(block_count, OTBMSaveBlockWindow));
+	for (size_t window = 0; window < block_count; window += OTBMSaveBlockWindow) {
+		const size_t window_size = std::min(block_count - window, OTBMSaveBlockWindow);
+		parallelForBlocks(
+			window_size,
+			[this, &buffers, &snapshot, &tiles, window](size_t index) {
+				std::unique_ptr<MemoryNodeFileWriteHandle> &buffer = buffers[index];
+				if (!buffer) {
+					buffer.reset(newd MemoryNodeFileWriteHandle);
+				}
+				const size_t block = window + index;
+				size_t count;
+				const Tile* const* block_tiles = tiles.acquireBlock(block, count);
+				if (!copySavedBlock(snapshot, block, *buffer)) {
+					saveTileAreas(block_tiles, count, *buffer);
+				}
+				tiles.releaseBlock(block);
+			},
+			[&tiles, &progress, window](size_t done, size_t count) {
+				if (tiles.size() != 0) {
+					progress(int(tiles.getBlockStart(window + done) / double(tiles.size()) * 100.0));
+				}
+			}
+		);
+
+		for (size_t index = 0; index < window_size; ++index) {
+			const size_t size = buffers[index]->getSize();
+			snapshot.written_blocks[window + index] = { offset, size };
+			offset += size;
+			f.addEncodedNodes(buffers[index]->getMemory(), size);
+			buffers[index]->reset();
+		}
+	}
+}
 
-			int local_x = -1, local_y = -1, local_z = -1;
+bool IOMapOTBM::copySavedBlock(const OTBMSaveSnapshot &snapshot, size_t block, NodeFileWriteHandle &f) const {
+	if (snapshot.source_blocks.empty() || snapshot.source_blocks[block].size == 0) {
+		return false;
+	}
 
-			MapIterator map_iterator = map.begin();
-			while (map_iterator != map.end()) {
-				// Update progressbar
-				++tiles_saved;
-				if (tiles_saved % 8192 == 0) {
-					g_gui.SetLoadDone(int(tiles_saved / double(map.getTileCount()) * 100.0));
-				}
+	const SavedTileBlocks::Range &range = snapshot.source_blocks[block];
+	std::vector<uint8_t> bytes(range.size);
+	// A block is a run of whole tile area nodes, anything else means the file
+	// is not what we think it is and the tiles are written instead
+	if (!snapshot.source->read(range.offset, bytes.data(), bytes.size()) || bytes.front() != NODE_START || bytes.back() != NODE_END) {
+		return false;
+	}
+	f.addEncodedNodes(bytes.data(), bytes.size());
+	return true;
+}
 
-				// Get tile
-				Tile* save_tile = (*map_iterator)->get();
+void IOMapOTBM::saveMapFooter(Map &map, NodeFileWriteHandle &f) {
+	f.addNode(OTBM_TOWNS);
+	for (const auto &townEntry : map.towns) {
+		Town* town = townEntry.second;
+		const Position &townPosition = town->getTemplePosition();
+		f.addNode(OTBM_TOWN);
+		f.addU32(town->getID());
+		f.addString(town->getName());
+		f.addU16(townPosition.x);
+		f.addU16(townPosition.y);
+		f.addU8(townPosition.z);
+		f.endNode();
+	}
+	f.endNode();
 
-				// Is it an empty tile that we can skip? (Leftovers...)
-				if (!save_tile || save_tile->size() == 0) {
-					++map_iterator;
-					continue;
-				}
+	if (version.otbm >= MAP_OTBM_3) {
+		f.addNode(OTBM_WAYPOINTS);
+		for (const auto &waypointEntry : map.waypoints) {
+			Waypoint* waypoint = waypointEntry.second;
+			f.addNode(OTBM_WAYPOINT);
+			f.addString(waypoint->name);
+			f.addU16(waypoint->pos.x);
+			f.addU16(waypoint->pos.y);
+			f.addU8(waypoint->pos.z);
+			f.endNode();
+		}
+		f.endNode();
+	}
 
-				const Position &pos = save_tile->getPosition();
+	// OTBM_MAP_DATA and the root node
+	f.endNode();
+	f.endNode();
+}
 
-				// Decide if newd node should be created
-				if (pos.x < local_x || pos.x >= local_x + 256 || pos.y < local_y || pos.y >= local_y + 256 || pos.z != local_z) {
-					// End last node
-					if (!first) {
-						f.endNode();
-					}
-					first = false;
+void IOMapOTBM::saveTileAreas(const Tile* const* tiles, size_t count, NodeFileWriteHandle &f) const {
+	const IOMapOTBM &self = *this;
 
-					// Start newd node
-					f.addNode(OTBM_TILE_AREA);
-					f.addU16(local_x = pos.x & 0xFF00);
-					f.addU16(local_y = pos.y & 0xFF00);
-					f.addU8(local_z = pos.z);
-				}
-				f.addNode(save_tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
+	int local_x = -1, local_y = -1, local_z = -1;
+	for (size_t index = 0; index < count; ++index) {
+		const Tile* save_tile = tiles[index];
+		const Position &pos = save_tile->getPosition();
 
-				f.addU8(save_tile->getX() & 0xFF);
-				f.addU8(save_tile->getY() & 0xFF);
+		// Decide if newd node should be created
+		if (pos.x < local_x || pos.x >= local_x + 256 || pos.y < local_y || pos.y >= local_y + 256 || pos.z != local_z) {
+			// End last node
+			if (index != 0) {
+				f.endNode();
+			}
 
-				if (save_tile->isHouseTile()) {
-					f.addU32(save_tile->getHouseID());
-				}
+			// Start newd node
+			f.addNode(OTBM_TILE_AREA);
+			f.addU16(local_x = pos.x & 0xFF00);
+			f.addU16(local_y = pos.y & 0xFF00);
+			f.addU8(local_z = pos.z);
+		}
+		f.addNode(save_tile->isHouseTile() ? OTBM_HOUSETILE : OTBM_TILE);
 
-				if (save_tile->getMapFlags()) {
-					f.addByte(OTBM_ATTR_TILE_FLAGS);
-					f.addU32(save_tile->getMapFlags());
-				}
+		f.addU8(save_tile->getX() & 0xFF);
+		f.addU8(save_tile->getY() & 0xFF);
 
-				if (save_tile->ground) {
-					Item* ground = save_tile->ground;
-					if (ground->isMetaItem()) {
-						// Do nothing, we don't save metaitems...
-					} else if (ground->hasBorderEquivalent()) {
-						bool found = false;
-						for (Item* item : save_tile->items) {
-							if (item->getGroundEquivalent() == ground->getID()) {
-								// Do nothing
-								// Found equivalent
-								found = true;
-								break;
-							}
-						}
+		if (save_tile->isHouseTile()) {
+			f.addU32(save_tile->getHouseID());
+		}
 
-						if (!found) {
-							ground->serializeItemNode_OTBM(self, f);
-						}
-					} else if (ground->isComplex()) {
-						ground->serializeItemNode_OTBM(self, f);
-					} else {
-						f.addByte(OTBM_ATTR_ITEM);
-						ground->serializeItemCompact_OTBM(self, f);
-					}
-				}
+		if (save_tile->getMapFlags()) {
+			f.addByte(OTBM_ATTR_TILE_FLAGS);
+			f.addU32(save_tile->getMapFlags());
+		}
 
-				for (Item* item : save_tile->items) {
-					if (!item->isMetaItem()) {
-						item->serializeItemNode_OTBM(self, f);
-					}
-				}
-				if (!save_tile->zones.empty()) {
-					f.addNode(OTBM_TILE_ZONE);
-					f.addU16(save_tile->zones.size());
-					for (const auto &zoneId : save_tile->zones) {
-						f.addU16(zoneId);
+		if (save_tile->ground) {
+			// Peek, the editor may unpack items of this tile while it is saved
+			PackedItem scratch;
+			const Item* ground = scratch.peek(save_tile->ground.getSlot());
+			if (ground->isMetaItem()) {
+				// Do nothing, we don't save metaitems...
+			} else if (ground->hasBorderEquivalent()) {
+				bool found = false;
+				for (const Item* item : save_tile->items.peek()) {
+					if (item->getGroundEquivalent() == ground->getID()) {
+						// Do nothing
+						// Found equivalent
+						found = true;
+						break;
 					}
-					f.endNode();
 				}
 
-				f.endNode();
-				++map_iterator;
+				if (!found) {
+					ground->serializeItemNode_OTBM(self, f);
+				}
+			} else if (ground->isComplex()) {
+				ground->serializeItemNode_OTBM(self, f);
+			} else {
+				f.addByte(OTBM_ATTR_ITEM);
+				ground->serializeItemCompact_OTBM(self, f);
 			}
+		}
 
-			// Only close the last node if one has actually been created
-			if (!first) {
-				f.endNode();
+		for (const Item* item : save_tile->items.peek()) {
+			if (!item->isMetaItem()) {
+				item->serializeItemNode_OTBM(self, f);
 			}
-
-			f.addNode(OTBM_TOWNS);
-			for (const auto &townEntry : map.towns) {
-				Town* town = townEntry.second;
-				const Position &townPosition = town->getTemplePosition();
-				f.addNode(OTBM_TOWN);
-				f.addU32(town->getID());
-				f.addString(town->getName());
-				f.addU16(townPosition.x);
-				f.addU16(townPosition.y);
-				f.addU8(townPosition.z);
-				f.endNode();
+		}
+		if (!save_tile->getZones().empty()) {
+			f.addNode(OTBM_TILE_ZONE);
+			f.addU16(save_tile->getZones().size());
+			for (const auto &zoneId : save_tile->getZones()) {
+				f.addU16(zoneId);
 			}
 			f.endNode();
-
-			if (version.otbm >= MAP_OTBM_3) {
-				f.addNode(OTBM_WAYPOINTS);
-				for (const auto &waypointEntry : map.waypoints) {
-					Waypoint* waypoint = waypointEntry.second;
-					f.addNode(OTBM_WAYPOINT);
-					f.addString(waypoint->name);
-					f.addU16(waypoint->pos.x);
-					f.addU16(waypoint->pos.y);
-					f.addU8(waypoint->pos.z);
-					f.endNode();
-				}
-				f.endNode();
-			}
 		}
+
+		f.endNode();
+	}
+
+	// Only close the last node if one has actually been created
+	if (count != 0) {
 		f.endNode();
 	}
-	f.endNode();
-	return true;
 }
 
 bool IOMapOTBM::saveSpawns(Map &map, const FileName &dir) {
@@ -1751,7 +2058,7 @@ bool IOMapOTBM::saveSpawns(Map &map, pugi::xml_document &doc) {
 			continue;
 		}
 
-		SpawnMonster* spawnMonster = tile->spawnMonster;
+		SpawnMonster* spawnMonster = tile->getSpawnMonster();
 		ASSERT(spawnMonster);
 
 		pugi::xml_node spawnNode = spawnNodes.append_child("monster");
@@ -1766,7 +2073,7 @@ bool IOMapOTBM::saveSpawns(Map &map, pugi::xml_document &doc) {
 			for (int32_t x = -radius; x <= radius; ++x) {
 				Tile* monster_tile = map.getTile(spawnPosition + Position(x, y, 0));
 				if (monster_tile) {
-					Monster* monster = monster_tile->monster;
+					Monster* monster = monster_tile->getMonster();
 					if (monster && !monster->isSaved()) {
 						pugi::xml_node monsterNode = spawnNode.append_child("monster");
 						monsterNode.append_attribute("name") = monster->getName().c_str();
@@ -1906,7 +2213,7 @@ bool IOMapOTBM::saveSpawnsNpc(Map &map, pugi::xml_document &doc) {
 			continue;
 		}
 
-		SpawnNpc* spawnNpc = tile->spawnNpc;
+		SpawnNpc* spawnNpc = tile->getSpawnNpc();
 		ASSERT(spawnNpc);
 
 		pugi::xml_node spawnNpcNode = spawnNodes.append_child("npc");
@@ -1921,7 +2228,7 @@ bool IOMapOTBM::saveSpawnsNpc(Map &map, pugi::xml_document &doc) {
 			for (int32_t x = -radius; x <= radius; ++x) {
 				Tile* npcTile = map.getTile(spawnPosition + Position(x, y, 0));
 				if (npcTile) {
-					Npc* npc = npcTile->npc;
+					Npc* npc = npcTile->getNpc();
 					if (npc && !npc->isSaved()) {
 						pugi::xml_node npcNode = spawnNpcNode.append_child("npc");
 						npcNode.append_attribute("name") = npc->getName().c_str();
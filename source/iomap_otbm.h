@@ -19,6 +19,11 @@
 #define RME_OTBM_MAP_IO_H_
 
 #include "iomap.h"
+#include "filehandle.h"
+#include "map_snapshot.h"
+#include "saved_tile_blocks.h"
+
+#include <functional>
 
 // Pragma pack is VERY important since otherwise it won't be able to load the structs correctly
 #pragma pack(1)
@@ -113,6 +118,38 @@ struct OTBM_HouseTile_coords {
 
 #pragma pack()
 
+struct OTBMTileArea;
+
+// Everything needed to write a map out without touching it again, see
+// IOMapOTBM::takeSnapshot
+struct OTBMSaveSnapshot {
+	explicit OTBMSaveSnapshot(BaseMap &map);
+
+	struct XmlFile {
+		std::wstring filename;
+		pugi::xml_document document;
+		bool valid = false;
+	};
+
+	std::string filename;
+	std::string identifier;
+	MapSnapshot tiles;
+	// How the tiles are encoded, see SavedTileBlocks
+	uint64_t format = 0;
+	// Per block, where it can be copied from instead of writing its tiles
+	std::shared_ptr<FileRangeReadHandle> source;
+	std::vector<SavedTileBlocks::Range> source_blocks;
+	// Per block, where it ended up in the file
+	std::vector<SavedTileBlocks::Range> written_blocks;
+	// The nodes in front of and behind the tiles
+	MemoryNodeFileWriteHandle head;
+	MemoryNodeFileWriteHandle tail;
+	XmlFile spawns;
+	XmlFile houses;
+	XmlFile zones;
+	XmlFile npcs;
+};
+
 class IOMapOTBM : public IOMap {
 public:
 	IOMapOTBM(MapVersion ver) {
@@ -125,10 +162,22 @@ public:
 	virtual bool loadMap(Map &map, const FileName &identifier);
 	virtual bool saveMap(Map &map, const FileName &identifier);
 
+	// Saving on another thread, the snapshot is taken on the thread that
+	// edits the map and its tiles have to stay attached to the map
+	// (BaseMap::setSnapshot) until saveSnapshot returns. finishSnapshot goes
+	// back on the editing thread and tells the map what was written.
+	OTBMSaveSnapshot* takeSnapshot(Map &map, const FileName &identifier);
+	bool saveSnapshot(OTBMSaveSnapshot &snapshot, const std::function<void(int)> &progress);
+	void finishSnapshot(Map &map, OTBMSaveSnapshot &snapshot, bool success);
+
 protected:
 	static bool getVersionInfo(NodeFileReadHandle* f, MapVersion &out_ver);
 
 	virtual bool loadMap(Map &map, NodeFileReadHandle &handle);
+	// Only reads the node, safe to run for several areas at once
+	void decodeTileArea(BinaryNode* areaNode, OTBMTileArea &area) const;
+	// False if anything about the area was off
+	bool mergeTileArea(Map &map, OTBMTileArea &area);
 	bool loadSpawnsMonster(Map &map, const FileName &dir);
 	bool loadSpawnsMonster(Map &map, pugi::xml_document &doc);
 	bool loadHouses(Map &map, const FileName &dir);
@@ -139,6 +188,15 @@ protected:
 	bool loadZones(Map &map, pugi::xml_document &doc);
 
 	virtual bool saveMap(Map &map, NodeFileWriteHandle &handle);
+	// Leaves the root and OTBM_MAP_DATA nodes open for the tiles
+	void saveMapHeader(Map &map, NodeFileWriteHandle &f);
+	// offset is where the tiles start in the file
+	void saveTiles(OTBMSaveSnapshot &snapshot, NodeFileWriteHandle &f, uint64_t offset, const std::function<void(int)> &progress) const;
+	bool copySavedBlock(const OTBMSaveSnapshot &snapshot, size_t block, NodeFileWriteHandle &f) const;
+	uint64_t getTileFormat() const;
+	void saveMapFooter(Map &map, NodeFileWriteHandle &f);
+	// Only reads the tiles, safe to run for several stretches of tiles at once
+	void saveTileAreas(const Tile* const* tiles, size_t count, NodeFileWriteHandle &f) const;
 	bool saveSpawns(Map &map, const FileName &dir);
 	bool saveSpawns(Map &map, pugi::xml_document &doc);
 	bool saveHouses(Map &map, const FileName &dir);
@@ -530,7 +530,7 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 
 							// Create and assign monster spawn
 							Tile* spawnMonsterTile = map.getTile(spawnPos);
-							if (spawnMonsterTile && spawnMonsterTile->spawnMonster) {
+							if (spawnMonsterTile && spawnMonsterTile->getSpawnMonster()) {
 								warning("Duplicate monster spawn on position %d:%d:%d\n", spawnMonsterTile->getX(), spawnMonsterTile->getY(), spawnMonsterTile->getZ());
 								continue;
 							}
@@ -540,7 +540,9 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 								spawnMonsterTile = map.allocator(spawnPos);
 								map.setTile(spawnPos, spawnMonsterTile);
 							}
-							spawnMonsterTile->spawnMonster = spawnMonster;
+							map.beginCreatureChange(spawnMonsterTile);
+							spawnMonsterTile->setSpawnMonster(spawnMonster);
+							map.endCreatureChange(spawnMonsterTile);
 							map.addSpawnMonster(spawnMonsterTile);
 
 							// Read any monsters associated with the spawnMonster
@@ -594,7 +596,7 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 										warning("Discarding monster \"%s\" at %d:%d:%d due to invalid position", name.c_str(), monsterPos.x, monsterPos.y, monsterPos.z);
 										break;
 									}
-									if (monster_tile->monster) {
+									if (monster_tile->getMonster()) {
 										warning("Duplicate monster \"%s\" at %d:%d:%d, discarding", name.c_str(), monsterPos.x, monsterPos.y, monsterPos.z);
 										break;
 									}
@@ -604,14 +606,16 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 									}
 									Monster* monster = newd Monster(type);
 									monster->setSpawnMonsterTime(spawntime);
-									monster_tile->monster = monster;
+									map.beginCreatureChange(monster_tile);
+									monster_tile->setMonster(monster);
 									if (monster_tile->spawn_monster_count == 0) {
 										// No monster spawn, create a newd one (this happends if the radius of the monster spawn has been decreased due to g_settings)
-										ASSERT(monster_tile->spawnMonster == nullptr);
+										ASSERT(monster_tile->getSpawnMonster() == nullptr);
 										SpawnMonster* spawnMonster = newd SpawnMonster(5);
-										monster_tile->spawnMonster = spawnMonster;
+										monster_tile->setSpawnMonster(spawnMonster);
 										map.addSpawnMonster(monster_tile);
 									}
+									map.endCreatureChange(monster_tile);
 								} while (monsterNode->advance());
 							}
 						} while (spawnMonsterNode->advance());
@@ -651,7 +655,7 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 
 							// Create and assign spawnNpc
 							Tile* spawnNpcTile = map.getTile(spawnNpcPos);
-							if (spawnNpcTile && spawnNpcTile->spawnNpc) {
+							if (spawnNpcTile && spawnNpcTile->getSpawnNpc()) {
 								warning("Duplicate spawnNpc on position %d:%d:%d\n", spawnNpcTile->getX(), spawnNpcTile->getY(), spawnNpcTile->getZ());
 								continue;
 							}
@@ -661,7 +665,9 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 								spawnNpcTile = map.allocator(spawnNpcPos);
 								map.setTile(spawnNpcPos, spawnNpcTile);
 							}
-							spawnNpcTile->spawnNpc = spawnNpc;
+							map.beginCreatureChange(spawnNpcTile);
+							spawnNpcTile->setSpawnNpc(spawnNpc);
+							map.endCreatureChange(spawnNpcTile);
 							map.addSpawnNpc(spawnNpcTile);
 
 							// Read any npc associated with the npc spawn
@@ -711,7 +717,7 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 										warning("Discarding npc \"%s\" at %d:%d:%d due to invalid position", name.c_str(), npcPos.x, npcPos.y, npcPos.z);
 										break;
 									}
-									if (npcTile->npc) {
+									if (npcTile->getNpc()) {
 										warning("Duplicate npc \"%s\" at %d:%d:%d, discarding", name.c_str(), npcPos.x, npcPos.y, npcPos.z);
 										break;
 									}
@@ -721,14 +727,16 @@ bool IOMapOTMM::loadMap(Map &map, NodeFileReadHandle &f, const FileName &identif
 									}
 									Npc* npc = newd Npc(type);
 									npc->setSpawnNpcTime(spawntime);
-									npcTile->npc = npc;
+									map.beginCreatureChange(npcTile);
+									npcTile->setNpc(npc);
 									if (npcTile->spawn_npc_count == 0) {
 										// No npc spawn, create a newd one (this happends if the radius of the npc spawn has been decreased due to g_settings)
-										ASSERT(npcTile->spawnNpc == nullptr);
+										ASSERT(npcTile->getSpawnNpc() == nullptr);
 										SpawnNpc* spawnNpc = newd SpawnNpc(1);
-										npcTile->spawnNpc = spawnNpc;
+										npcTile->setSpawnNpc(spawnNpc);
 										map.addSpawnNpc(npcTile);
 									}
+									map.endCreatureChange(npcTile);
 								} while (npcNode->advance());
 							}
 						} while (spawnNpcNode->advance());
@@ -952,7 +960,7 @@ bool IOMapOTMM::saveMap(Map &map, NodeFileWriteHandle &f, const FileName &identi
 								f.addU16(0);
 							} else if (ground->hasBorderEquivalent()) {
 								bool found = false;
-								for (ItemVector::const_iterator it = save_tile->items.begin(); it != save_tile->items.end(); ++it) {
+								for (TileItemVector::const_iterator it = save_tile->items.begin(); it != save_tile->items.end(); ++it) {
 									if ((*it)->getGroundEquivalent() == ground->getID()) {
 										// Do nothing
 										// Found equivalent
@@ -975,7 +983,7 @@ bool IOMapOTMM::saveMap(Map &map, NodeFileWriteHandle &f, const FileName &identi
 							f.addU16(0);
 						}
 
-						for (ItemVector::const_iterator it = save_tile->items.begin(); it != save_tile->items.end(); ++it) {
+						for (TileItemVector::const_iterator it = save_tile->items.begin(); it != save_tile->items.end(); ++it) {
 							if (!(*it)->isMetaItem()) {
 								(*it)->serializeItemNode_OTMM(*this, f);
 							}
@@ -995,7 +1003,7 @@ bool IOMapOTMM::saveMap(Map &map, NodeFileWriteHandle &f, const FileName &identi
 				for (SpawnNpcPositionList::const_iterator piter = spawnsMonster.begin(); piter != spawnsMonster.end(); ++piter) {
 					const Tile* tile = map.getTile(*piter);
 					ASSERT(tile);
-					const SpawnMonster* spawnMonster = tile->spawnMonster;
+					const SpawnMonster* spawnMonster = tile->getSpawnMonster();
 					ASSERT(spawnMonster);
 
 					f.addNode(OTMM_SPAWN_MONSTER_AREA);
@@ -1004,11 +1012,11 @@ bool IOMapOTMM::saveMap(Map &map, NodeFileWriteHandle &f, const FileName &identi
 						f.addU16(tile->getY());
 						f.addU8(tile->getZ() & 0xf);
 						f.addU32(spawnMonster->getSize());
-						for (int y = -tile->spawnMonster->getSize(); y <= tile->spawnMonster->getSize(); ++y) {
-							for (int x = -tile->spawnMonster->getSize(); x <= tile->spawnMonster->getSize(); ++x) {
+						for (int y = -tile->getSpawnMonster()->getSize(); y <= tile->getSpawnMonster()->getSize(); ++y) {
+							for (int x = -tile->getSpawnMonster()->getSize(); x <= tile->getSpawnMonster()->getSize(); ++x) {
 								Tile* monster_tile = map.getTile(*piter + Position(x, y, 0));
 								if (monster_tile) {
-									Monster* c = monster_tile->monster;
+									Monster* c = monster_tile->getMonster();
 									if (c && c->isSaved() == false) {
 										f.addNode(OTMM_MONSTER);
 										{
@@ -1043,7 +1051,7 @@ bool IOMapOTMM::saveMap(Map &map, NodeFileWriteHandle &f, const FileName &identi
 				for (SpawnNpcPositionList::const_iterator piter = spawnNpc.begin(); piter != spawnNpc.end(); ++piter) {
 					const Tile* tile = map.getTile(*piter);
 					ASSERT(tile);
-					const SpawnNpc* spawnNpc = tile->spawnNpc;
+					const SpawnNpc* spawnNpc = tile->getSpawnNpc();
 					ASSERT(spawnNpc);
 
 					f.addNode(OTMM_SPAWN_NPC_AREA);
@@ -1052,11 +1060,11 @@ bool IOMapOTMM::saveMap(Map &map, NodeFileWriteHandle &f, const FileName &identi
 						f.addU16(tile->getY());
 						f.addU8(tile->getZ() & 0xf);
 						f.addU32(spawnNpc->getSize());
-						for (int y = -tile->spawnNpc->getSize(); y <= tile->spawnNpc->getSize(); ++y) {
-							for (int x = -tile->spawnNpc->getSize(); x <= tile->spawnNpc->getSize(); ++x) {
+						for (int y = -tile->getSpawnNpc()->getSize(); y <= tile->getSpawnNpc()->getSize(); ++y) {
+							for (int x = -tile->getSpawnNpc()->getSize(); x <= tile->getSpawnNpc()->getSize(); ++x) {
 								Tile* npcTile = map.getTile(*piter + Position(x, y, 0));
 								if (npcTile) {
-									Npc* npc = npcTile->npc;
+									Npc* npc = npcTile->getNpc();
 									if (npc && npc->isSaved() == false) {
 										f.addNode(OTMM_NPC);
 										{
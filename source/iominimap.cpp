@@ -152,40 +152,19 @@ bool IOMinimap::exportMinimap(const std::string &directory) {
 		return true;
 	}
 
-	wxRect bounds[rme::MapLayers];
 	int min_z = m_floor == -1 ? 0 : m_floor;
 	int max_z = m_floor == -1 ? rme::MapMaxLayer : m_floor;
 
-	for (size_t z = min_z; z <= max_z; z++) {
-		auto &rect = bounds[z];
-		rect.x = rme::MapMaxWidth + 1;
-		rect.y = rme::MapMaxHeight + 1;
-		rect.width = 0;
-		rect.height = 0;
-	}
-
-	int totalTiles = 0;
-	for (auto it = map.begin(); it != map.end(); ++it) {
-		auto tile = (*it)->get();
-		if (!tile || (!tile->ground && tile->items.empty())) {
-			continue;
-		}
-
-		const auto &position = tile->getPosition();
-		auto &rect = bounds[position.z];
-		if (position.x < rect.x) {
-			rect.x = position.x;
-		}
-		if (position.y < rect.y) {
-			rect.y = position.y;
-		}
-		if (position.x > rect.width) {
-			rect.width = position.x;
-		}
-		if (position.y > rect.height) {
-			rect.height = position.y;
+	// The map keeps the bounds and counts of each floor, width and height
+	// hold the last x and y here
+	wxRect bounds[rme::MapLayers];
+	uint64_t totalTiles = 0;
+	for (int z = min_z; z <= max_z; z++) {
+		Position from, to;
+		if (map.getFloorBounds(z, from, to)) {
+			bounds[z] = wxRect(from.x, from.y, to.x, to.y);
+			totalTiles += map.getStatistics().getFloor(z).tile_count;
 		}
-		totalTiles++;
 	}
 
 	constexpr int image_size = 1024;
@@ -203,39 +182,34 @@ bool IOMinimap::exportMinimap(const std::string &directory) {
 
 		for (int h = 0; h < rme::MapMaxHeight; h += image_size) {
 			for (int w = 0; w < rme::MapMaxWidth; w += image_size) {
-				if (w < rect.x || w > rect.width || h < rect.y || h > rect.height) {
+				if (w + image_size <= rect.x || w > rect.width || h + image_size <= rect.y || h > rect.height) {
 					continue;
 				}
 
 				bool empty = true;
 				memset(pixels, 0, pixels_size);
 
-				int index = 0;
-				for (int y = 0; y < image_size; y++) {
-					for (int x = 0; x < image_size; x++) {
-						auto tile = map.getTile(w + x, h + y, z);
-						if (!tile || (!tile->ground && tile->items.empty())) {
-							index += rme::PixelFormatRGB;
-							continue;
-						}
+				map.forEachTileInArea(w, h, w + image_size - 1, h + image_size - 1, z, z, [&](Tile* tile) {
+					if (!tile->ground && tile->items.empty()) {
+						return;
+					}
 
-						processedTiles++;
-						int progress = static_cast<int>((static_cast<double>(processedTiles) / totalTiles) * 100);
-						if (progress > lastShownProgress) {
-							if (m_updateLoadbar) {
-								g_gui.SetLoadDone(progress);
-							}
-							lastShownProgress = progress;
+					processedTiles++;
+					int progress = static_cast<int>((static_cast<double>(processedTiles) / totalTiles) * 100);
+					if (progress > lastShownProgress) {
+						if (m_updateLoadbar) {
+							g_gui.SetLoadDone(progress);
 						}
-
-						uint8_t color = tile->getMiniMapColor();
-						pixels[index] = (uint8_t)(static_cast<int>(color / 36) % 6 * 51); // red
-						pixels[index + 1] = (uint8_t)(static_cast<int>(color / 6) % 6 * 51); // green
-						pixels[index + 2] = (uint8_t)(color % 6 * 51); // blue
-						index += rme::PixelFormatRGB;
-						empty = false;
+						lastShownProgress = progress;
 					}
-				}
+
+					const int index = ((tile->getY() - h) * image_size + (tile->getX() - w)) * rme::PixelFormatRGB;
+					uint8_t color = tile->getMiniMapColor();
+					pixels[index] = (uint8_t)(static_cast<int>(color / 36) % 6 * 51); // red
+					pixels[index + 1] = (uint8_t)(static_cast<int>(color / 6) % 6 * 51); // green
+					pixels[index + 2] = (uint8_t)(color % 6 * 51); // blue
+					empty = false;
+				});
 
 				if (!empty) {
 					image->SetData(pixels, true);
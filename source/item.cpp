@@ -24,12 +24,17 @@
 #include "complexitem.h"
 #include "iomap.h"
 #include "item.h"
+#include "content_hash.h"
 
 #include "ground_brush.h"
 #include "carpet_brush.h"
 #include "table_brush.h"
 #include "wall_brush.h"
 
+// Plain items are the bulk of every map, keep them at two pointers plus the
+// packed id/subtype/state fields
+static_assert(sizeof(Item) <= 2 * sizeof(void*) + 8, "Item grew past its compact layout");
+
 Item* Item::Create(uint16_t id, uint16_t subtype /*= 0xFFFF*/) {
 	if (id == 0) {
 		return nullptr;
@@ -66,7 +71,8 @@ Item::Item(unsigned short _type, unsigned short _count) :
 	id(_type),
 	subtype(1),
 	selected(false),
-	frame(0) {
+	frame(0),
+	shares(0) {
 	if (hasSubtype()) {
 		subtype = _count;
 	}
@@ -80,13 +86,17 @@ Item* Item::deepCopy() const {
 	Item* copy = Create(id, subtype);
 	if (copy) {
 		copy->selected = selected;
-		if (attributes) {
-			copy->attributes = newd ItemAttributeMap(*attributes);
-		}
+		copy->shareAttributes(*this);
 	}
 	return copy;
 }
 
+void Item::hashContent(ContentHasher &hasher) const {
+	hasher.add(id);
+	hasher.add(subtype);
+	hashAttributes(hasher);
+}
+
 Item* transformItem(Item* old_item, uint16_t new_id, Tile* parent) {
 	if (old_item == nullptr) {
 		return nullptr;
@@ -104,7 +114,7 @@ Item* transformItem(Item* old_item, uint16_t new_id, Tile* parent) {
 		}
 
 		std::queue<Container*> containers;
-		for (ItemVector::iterator item_iter = parent->items.begin(); item_iter != parent->items.end(); ++item_iter) {
+		for (TileItemVector::iterator item_iter = parent->items.begin(); item_iter != parent->items.end(); ++item_iter) {
 			if (*item_iter == old_item) {
 				delete old_item;
 				item_iter = parent->items.erase(item_iter);
@@ -262,11 +272,11 @@ double Item::getWeight() const {
 }
 
 void Item::setUniqueID(unsigned short n) {
-	setAttribute("uid", n);
+	setAttribute(ItemAttributeKeys::UniqueID, n);
 }
 
 void Item::setActionID(unsigned short n) {
-	setAttribute("aid", n);
+	setAttribute(ItemAttributeKeys::ActionID, n);
 }
 
 void Item::setText(const std::string &str) {
@@ -387,14 +397,14 @@ BorderType Item::getBorderAlignment() const {
 	return type.border_alignment;
 }
 
-void Item::animate() {
+void Item::animate() const {
 	const ItemType &type = g_items.getItemType(id);
 	GameSprite* sprite = type.sprite;
 	if (!sprite || !sprite->animator) {
 		return;
 	}
 
-	frame = sprite->animator->getFrame();
+	frame = static_cast<uint8_t>(sprite->animator->getFrame());
 }
 
 // ============================================================================
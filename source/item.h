@@ -22,6 +22,7 @@
 #include "iomap_otbm.h"
 // #include "iomap_otmm.h"
 #include "item_attributes.h"
+#include "item_allocator.h"
 
 enum ITEMPROPERTY {
 	BLOCKSOLID,
@@ -92,8 +93,24 @@ protected:
 public:
 	virtual ~Item();
 
+	// Items and all subclasses are pooled, see ItemAllocator
+	static void* operator new(size_t size) {
+		return ItemAllocator::allocate(size);
+	}
+	static void operator delete(void* ptr, size_t size) noexcept {
+		ItemAllocator::deallocate(ptr, size);
+	}
+#ifdef DEBUG_MEM
+	// newd passes the allocation site along, the pool does not track it
+	static void* operator new(size_t size, const char*, int) {
+		return ItemAllocator::allocate(size);
+	}
+#endif
+
 	// Deep copy thingy
 	virtual Item* deepCopy() const;
+	// Feeds everything that gets saved to the hasher, selection is left out
+	virtual void hashContent(ContentHasher &hasher) const;
 
 	// Get memory footprint size
 	uint32_t memsize() const;
@@ -366,7 +383,8 @@ public:
 	void setDescription(const std::string &str);
 	std::string getDescription() const;
 
-	void animate();
+	// Only moves the drawing frame along, also works on const items
+	void animate() const;
 	int getFrame() const {
 		return frame;
 	}
@@ -382,9 +400,16 @@ protected:
 	// Subtype is either fluid type, count, subtype or charges
 	uint16_t subtype;
 	bool selected;
-	int frame;
+	// Sprites never have more than 255 frames (GameSprite::frames)
+	mutable uint8_t frame;
 
 private:
+	// Tile slots sharing this item, see PackedItem::copy. Fits in what
+	// would otherwise be padding.
+	mutable std::atomic<uint16_t> shares;
+
+	friend class PackedItem;
+
 	Item &operator=(const Item &i); // Can't copy
 	Item(const Item &i); // Can't copy-construct
 	Item &operator==(const Item &i); // Can't compare
@@ -403,7 +428,7 @@ inline int Item::getCount() const {
 }
 
 inline uint16_t Item::getUniqueID() const {
-	const int32_t* a = getIntegerAttribute("uid");
+	const int32_t* a = attributes ? attributes->getUniqueID() : nullptr;
 	if (a) {
 		return *a;
 	}
@@ -411,7 +436,7 @@ inline uint16_t Item::getUniqueID() const {
 }
 
 inline uint16_t Item::getActionID() const {
-	const int32_t* a = getIntegerAttribute("aid");
+	const int32_t* a = attributes ? attributes->getActionID() : nullptr;
 	if (a) {
 		return *a;
 	}
@@ -0,0 +1,170 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "item_allocator.h"
+
+#include <mutex>
+
+namespace {
+	constexpr size_t ItemSizeClasses = ItemAllocator::MaxPooledSize / ItemAllocator::SizeGranularity;
+	constexpr size_t ItemSlabObjects = 2048;
+	// Blocks a thread may hold per size class, and how many move at once
+	constexpr size_t ItemCacheCapacity = 256;
+	constexpr size_t ItemCacheBatch = 64;
+
+	struct ItemSizeClass {
+		ItemSizeClass(size_t size) :
+			arena(size, ItemAllocator::SizeGranularity, ItemSlabObjects) { }
+
+		std::mutex mutex;
+		SlabArena arena;
+	};
+
+	// Never destroyed, items may still be freed while static objects are torn down
+	ItemSizeClass** getItemSizeClasses() {
+		static ItemSizeClass** classes = [] {
+			ItemSizeClass** list = newd ItemSizeClass*[ItemSizeClasses];
+			for (size_t i = 0; i < ItemSizeClasses; ++i) {
+				list[i] = newd ItemSizeClass((i + 1) * ItemAllocator::SizeGranularity);
+			}
+			return list;
+		}();
+		return classes;
+	}
+
+	size_t getItemSizeClass(size_t size) noexcept {
+		return (size + ItemAllocator::SizeGranularity - 1) / ItemAllocator::SizeGranularity - 1;
+	}
+
+	struct ItemThreadCache {
+		void* blocks[ItemSizeClasses][ItemCacheCapacity];
+		size_t count[ItemSizeClasses] = {};
+
+		void refill(size_t index) {
+			ItemSizeClass &size_class = *getItemSizeClasses()[index];
+			std::lock_guard<std::mutex> lock(size_class.mutex);
+			while (count[index] < ItemCacheBatch) {
+				blocks[index][count[index]++] = size_class.arena.allocate();
+			}
+		}
+
+		void flush(size_t index, size_t keep) noexcept {
+			ItemSizeClass &size_class = *getItemSizeClasses()[index];
+			std::lock_guard<std::mutex> lock(size_class.mutex);
+			while (count[index] > keep) {
+				size_class.arena.deallocate(blocks[index][--count[index]]);
+			}
+		}
+	};
+
+	// The cache itself is reached through plain (trivially destructible)
+	// thread locals, the guard hands the blocks back when the thread exits.
+	thread_local ItemThreadCache* item_thread_cache = nullptr;
+	thread_local bool item_thread_cache_closed = false;
+
+	struct ItemThreadCacheGuard {
+		~ItemThreadCacheGuard() {
+			if (item_thread_cache) {
+				for (size_t i = 0; i < ItemSizeClasses; ++i) {
+					item_thread_cache->flush(i, 0);
+				}
+				delete item_thread_cache;
+				item_thread_cache = nullptr;
+			}
+			item_thread_cache_closed = true;
+		}
+	};
+	thread_local ItemThreadCacheGuard item_thread_cache_guard;
+
+	ItemThreadCache* getItemThreadCache() {
+		if (!item_thread_cache && !item_thread_cache_closed) {
+			// Touching the guard registers its destructor for this thread
+			(void)&item_thread_cache_guard;
+			item_thread_cache = newd ItemThreadCache;
+		}
+		return item_thread_cache;
+	}
+}
+
+void* ItemAllocator::allocate(size_t size) {
+	if (size == 0 || size > MaxPooledSize) {
+		return ::operator new(size);
+	}
+
+	const size_t index = getItemSizeClass(size);
+	ItemThreadCache* cache = getItemThreadCache();
+	if (!cache) {
+		ItemSizeClass &size_class = *getItemSizeClasses()[index];
+		std::lock_guard<std::mutex> lock(size_class.mutex);
+		return size_class.arena.allocate();
+	}
+
+	if (cache->count[index] == 0) {
+		cache->refill(index);
+	}
+	return cache->blocks[index][--cache->count[index]];
+}
+
+void ItemAllocator::deallocate(void* ptr, size_t size) noexcept {
+	if (!ptr) {
+		return;
+	}
+
+	if (size == 0 || size > MaxPooledSize) {
+		::operator delete(ptr);
+		return;
+	}
+
+	const size_t index = getItemSizeClass(size);
+	ItemThreadCache* cache = item_thread_cache_closed ? nullptr : item_thread_cache;
+	if (!cache) {
+		ItemSizeClass &size_class = *getItemSizeClasses()[index];
+		std::lock_guard<std::mutex> lock(size_class.mutex);
+		size_class.arena.deallocate(ptr);
+		return;
+	}
+
+	if (cache->count[index] == ItemCacheCapacity) {
+		cache->flush(index, ItemCacheCapacity - ItemCacheBatch);
+	}
+	cache->blocks[index][cache->count[index]++] = ptr;
+}
+
+void ItemAllocator::trim() noexcept {
+	ItemThreadCache* cache = item_thread_cache_closed ? nullptr : item_thread_cache;
+	if (!cache) {
+		return;
+	}
+
+	for (size_t i = 0; i < ItemSizeClasses; ++i) {
+		if (cache->count[i] > 0) {
+			cache->flush(i, 0);
+		}
+	}
+}
+
+SlabPoolStats ItemAllocator::getStats() {
+	SlabPoolStats stats;
+	ItemSizeClass** classes = getItemSizeClasses();
+	for (size_t i = 0; i < ItemSizeClasses; ++i) {
+		std::lock_guard<std::mutex> lock(classes[i]->mutex);
+		stats += classes[i]->arena.getStats();
+	}
+	return stats;
+}
@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_ITEM_ALLOCATOR_H
+#define RME_ITEM_ALLOCATOR_H
+
+#include "slab_pool.h"
+
+// Size classed pool backing Item and all of its subclasses
+// Every size class is a process wide slab arena, each thread keeps a small
+// cache of free blocks in front of it so that loaders and selection threads
+// only take the arena lock once per batch. Objects larger than the biggest
+// size class go straight to the global heap.
+class ItemAllocator {
+public:
+	// Fine grained so plain 24 byte items don't get rounded up to 32
+	static constexpr size_t SizeGranularity = 8;
+	static constexpr size_t MaxPooledSize = 128;
+
+	static void* allocate(size_t size);
+	static void deallocate(void* ptr, size_t size) noexcept;
+
+	// Hands the blocks cached by the calling thread back to their arenas
+	// Cached blocks keep their slabs alive, call this after freeing many items.
+	static void trim() noexcept;
+
+	// Blocks parked in thread caches are counted as live
+	static SlabPoolStats getStats();
+};
+
+#endif
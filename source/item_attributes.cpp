@@ -19,16 +19,114 @@
 
 #include "item_attributes.h"
 #include "filehandle.h"
+#include "content_hash.h"
+
+#include <cstring>
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+	struct ItemAttributeKeyTable {
+		ItemAttributeKeyTable() {
+			add("aid");
+			add("uid");
+		}
+
+		ItemAttributeKey add(const std::string &name) {
+			const ItemAttributeKey key = static_cast<ItemAttributeKey>(names.size());
+			names.push_back(name);
+			keys.emplace(name, key);
+			return key;
+		}
+
+		std::shared_mutex mutex;
+		// deque keeps the names in place as the table grows
+		std::deque<std::string> names;
+		std::unordered_map<std::string, ItemAttributeKey> keys;
+	};
+
+	// Never destroyed, items may still be freed while static objects are torn down
+	ItemAttributeKeyTable &getItemAttributeKeyTable() {
+		static ItemAttributeKeyTable* table = newd ItemAttributeKeyTable;
+		return *table;
+	}
+}
+
+ItemAttributeKey ItemAttributeKeys::intern(const std::string &name) {
+	ItemAttributeKeyTable &table = getItemAttributeKeyTable();
+	{
+		std::shared_lock<std::shared_mutex> lock(table.mutex);
+		auto it = table.keys.find(name);
+		if (it != table.keys.end()) {
+			return it->second;
+		}
+	}
+
+	std::unique_lock<std::shared_mutex> lock(table.mutex);
+	auto it = table.keys.find(name);
+	if (it != table.keys.end()) {
+		return it->second;
+	}
+	return table.add(name);
+}
+
+bool ItemAttributeKeys::find(const std::string &name, ItemAttributeKey &key) {
+	ItemAttributeKeyTable &table = getItemAttributeKeyTable();
+	std::shared_lock<std::shared_mutex> lock(table.mutex);
+	auto it = table.keys.find(name);
+	if (it == table.keys.end()) {
+		return false;
+	}
+	key = it->second;
+	return true;
+}
+
+const std::string &ItemAttributeKeys::getName(ItemAttributeKey key) {
+	ItemAttributeKeyTable &table = getItemAttributeKeyTable();
+	std::shared_lock<std::shared_mutex> lock(table.mutex);
+	return table.names[key];
+}
+
+namespace {
+	bool entryKeyLess(const ItemAttributeList::Entry &entry, ItemAttributeKey key) {
+		return entry.key < key;
+	}
+}
+
+const ItemAttribute* ItemAttributeList::find(ItemAttributeKey key) const {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, entryKeyLess);
+	if (it != entries.end() && it->key == key) {
+		return &it->value;
+	}
+	return nullptr;
+}
+
+ItemAttribute &ItemAttributeList::get(ItemAttributeKey key) {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, entryKeyLess);
+	if (it == entries.end() || it->key != key) {
+		it = entries.insert(it, Entry { key, ItemAttribute() });
+	}
+	return it->value;
+}
+
+bool ItemAttributeList::erase(ItemAttributeKey key) {
+	auto it = std::lower_bound(entries.begin(), entries.end(), key, entryKeyLess);
+	if (it == entries.end() || it->key != key) {
+		return false;
+	}
+	entries.erase(it);
+	return true;
+}
 
 ItemAttributes::ItemAttributes() :
 	attributes(nullptr) {
 	////
 }
 
-ItemAttributes::ItemAttributes(const ItemAttributes &o) {
-	if (o.attributes) {
-		attributes = newd ItemAttributeMap(*o.attributes);
-	}
+ItemAttributes::ItemAttributes(const ItemAttributes &o) :
+	attributes(nullptr) {
+	shareAttributes(o);
 }
 
 ItemAttributes::~ItemAttributes() {
@@ -37,107 +135,155 @@ ItemAttributes::~ItemAttributes() {
 
 void ItemAttributes::createAttributes() {
 	if (!attributes) {
-		attributes = newd ItemAttributeMap;
+		attributes = newd ItemAttributeList;
+	} else if (attributes->isShared()) {
+		ItemAttributeList* copy = newd ItemAttributeList(*attributes);
+		clearAllAttributes();
+		attributes = copy;
+	}
+}
+
+void ItemAttributes::shareAttributes(const ItemAttributes &other) {
+	if (attributes == other.attributes) {
+		return;
+	}
+	clearAllAttributes();
+	if (other.attributes) {
+		attributes = other.attributes->acquire();
 	}
 }
 
 void ItemAttributes::clearAllAttributes() {
-	if (attributes) {
+	if (attributes && attributes->release()) {
 		delete attributes;
 	}
 	attributes = nullptr;
 }
 
 ItemAttributeMap ItemAttributes::getAttributes() const {
+	ItemAttributeMap map;
 	if (attributes) {
-		return *attributes;
+		for (const ItemAttributeList::Entry &entry : *attributes) {
+			map[ItemAttributeKeys::getName(entry.key)] = entry.value;
+		}
+	}
+	return map;
+}
+
+void ItemAttributes::hashAttributes(ContentHasher &hasher) const {
+	if (!attributes) {
+		hasher.add(0);
+		return;
+	}
+
+	hasher.add(attributes->size());
+	for (const ItemAttributeList::Entry &entry : *attributes) {
+		const ItemAttribute &value = entry.value;
+		hasher.add(entry.key);
+		hasher.add(value.type);
+		if (const std::string* str = value.getString()) {
+			hasher.add(*str);
+		} else if (const int32_t* integer = value.getInteger()) {
+			hasher.add(static_cast<uint32_t>(*integer));
+		} else if (const double* number = value.getFloat()) {
+			uint64_t bits;
+			std::memcpy(&bits, number, sizeof(bits));
+			hasher.add(bits);
+		} else if (const bool* boolean = value.getBoolean()) {
+			hasher.add(*boolean ? 1 : 0);
+		}
 	}
-	return ItemAttributeMap();
 }
 
 void ItemAttributes::setAttribute(const std::string &key, const ItemAttribute &value) {
-	createAttributes();
-	(*attributes)[key] = value;
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, const std::string &value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, int32_t value) {
-	createAttributes();
-	(*attributes)[key].set(value);
+	setAttribute(ItemAttributeKeys::intern(key), value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, double value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	attributes->get(ItemAttributeKeys::intern(key)).set(value);
 }
 
 void ItemAttributes::setAttribute(const std::string &key, bool value) {
 	createAttributes();
-	(*attributes)[key].set(value);
+	attributes->get(ItemAttributeKeys::intern(key)).set(value);
 }
 
-void ItemAttributes::eraseAttribute(const std::string &key) {
-	if (!attributes) {
-		return;
-	}
+void ItemAttributes::setAttribute(ItemAttributeKey key, const ItemAttribute &value) {
+	createAttributes();
+	attributes->get(key) = value;
+}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
+void ItemAttributes::setAttribute(ItemAttributeKey key, const std::string &value) {
+	createAttributes();
+	attributes->get(key).set(value);
+}
 
-	if (iter != attributes->end()) {
-		attributes->erase(iter);
-	}
+void ItemAttributes::setAttribute(ItemAttributeKey key, int32_t value) {
+	createAttributes();
+	attributes->get(key).set(value);
 }
 
-const std::string* ItemAttributes::getStringAttribute(const std::string &key) const {
-	if (!attributes) {
-		return nullptr;
+void ItemAttributes::eraseAttribute(const std::string &key) {
+	ItemAttributeKey attributeKey;
+	if (ItemAttributeKeys::find(key, attributeKey)) {
+		eraseAttribute(attributeKey);
 	}
+}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getString();
+void ItemAttributes::eraseAttribute(ItemAttributeKey key) {
+	if (!attributes || !attributes->find(key)) {
+		return;
 	}
-	return nullptr;
+	createAttributes();
+	attributes->erase(key);
 }
 
-const int32_t* ItemAttributes::getIntegerAttribute(const std::string &key) const {
+const ItemAttribute* ItemAttributes::getAttribute(ItemAttributeKey key) const {
 	if (!attributes) {
 		return nullptr;
 	}
-
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getInteger();
-	}
-	return nullptr;
+	return attributes->find(key);
 }
 
-const double* ItemAttributes::getFloatAttribute(const std::string &key) const {
+const ItemAttribute* ItemAttributes::findAttribute(const std::string &key) const {
 	if (!attributes) {
 		return nullptr;
 	}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getFloat();
+	ItemAttributeKey attributeKey;
+	if (!ItemAttributeKeys::find(key, attributeKey)) {
+		return nullptr;
 	}
-	return nullptr;
+	return attributes->find(attributeKey);
 }
 
-const bool* ItemAttributes::getBooleanAttribute(const std::string &key) const {
-	if (!attributes) {
-		return nullptr;
-	}
+const std::string* ItemAttributes::getStringAttribute(const std::string &key) const {
+	const ItemAttribute* attribute = findAttribute(key);
+	return attribute ? attribute->getString() : nullptr;
+}
 
-	ItemAttributeMap::iterator iter = attributes->find(key);
-	if (iter != attributes->end()) {
-		return iter->second.getBoolean();
-	}
-	return nullptr;
+const int32_t* ItemAttributes::getIntegerAttribute(const std::string &key) const {
+	const ItemAttribute* attribute = findAttribute(key);
+	return attribute ? attribute->getInteger() : nullptr;
+}
+
+const double* ItemAttributes::getFloatAttribute(const std::string &key) const {
+	const ItemAttribute* attribute = findAttribute(key);
+	return attribute ? attribute->getFloat() : nullptr;
+}
+
+const bool* ItemAttributes::getBooleanAttribute(const std::string &key) const {
+	const ItemAttribute* attribute = findAttribute(key);
+	return attribute ? attribute->getBoolean() : nullptr;
 }
 
 bool ItemAttributes::hasStringAttribute(const std::string &key) const {
@@ -291,7 +437,7 @@ bool ItemAttributes::unserializeAttributeMap(const IOMap &maphandle, BinaryNode*
 			if (!attrib.unserialize(maphandle, stream)) {
 				return false;
 			}
-			(*attributes)[key] = attrib;
+			attributes->get(ItemAttributeKeys::intern(key)) = attrib;
 		}
 	}
 	return true;
@@ -301,17 +447,28 @@ void ItemAttributes::serializeAttributeMap(const IOMap &maphandle, NodeFileWrite
 	// Maximum of 65535 attributes per item
 	f.addU16(std::min((size_t)0xFFFF, attributes->size()));
 
-	ItemAttributeMap::const_iterator attribute = attributes->begin();
+	// Written in name order, the same order the attributes were kept in
+	// before keys were interned, so saved maps stay byte for byte the same
+	std::vector<std::pair<const std::string*, const ItemAttribute*>> sorted;
+	sorted.reserve(attributes->size());
+	for (const ItemAttributeList::Entry &entry : *attributes) {
+		sorted.emplace_back(&ItemAttributeKeys::getName(entry.key), &entry.value);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const auto &lhs, const auto &rhs) {
+		return *lhs.first < *rhs.first;
+	});
+
+	auto attribute = sorted.begin();
 	int i = 0;
-	while (attribute != attributes->end() && i <= 0xFFFF) {
-		const std::string &key = attribute->first;
+	while (attribute != sorted.end() && i <= 0xFFFF) {
+		const std::string &key = *attribute->first;
 		if (key.size() > 0xFFFF) {
 			f.addString(key.substr(0, 65535));
 		} else {
 			f.addString(key);
 		}
 
-		attribute->second.serialize(maphandle, f);
+		attribute->second->serialize(maphandle, f);
 		++attribute, ++i;
 	}
 }
@@ -18,13 +18,16 @@
 #ifndef RME_ITEM_ATTRIBUTES_H_
 #define RME_ITEM_ATTRIBUTES_H_
 
+#include <atomic>
 #include <string>
 #include <map>
+#include <vector>
 
 #include "filehandle.h"
 
 class IOMap;
 class ItemAttribute;
+class ContentHasher;
 
 class PropWriteStream;
 class PropStream;
@@ -65,11 +68,95 @@ public:
 	const bool* getBoolean() const;
 
 private:
-	char data[sizeof(std::string) > sizeof(double) ? sizeof(std::string) : sizeof(double)];
+	alignas(std::string) alignas(double) char data[sizeof(std::string) > sizeof(double) ? sizeof(std::string) : sizeof(double)];
 };
 
+// Name -> value view of the attributes, used by the properties window
 typedef std::map<std::string, ItemAttribute> ItemAttributeMap;
 
+// Attribute names are interned in a process wide table, items only keep the key
+typedef uint32_t ItemAttributeKey;
+
+class ItemAttributeKeys {
+public:
+	// Reserved keys, these sort in front of every other attribute
+	static constexpr ItemAttributeKey ActionID = 0; // "aid"
+	static constexpr ItemAttributeKey UniqueID = 1; // "uid"
+
+	static ItemAttributeKey intern(const std::string &name);
+	// Returns false if no attribute was ever called name
+	static bool find(const std::string &name, ItemAttributeKey &key);
+	static const std::string &getName(ItemAttributeKey key);
+};
+
+// Flat list of attributes sorted by key
+// Copies of an item share one list, ItemAttributes clones it before the
+// first change so a tile copy made for undo doesn't copy any attribute.
+class ItemAttributeList {
+public:
+	struct Entry {
+		ItemAttributeKey key;
+		ItemAttribute value;
+	};
+	typedef std::vector<Entry>::const_iterator const_iterator;
+
+	ItemAttributeList() = default;
+	// The copy starts out unshared
+	ItemAttributeList(const ItemAttributeList &other) :
+		entries(other.entries) { }
+	ItemAttributeList &operator=(const ItemAttributeList &) = delete;
+
+	ItemAttributeList* acquire() noexcept {
+		refs.fetch_add(1, std::memory_order_relaxed);
+		return this;
+	}
+	// Returns true once the last owner let go
+	bool release() noexcept {
+		return refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+	}
+	bool isShared() const noexcept {
+		return refs.load(std::memory_order_acquire) > 1;
+	}
+
+	const ItemAttribute* find(ItemAttributeKey key) const;
+	// Inserts an empty attribute if there is none yet
+	ItemAttribute &get(ItemAttributeKey key);
+	bool erase(ItemAttributeKey key);
+
+	// Action and unique ids always sit in the first two slots
+	const int32_t* getActionID() const {
+		if (!entries.empty() && entries.front().key == ItemAttributeKeys::ActionID) {
+			return entries.front().value.getInteger();
+		}
+		return nullptr;
+	}
+	const int32_t* getUniqueID() const {
+		for (size_t i = 0; i < entries.size() && i < 2; ++i) {
+			if (entries[i].key == ItemAttributeKeys::UniqueID) {
+				return entries[i].value.getInteger();
+			}
+		}
+		return nullptr;
+	}
+
+	bool empty() const noexcept {
+		return entries.empty();
+	}
+	size_t size() const noexcept {
+		return entries.size();
+	}
+	const_iterator begin() const noexcept {
+		return entries.begin();
+	}
+	const_iterator end() const noexcept {
+		return entries.end();
+	}
+
+private:
+	std::vector<Entry> entries;
+	std::atomic<uint32_t> refs { 1 };
+};
+
 class ItemAttributes {
 public:
 	ItemAttributes();
@@ -86,12 +173,16 @@ public:
 	void setAttribute(const std::string &key, int32_t value);
 	void setAttribute(const std::string &key, double value);
 	void setAttribute(const std::string &key, bool set);
+	void setAttribute(ItemAttributeKey key, const ItemAttribute &attr);
+	void setAttribute(ItemAttributeKey key, const std::string &value);
+	void setAttribute(ItemAttributeKey key, int32_t value);
 
 	// returns nullptr if the attribute is not set
 	const std::string* getStringAttribute(const std::string &key) const;
 	const int32_t* getIntegerAttribute(const std::string &key) const;
 	const double* getFloatAttribute(const std::string &key) const;
 	const bool* getBooleanAttribute(const std::string &key) const;
+	const ItemAttribute* getAttribute(ItemAttributeKey key) const;
 
 	// Returns true if the attribute (of that type) exists
 	bool hasStringAttribute(const std::string &key) const;
@@ -100,14 +191,25 @@ public:
 	bool hasBooleanAttribute(const std::string &key) const;
 
 	void eraseAttribute(const std::string &key);
+	void eraseAttribute(ItemAttributeKey key);
 
 	void clearAllAttributes();
 	ItemAttributeMap getAttributes() const;
 
+	// Keys go in as interned ids, so hashes only compare within one process
+	void hashAttributes(ContentHasher &hasher) const;
+
 protected:
-	ItemAttributeMap* attributes;
+	// Looks the name up without interning it
+	const ItemAttribute* findAttribute(const std::string &key) const;
+
+	ItemAttributeList* attributes;
 
+	// Makes sure there is a list that no other item shares, call it before
+	// changing anything in it
 	void createAttributes();
+	// Drops the list and shares the one of other instead
+	void shareAttributes(const ItemAttributes &other);
 };
 
 #endif
@@ -0,0 +1,147 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "item_index.h"
+#include "tile.h"
+#include "item.h"
+#include "complexitem.h"
+
+void MapItemIndex::Table::add(uint16_t key, uint32_t block) {
+	if (key >= lists.size()) {
+		lists.resize(key + 1);
+	}
+
+	BlockList &list = lists[key];
+	auto it = std::lower_bound(list.begin(), list.end(), block, [](const BlockCount &entry, uint32_t block) {
+		return entry.block < block;
+	});
+	if (it != list.end() && it->block == block) {
+		++it->count;
+	} else {
+		list.insert(it, BlockCount { block, 1 });
+	}
+}
+
+void MapItemIndex::Table::remove(uint16_t key, uint32_t block) {
+	if (key >= lists.size()) {
+		return;
+	}
+
+	BlockList &list = lists[key];
+	auto it = std::lower_bound(list.begin(), list.end(), block, [](const BlockCount &entry, uint32_t block) {
+		return entry.block < block;
+	});
+	if (it != list.end() && it->block == block && --it->count == 0) {
+		list.erase(it);
+	}
+}
+
+const MapItemIndex::BlockList &MapItemIndex::Table::get(uint16_t key) const {
+	static const BlockList empty;
+	return key < lists.size() ? lists[key] : empty;
+}
+
+void MapItemIndex::Table::clear() {
+	lists.clear();
+}
+
+void MapItemIndex::addTile(const Tile* tile, int x, int y) {
+	update(tile, x, y, true);
+}
+
+void MapItemIndex::removeTile(const Tile* tile, int x, int y) {
+	update(tile, x, y, false);
+}
+
+void MapItemIndex::clear() {
+	items.clear();
+	actions.clear();
+	uniques.clear();
+}
+
+uint32_t MapItemIndex::getUniqueCount(uint16_t uid) const {
+	uint32_t count = 0;
+	for (const BlockCount &entry : uniques.get(uid)) {
+		count += entry.count;
+	}
+	return count;
+}
+
+uint32_t MapItemIndex::getBlockKey(int x, int y) noexcept {
+	// One hex digit per tree level below the block, the root's first
+	const uint32_t block_x = (static_cast<uint32_t>(x) & 0xFFFF) >> BlockShift;
+	const uint32_t block_y = (static_cast<uint32_t>(y) & 0xFFFF) >> BlockShift;
+	uint32_t key = 0;
+	for (uint32_t level = 0; level < 5; ++level) {
+		const uint32_t digit = ((block_x >> (level * 2)) & 3) | (((block_y >> (level * 2)) & 3) << 2);
+		key |= digit << (level * 4);
+	}
+	return key;
+}
+
+void MapItemIndex::getBlockOrigin(uint32_t block, int &x, int &y) noexcept {
+	uint32_t block_x = 0;
+	uint32_t block_y = 0;
+	for (uint32_t level = 0; level < 5; ++level) {
+		const uint32_t digit = (block >> (level * 4)) & 0xF;
+		block_x |= (digit & 3) << (level * 2);
+		block_y |= (digit >> 2) << (level * 2);
+	}
+	x = static_cast<int>(block_x << BlockShift);
+	y = static_cast<int>(block_y << BlockShift);
+}
+
+void MapItemIndex::update(const Tile* tile, int x, int y, bool add) {
+	const uint32_t block = getBlockKey(x, y);
+	if (tile->ground) {
+		PackedItem scratch;
+		updateItem(scratch.peek(tile->ground.getSlot()), block, add);
+	}
+	for (const Item* item : tile->items.peek()) {
+		updateItem(item, block, add);
+	}
+}
+
+void MapItemIndex::updateItem(const Item* item, uint32_t block, bool add) {
+	const uint16_t aid = item->getActionID();
+	const uint16_t uid = item->getUniqueID();
+	if (add) {
+		items.add(item->getID(), block);
+		if (aid != 0) {
+			actions.add(aid, block);
+		}
+		if (uid != 0) {
+			uniques.add(uid, block);
+		}
+	} else {
+		items.remove(item->getID(), block);
+		if (aid != 0) {
+			actions.remove(aid, block);
+		}
+		if (uid != 0) {
+			uniques.remove(uid, block);
+		}
+	}
+
+	if (const Container* container = dynamic_cast<const Container*>(item)) {
+		for (const Item* content : container->getVector()) {
+			updateItem(content, block, add);
+		}
+	}
+}
@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_ITEM_INDEX_H
+#define RME_ITEM_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+class Tile;
+class Item;
+
+// Inverted index from item ids, action ids and unique ids to the map blocks holding them
+// The map is cut into blocks of 64x64 tiles spanning all floors, for every id
+// the index counts the matching items of each block, items inside containers
+// included. A query only has to look at the blocks listed for its id, which
+// are kept in map iteration order so results come out as with a full scan.
+// Kept up to date by Map whenever a tile is placed, swapped or removed.
+class MapItemIndex {
+public:
+	static constexpr int BlockShift = 6;
+	static constexpr int BlockSize = 1 << BlockShift;
+
+	struct BlockCount {
+		uint32_t block;
+		uint32_t count;
+	};
+	typedef std::vector<BlockCount> BlockList;
+
+	void addTile(const Tile* tile, int x, int y);
+	void removeTile(const Tile* tile, int x, int y);
+	void clear();
+
+	const BlockList &getItemBlocks(uint16_t id) const {
+		return items.get(id);
+	}
+	const BlockList &getActionBlocks(uint16_t aid) const {
+		return actions.get(aid);
+	}
+	const BlockList &getUniqueBlocks(uint16_t uid) const {
+		return uniques.get(uid);
+	}
+	// Number of items on the map carrying the unique id
+	uint32_t getUniqueCount(uint16_t uid) const;
+
+	// Blocks sort in the same order as MapIterator visits them
+	static uint32_t getBlockKey(int x, int y) noexcept;
+	// First tile of a block
+	static void getBlockOrigin(uint32_t block, int &x, int &y) noexcept;
+
+private:
+	class Table {
+	public:
+		void add(uint16_t key, uint32_t block);
+		void remove(uint16_t key, uint32_t block);
+		const BlockList &get(uint16_t key) const;
+		void clear();
+
+	private:
+		std::vector<BlockList> lists; // By key, grown on demand
+	};
+
+	void update(const Tile* tile, int x, int y, bool add);
+	void updateItem(const Item* item, uint32_t block, bool add);
+
+	Table items;
+	Table actions;
+	Table uniques;
+};
+
+#endif
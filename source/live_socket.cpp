@@ -194,14 +194,10 @@ void LiveSocket::receiveFloor(NetworkMessage &message, Editor &editor, Action* a
 
 void LiveSocket::sendFloor(NetworkMessage &message, Floor* floor) {
 	uint16_t tileBits = 0;
-	for (uint_fast8_t x = 0; x < 4; ++x) {
-		for (uint_fast8_t y = 0; y < 4; ++y) {
-			uint_fast8_t index = (x * 4) + y;
-
-			Tile* tile = floor->locs[index].get();
-			if (tile && tile->size() > 0) {
-				tileBits |= (1 << index);
-			}
+	for (uint32_t occupied = floor->occupied; occupied != 0; occupied &= occupied - 1) {
+		const int index = std::countr_zero(occupied);
+		if (floor->locs[index].get()->size() > 0) {
+			tileBits |= (1 << index);
 		}
 	}
 
@@ -254,8 +250,10 @@ void LiveSocket::sendTile(MemoryNodeFileWriteHandle &writer, Tile* tile, const P
 		writer.addU32(tile->getMapFlags());
 	}
 
-	Item* ground = tile->ground;
-	if (ground) {
+	// Peek, sending a tile should not unpack its items
+	PackedItem scratch;
+	if (tile->ground) {
+		const Item* ground = scratch.peek(tile->ground.getSlot());
 		if (ground->isComplex()) {
 			ground->serializeItemNode_OTBM(mapVersion, writer);
 		} else {
@@ -264,7 +262,7 @@ void LiveSocket::sendTile(MemoryNodeFileWriteHandle &writer, Tile* tile, const P
 		}
 	}
 
-	for (Item* item : tile->items) {
+	for (const Item* item : tile->items.peek()) {
 		item->serializeItemNode_OTBM(mapVersion, writer);
 	}
 
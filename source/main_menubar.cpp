@@ -119,6 +119,7 @@ MainMenuBar::MainMenuBar(MainFrame* frame) :
 	MAKE_ACTION(MAP_REMOVE_UNREACHABLE_TILES, wxITEM_NORMAL, OnMapRemoveUnreachable);
 	MAKE_ACTION(MAP_REMOVE_EMPTY_MONSTERS_SPAWNS, wxITEM_NORMAL, OnMapRemoveEmptyMonsterSpawns);
 	MAKE_ACTION(MAP_REMOVE_EMPTY_NPCS_SPAWNS, wxITEM_NORMAL, OnMapRemoveEmptyNpcSpawns);
+	MAKE_ACTION(MAP_COMPACT_MEMORY, wxITEM_NORMAL, OnMapCompactMemory);
 	MAKE_ACTION(MAP_CLEANUP, wxITEM_NORMAL, OnMapCleanup);
 	MAKE_ACTION(MAP_CLEAN_HOUSE_ITEMS, wxITEM_NORMAL, OnMapCleanHouseItems);
 	MAKE_ACTION(MAP_PROPERTIES, wxITEM_NORMAL, OnMapProperties);
@@ -253,7 +254,7 @@ namespace OnMapRemoveItems {
 
 		uint16_t itemId;
 
-		bool operator()(Map &map, Item* item, int64_t removed, int64_t done) {
+		bool operator()(Map &map, const Item* item, int64_t removed, int64_t done) {
 			if (done % 0x8000 == 0) {
 				g_gui.SetLoadDone((uint32_t)(100 * done / map.getTileCount()));
 			}
@@ -381,6 +382,7 @@ void MainMenuBar::Update() {
 	EnableItem(MAP_REMOVE_UNREACHABLE_TILES, is_local);
 	EnableItem(MAP_REMOVE_EMPTY_MONSTERS_SPAWNS, is_local);
 	EnableItem(MAP_REMOVE_EMPTY_NPCS_SPAWNS, is_local);
+	EnableItem(MAP_COMPACT_MEMORY, is_local);
 	EnableItem(CLEAR_INVALID_HOUSES, is_local);
 	EnableItem(CLEAR_MODIFIED_STATE, is_local);
 
@@ -914,9 +916,9 @@ namespace OnSearchForItem {
 			return result.size() >= (size_t)maxCount;
 		}
 
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
+		bool operator()(Map &map, Tile* tile, const Item* item, long long done) {
 			if (result.size() >= (size_t)maxCount) {
-				return;
+				return false;
 			}
 
 			if (done % 0x8000 == 0) {
@@ -924,32 +926,32 @@ namespace OnSearchForItem {
 			}
 
 			if (item->getID() == itemId) {
-				result.push_back(std::make_pair(tile, item));
+				return true;
 			}
 
 			if (!findTile) {
-				return;
+				return false;
 			}
 
 			if (tile->isHouseTile()) {
-				return;
+				return false;
 			}
 
 			const auto &tileSearchType = static_cast<FindItemDialog::SearchTileType>(g_settings.getInteger(Config::FIND_TILE_TYPE));
 			if (tileSearchType == FindItemDialog::SearchTileType::NoLogout && !tile->isNoLogout()) {
-				return;
+				return false;
 			}
 
 			if (tileSearchType == FindItemDialog::SearchTileType::PlayerVsPlayer && !tile->isPVP()) {
-				return;
+				return false;
 			}
 
 			if (tileSearchType == FindItemDialog::SearchTileType::NoPlayerVsPlayer && !tile->isNoPVP()) {
-				return;
+				return false;
 			}
 
 			if (tileSearchType == FindItemDialog::SearchTileType::ProtectionZone && !tile->isPZ()) {
-				return;
+				return false;
 			}
 
 			const auto it = std::ranges::find_if(result, [&tile](const auto &pair) {
@@ -957,10 +959,15 @@ namespace OnSearchForItem {
 			});
 
 			if (it != result.end()) {
-				return;
+				return false;
 			}
 
 			result.push_back(std::make_pair(tile, nullptr));
+			return false;
+		}
+
+		void add(Tile* tile, Item* item) {
+			result.push_back(std::make_pair(tile, item));
 		}
 	};
 }
@@ -982,7 +989,11 @@ void MainMenuBar::OnSearchForItem(wxCommandEvent &WXUNUSED(event)) {
 
 		g_gui.CreateLoadBar("Searching map...");
 
-		foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, false);
+		if (finder.findTile) {
+			foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, false);
+		} else {
+			foreach_ItemWithIdOnMap(g_gui.GetCurrentMap(), finder.itemId, finder, false);
+		}
 		std::vector<std::pair<Tile*, Item*>> &result = finder.result;
 
 		g_gui.DestroyLoadBar();
@@ -1049,14 +1060,18 @@ namespace OnSearchForStuff {
 		bool search_writeable;
 		std::vector<std::pair<Tile*, Item*>> found;
 
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
-			if (done % 0x8000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
-			}
-			Container* container;
-			if ((search_unique && item->getUniqueID() > 0) || (search_action && item->getActionID() > 0) || (search_container && ((container = dynamic_cast<Container*>(item)) && container->getItemCount())) || (search_writeable && item && item->getText().length() > 0)) {
-				found.push_back(std::make_pair(tile, item));
-			}
+		// Only reads the item, it is called from all threads while looking for tiles
+		bool matches(const Item* item) const {
+			const Container* container;
+			return (search_unique && item->getUniqueID() > 0) || (search_action && item->getActionID() > 0) || (search_container && ((container = dynamic_cast<const Container*>(item)) && container->getItemCount())) || (search_writeable && item && item->getText().length() > 0);
+		}
+
+		bool operator()(Map &map, Tile* tile, const Item* item, long long done) {
+			return matches(item);
+		}
+
+		void add(Tile* tile, Item* item) {
+			found.push_back(std::make_pair(tile, item));
 		}
 
 		wxString desc(Item* item) {
@@ -1154,7 +1169,7 @@ void MainMenuBar::OnSearchForItemOnSelection(wxCommandEvent &WXUNUSED(event)) {
 		OnSearchForItem::Finder finder(dialog.getResultID(), (uint32_t)g_settings.getInteger(Config::REPLACE_SIZE));
 		g_gui.CreateLoadBar("Searching on selected area...");
 
-		foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, true);
+		foreach_ItemWithIdOnMap(g_gui.GetCurrentMap(), finder.itemId, finder, true);
 		std::vector<std::pair<Tile*, Item*>> &result = finder.result;
 
 		g_gui.DestroyLoadBar();
@@ -1396,7 +1411,7 @@ namespace OnMapRemoveCorpses {
 	struct condition {
 		condition() { }
 
-		bool operator()(Map &map, Item* item, long long removed, long long done) {
+		bool operator()(Map &map, const Item* item, long long removed, long long done) {
 			if (done % 0x800 == 0) {
 				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
 			}
@@ -1524,19 +1539,19 @@ void MainMenuBar::OnMapRemoveEmptyMonsterSpawns(wxCommandEvent &WXUNUSED(event))
 		TileVector toDeleteSpawns;
 		for (const auto &spawnPosition : map.spawnsMonster) {
 			Tile* tile = map.getTile(spawnPosition);
-			if (!tile || !tile->spawnMonster) {
+			if (!tile || !tile->getSpawnMonster()) {
 				continue;
 			}
 
-			const int32_t radius = tile->spawnMonster->getSize();
+			const int32_t radius = tile->getSpawnMonster()->getSize();
 
 			bool empty = true;
 			for (int32_t y = -radius; y <= radius; ++y) {
 				for (int32_t x = -radius; x <= radius; ++x) {
 					Tile* creature_tile = map.getTile(spawnPosition + Position(x, y, 0));
-					if (creature_tile && creature_tile->monster && !creature_tile->monster->isSaved()) {
-						creature_tile->monster->save();
-						monster.push_back(creature_tile->monster);
+					if (creature_tile && creature_tile->getMonster() && !creature_tile->getMonster()->isSaved()) {
+						creature_tile->getMonster()->save();
+						monster.push_back(creature_tile->getMonster());
 						empty = false;
 					}
 				}
@@ -1559,8 +1574,8 @@ void MainMenuBar::OnMapRemoveEmptyMonsterSpawns(wxCommandEvent &WXUNUSED(event))
 		for (const auto &tile : toDeleteSpawns) {
 			Tile* newtile = tile->deepCopy(map);
 			map.removeSpawnMonster(newtile);
-			delete newtile->spawnMonster;
-			newtile->spawnMonster = nullptr;
+			delete newtile->getSpawnMonster();
+			newtile->setSpawnMonster(nullptr);
 			if (++removed % 5 == 0) {
 				// update progress bar for each 5 spawns removed
 				g_gui.SetLoadDone(100 * removed / count);
@@ -1597,19 +1612,19 @@ void MainMenuBar::OnMapRemoveEmptyNpcSpawns(wxCommandEvent &WXUNUSED(event)) {
 		TileVector toDeleteSpawns;
 		for (const auto &spawnPosition : map.spawnsNpc) {
 			Tile* tile = map.getTile(spawnPosition);
-			if (!tile || !tile->spawnNpc) {
+			if (!tile || !tile->getSpawnNpc()) {
 				continue;
 			}
 
-			const int32_t radius = tile->spawnNpc->getSize();
+			const int32_t radius = tile->getSpawnNpc()->getSize();
 
 			bool empty = true;
 			for (int32_t y = -radius; y <= radius; ++y) {
 				for (int32_t x = -radius; x <= radius; ++x) {
 					Tile* creature_tile = map.getTile(spawnPosition + Position(x, y, 0));
-					if (creature_tile && creature_tile->npc && !creature_tile->npc->isSaved()) {
-						creature_tile->npc->save();
-						npc.push_back(creature_tile->npc);
+					if (creature_tile && creature_tile->getNpc() && !creature_tile->getNpc()->isSaved()) {
+						creature_tile->getNpc()->save();
+						npc.push_back(creature_tile->getNpc());
 						empty = false;
 					}
 				}
@@ -1632,8 +1647,8 @@ void MainMenuBar::OnMapRemoveEmptyNpcSpawns(wxCommandEvent &WXUNUSED(event)) {
 		for (const auto &tile : toDeleteSpawns) {
 			Tile* newtile = tile->deepCopy(map);
 			map.removeSpawnNpc(newtile);
-			delete newtile->spawnNpc;
-			newtile->spawnNpc = nullptr;
+			delete newtile->getSpawnNpc();
+			newtile->setSpawnNpc(nullptr);
 			if (++removed % 5 == 0) {
 				// update progress bar for each 5 spawns removed
 				g_gui.SetLoadDone(100 * removed / count);
@@ -1693,6 +1708,38 @@ void MainMenuBar::OnClearModifiedState(wxCommandEvent &WXUNUSED(event)) {
 	g_gui.RefreshView();
 }
 
+void MainMenuBar::OnMapCompactMemory(wxCommandEvent &WXUNUSED(event)) {
+	Editor* editor = g_gui.GetCurrentEditor();
+	if (!editor) {
+		return;
+	}
+
+	int ret = g_gui.PopupDialog(
+		"Compact Map Memory",
+		"This frees the memory held by empty parts of the map and clears the undo history. Do you want to proceed?",
+		wxYES | wxNO
+	);
+	if (ret != wxID_YES) {
+		return;
+	}
+
+	// The map is not compacted while a background save reads it, let the save finish first
+	editor->waitForSave();
+
+	// Tiles in the undo history still point into the map
+	editor->getSelection().clear();
+	editor->clearActions();
+
+	const MapCompactionStats stats = editor->getMap().compact();
+	editor->getMap().relayout();
+	ItemAllocator::trim();
+
+	wxString msg;
+	msg << stats.floors << " floors and " << stats.nodes << " nodes freed, " << (stats.bytes / 1024) << " KB reclaimed.";
+	g_gui.PopupDialog("Compact Map Memory", msg, wxOK);
+	g_gui.RefreshView();
+}
+
 void MainMenuBar::OnMapCleanHouseItems(wxCommandEvent &WXUNUSED(event)) {
 	Editor* editor = g_gui.GetCurrentEditor();
 	if (!editor) {
@@ -1738,27 +1785,28 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 
 	Map* map = &g_gui.GetCurrentMap();
 
-	int load_counter = 0;
+	// The counters are kept up to date by the map
+	const TileStatistics stats = map->getStatistics().getTotal();
 
-	uint64_t tile_count = 0;
-	uint64_t detailed_tile_count = 0;
-	uint64_t blocking_tile_count = 0;
-	uint64_t walkable_tile_count = 0;
+	const uint64_t tile_count = stats.tile_count;
+	const uint64_t detailed_tile_count = stats.detailed_tile_count;
+	const uint64_t blocking_tile_count = stats.blocking_tile_count;
+	const uint64_t walkable_tile_count = stats.walkable_tile_count;
 	double percent_pathable = 0.0;
 	double percent_detailed = 0.0;
-	uint64_t spawn_monster_count = 0;
-	uint64_t spawn_npc_count = 0;
-	uint64_t monster_count = 0;
-	uint64_t npc_count = 0;
+	const uint64_t spawn_monster_count = stats.spawn_monster_count;
+	const uint64_t spawn_npc_count = stats.spawn_npc_count;
+	const uint64_t monster_count = stats.monster_count;
+	const uint64_t npc_count = stats.npc_count;
 	double monsters_per_spawn = 0.0;
 	double npcs_per_spawn = 0.0;
 
-	uint64_t item_count = 0;
-	uint64_t loose_item_count = 0;
-	uint64_t depot_count = 0;
-	uint64_t action_item_count = 0;
-	uint64_t unique_item_count = 0;
-	uint64_t container_count = 0; // Only includes containers containing more than 1 item
+	const uint64_t item_count = stats.item_count;
+	const uint64_t loose_item_count = stats.loose_item_count;
+	const uint64_t depot_count = stats.depot_count;
+	const uint64_t action_item_count = stats.action_item_count;
+	const uint64_t unique_item_count = stats.unique_item_count;
+	const uint64_t container_count = stats.container_count;
 
 	int town_count = map->towns.count();
 	int house_count = map->houses.count();
@@ -1772,88 +1820,12 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 	double sqm_per_house = 0.0;
 	double sqm_per_town = 0.0;
 
-	for (MapIterator mit = map->begin(); mit != map->end(); ++mit) {
-		Tile* tile = (*mit)->get();
-		if (load_counter % 8192 == 0) {
-			g_gui.SetLoadDone((unsigned int)(int64_t(load_counter) * 95ll / int64_t(map->getTileCount())));
-		}
-
-		if (tile->empty()) {
-			continue;
-		}
-
-		tile_count += 1;
-
-		bool is_detailed = false;
-#define ANALYZE_ITEM(_item)                                             \
-	{                                                                   \
-		item_count += 1;                                                \
-		if (!(_item)->isGroundTile() && !(_item)->isBorder()) {         \
-			is_detailed = true;                                         \
-			const ItemType &it = g_items.getItemType((_item)->getID()); \
-			if (it.moveable) {                                          \
-				loose_item_count += 1;                                  \
-			}                                                           \
-			if (it.isDepot()) {                                         \
-				depot_count += 1;                                       \
-			}                                                           \
-			if ((_item)->getActionID() > 0) {                           \
-				action_item_count += 1;                                 \
-			}                                                           \
-			if ((_item)->getUniqueID() > 0) {                           \
-				unique_item_count += 1;                                 \
-			}                                                           \
-			if (Container* c = dynamic_cast<Container*>((_item))) {     \
-				if (c->getVector().size()) {                            \
-					container_count += 1;                               \
-				}                                                       \
-			}                                                           \
-		}                                                               \
-	}
-		if (tile->ground) {
-			ANALYZE_ITEM(tile->ground);
-		}
-
-		for (Item* item : tile->items) {
-			ANALYZE_ITEM(item);
-		}
-#undef ANALYZE_ITEM
-
-		if (tile->spawnMonster) {
-			spawn_monster_count += 1;
-		}
-
-		if (tile->spawnNpc) {
-			spawn_npc_count += 1;
-		}
-
-		if (tile->monster) {
-			monster_count += 1;
-		}
-
-		if (tile->npc) {
-			npc_count += 1;
-		}
-
-		if (tile->isBlocking()) {
-			blocking_tile_count += 1;
-		} else {
-			walkable_tile_count += 1;
-		}
-
-		if (is_detailed) {
-			detailed_tile_count += 1;
-		}
-
-		load_counter += 1;
-	}
-
 	monsters_per_spawn = (spawn_monster_count != 0 ? double(monster_count) / double(spawn_monster_count) : -1.0);
 	npcs_per_spawn = (spawn_npc_count != 0 ? double(npc_count) / double(spawn_npc_count) : -1.0);
 	percent_pathable = 100.0 * (tile_count != 0 ? double(walkable_tile_count) / double(tile_count) : -1.0);
 	percent_detailed = 100.0 * (tile_count != 0 ? double(detailed_tile_count) / double(tile_count) : -1.0);
 
-	load_counter = 0;
+	int load_counter = 0;
 	Houses &houses = map->houses;
 	for (HouseMap::const_iterator hit = houses.begin(); hit != houses.end(); ++hit) {
 		const House* house = hit->second;
@@ -1862,12 +1834,13 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 			g_gui.SetLoadDone((unsigned int)(95ll + int64_t(load_counter) * 5ll / int64_t(house_count)));
 		}
 
-		if (house->size() > largest_house_size) {
+		const uint64_t house_size = house->size();
+		if (house_size > largest_house_size) {
 			largest_house = house;
-			largest_house_size = house->size();
+			largest_house_size = house_size;
 		}
-		total_house_sqm += house->size();
-		town_sqm_count[house->townid] += house->size();
+		total_house_sqm += house_size;
+		town_sqm_count[house->townid] += house_size;
 	}
 
 	houses_per_town = (town_count != 0 ? double(house_count) / double(town_count) : -1.0);
@@ -1950,6 +1923,19 @@ void MainMenuBar::OnMapStatistics(wxCommandEvent &WXUNUSED(event)) {
 		os << "\t\tLargest House: \"" << largest_house->name << "\" (" << largest_house_size << " sqm)\n";
 	}
 
+	const MapAllocatorStats allocator_stats = map->allocator.getStats();
+	const SlabPoolStats allocator_total = allocator_stats.getTotal();
+	os << "\tMemory data:\n";
+	os << "\t\tLive tiles (all maps): " << allocator_stats.tiles.live_objects << "\n";
+	os << "\t\tLive floors: " << allocator_stats.floors.live_objects << "\n";
+	os << "\t\tLive tree nodes: " << allocator_stats.nodes.live_objects << "\n";
+	os << "\t\tReserved memory: " << allocator_total.reserved_bytes / 1024 << " KiB\n";
+	os << "\t\tFragmentation: " << allocator_total.getFragmentation() * 100.0 << "%\n";
+	const SlabPoolStats item_pool_stats = ItemAllocator::getStats();
+	os << "\t\tPooled items (all maps): " << item_pool_stats.live_objects << "\n";
+	os << "\t\tReserved item memory: " << item_pool_stats.reserved_bytes / 1024 << " KiB\n";
+	os << "\t\tItem pool fragmentation: " << item_pool_stats.getFragmentation() * 100.0 << "%\n";
+
 	os << "\n";
 	os << "Generated by Remere's Map Editor version " + __RME_VERSION__ + "\n";
 
@@ -2345,7 +2331,23 @@ void MainMenuBar::SearchItems(bool unique, bool action, bool container, bool wri
 	searcher.search_container = container;
 	searcher.search_writeable = writable;
 
-	foreach_ItemOnMap(g_gui.GetCurrentMap(), searcher, onSelection);
+	// Only the tiles found are walked again to pick up the items themselves
+	Map &map = g_gui.GetCurrentMap();
+	const std::vector<Tile*> tiles = find_TilesOnMap(
+		map,
+		[&searcher](const Tile* tile) {
+			return any_ItemOnTile(tile, [&searcher](const Item* item) {
+				return searcher.matches(item);
+			});
+		},
+		onSelection,
+		[](size_t done, size_t total) {
+			g_gui.SetLoadDone(static_cast<unsigned int>(100 * done / total));
+		}
+	);
+	for (Tile* tile : tiles) {
+		foreach_ItemOnTile(map, tile, searcher, 0);
+	}
 	searcher.sort();
 	std::vector<std::pair<Tile*, Item*>> &found = searcher.found;
 
@@ -2384,38 +2386,17 @@ void MainMenuBar::OnSearchForWallsUponWallsOnSelection(wxCommandEvent &WXUNUSED(
 }
 
 namespace SearchDuplicatedItems {
-	struct condition {
-		std::unordered_set<Tile*> foundTiles;
-
-		void operator()(Map &map, Tile* tile, Item* item, long long done) {
-			if (done % 0x8000 == 0) {
-				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
-			}
-
-			if (!tile) {
-				return;
-			}
-
-			if (!item) {
-				return;
-			}
-
-			if (item->isGroundTile()) {
-				return;
-			}
-
-			if (foundTiles.count(tile) == 0) {
-				std::unordered_set<int> itemIDs;
-				for (Item* existingItem : tile->items) {
-					if (itemIDs.count(existingItem->getID()) > 0) {
-						foundTiles.insert(tile);
-						break;
-					}
-					itemIDs.insert(existingItem->getID());
-				}
+	// Only reads the tile, it is called from all threads
+	bool condition(const Tile* tile) {
+		std::unordered_set<int> itemIDs;
+		for (const Item* item : tile->items.peek()) {
+			if (itemIDs.count(item->getID()) > 0) {
+				return true;
 			}
+			itemIDs.insert(item->getID());
 		}
-	};
+		return false;
+	}
 }
 
 void MainMenuBar::SearchDuplicatedItems(bool onSelection /* = false*/) {
@@ -2429,10 +2410,9 @@ void MainMenuBar::SearchDuplicatedItems(bool onSelection /* = false*/) {
 		g_gui.CreateLoadBar("Searching on map...");
 	}
 
-	SearchDuplicatedItems::condition finder;
-
-	foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, onSelection);
-	std::unordered_set<Tile*> &foundTiles = finder.foundTiles;
+	const std::vector<Tile*> foundTiles = find_TilesOnMap(g_gui.GetCurrentMap(), SearchDuplicatedItems::condition, onSelection, [](size_t done, size_t total) {
+		g_gui.SetLoadDone(static_cast<unsigned int>(100 * done / total));
+	});
 
 	g_gui.DestroyLoadBar();
 
@@ -2452,7 +2432,7 @@ void MainMenuBar::SearchDuplicatedItems(bool onSelection /* = false*/) {
 
 namespace RemoveDuplicatesItems {
 	struct condition {
-		bool operator()(Map &map, Tile* tile, Item* item, long long removed, long long done) {
+		bool operator()(Map &map, Tile* tile, const Item* item, long long removed, long long done) {
 			if (done % 0x8000 == 0) {
 				g_gui.SetLoadDone((unsigned int)(100 * done / map.getTileCount()));
 			}
@@ -2478,7 +2458,7 @@ namespace RemoveDuplicatesItems {
 			}
 
 			std::unordered_set<int> itemIDsDuplicates;
-			for (Item* itemInTile : tile->items) {
+			for (const Item* itemInTile : tile->items.peek()) {
 				if (itemInTile && itemInTile->getID() == item->getID()) {
 					if (itemIDsDuplicates.count(itemInTile->getID()) > 0) {
 						itemIDsDuplicates.clear();
@@ -2527,48 +2507,25 @@ void MainMenuBar::RemoveDuplicatesItems(bool onSelection /* = false*/) {
 }
 
 namespace SearchWallsUponWalls {
-	struct condition {
-		std::unordered_set<Tile*> foundTiles;
-
-		void operator()(const Map &map, Tile* tile, const Item* item, long long done) {
-			if (done % 0x8000 == 0) {
-				g_gui.SetLoadDone(static_cast<unsigned int>(100 * done / map.getTileCount()));
-			}
-
-			if (!tile) {
-				return;
-			}
-
-			if (!item) {
-				return;
-			}
-
+	// Only reads the tile, it is called from all threads
+	bool condition(const Tile* tile) {
+		return any_ItemOnTile(tile, [tile](const Item* item) {
 			if (!item->isBlockMissiles()) {
-				return;
+				return false;
 			}
 
 			if (!item->isWall() && !item->isDoor()) {
-				return;
+				return false;
 			}
 
-			std::unordered_set<int> itemIDs;
-			for (const Item* itemInTile : tile->items) {
-				if (!itemInTile || (!itemInTile->isWall() && !itemInTile->isDoor())) {
-					continue;
+			for (const Item* itemInTile : tile->items.peek()) {
+				if ((itemInTile->isWall() || itemInTile->isDoor()) && item->getID() != itemInTile->getID()) {
+					return true;
 				}
-
-				if (item->getID() != itemInTile->getID()) {
-					itemIDs.insert(itemInTile->getID());
-				}
-			}
-
-			if (!itemIDs.empty()) {
-				foundTiles.insert(tile);
 			}
-
-			itemIDs.clear();
-		}
-	};
+			return false;
+		});
+	}
 }
 
 void MainMenuBar::SearchWallsUponWalls(bool onSelection /* = false*/) {
@@ -2582,11 +2539,9 @@ void MainMenuBar::SearchWallsUponWalls(bool onSelection /* = false*/) {
 		g_gui.CreateLoadBar("Searching on map...");
 	}
 
-	SearchWallsUponWalls::condition finder;
-
-	foreach_ItemOnMap(g_gui.GetCurrentMap(), finder, onSelection);
-
-	const std::unordered_set<Tile*> &foundTiles = finder.foundTiles;
+	const std::vector<Tile*> foundTiles = find_TilesOnMap(g_gui.GetCurrentMap(), SearchWallsUponWalls::condition, onSelection, [](size_t done, size_t total) {
+		g_gui.SetLoadDone(static_cast<unsigned int>(100 * done / total));
+	});
 
 	g_gui.DestroyLoadBar();
 
@@ -85,6 +85,7 @@ namespace MenuBar {
 		MAP_REMOVE_UNREACHABLE_TILES,
 		MAP_REMOVE_EMPTY_MONSTERS_SPAWNS,
 		MAP_REMOVE_EMPTY_NPCS_SPAWNS,
+		MAP_COMPACT_MEMORY,
 		MAP_CLEAN_HOUSE_ITEMS,
 		MAP_PROPERTIES,
 		MAP_STATISTICS,
@@ -233,6 +234,7 @@ public:
 	void OnMapRemoveEmptyNpcSpawns(wxCommandEvent &event);
 	void OnClearHouseTiles(wxCommandEvent &event);
 	void OnClearModifiedState(wxCommandEvent &event);
+	void OnMapCompactMemory(wxCommandEvent &event);
 	void OnToggleAutomagic(wxCommandEvent &event);
 	void OnSelectionTypeChange(wxCommandEvent &event);
 	void OnCut(wxCommandEvent &event);
@@ -62,6 +62,9 @@ bool Map::open(const std::string file) {
 
 	has_changed = false;
 
+	// Nothing refers to the locations yet, lay them out for fast viewport scans
+	relayout();
+
 	wxFileName fn = wxstr(file);
 	filename = fn.GetFullPath().mb_str(wxConvUTF8);
 	name = fn.GetFullName().mb_str(wxConvUTF8);
@@ -85,7 +88,7 @@ bool Map::open(const std::string file) {
 					out << "\tvecval.clear();\n";
 					if(new_->ground)
 						out << "\tvecval.push_back(" << new_->ground->getID() << ");\n";
-					for(ItemVector::iterator iter = new_->items.begin(); iter != new_->items.end(); ++iter)
+					for(TileItemVector::iterator iter = new_->items.begin(); iter != new_->items.end(); ++iter)
 						out << "\tvecval.push_back(" << (*iter)->getID() << ");\n";
 
 					if(old->ground && old->items.empty()) // Single item
@@ -97,7 +100,7 @@ bool Map::open(const std::string file) {
 						out << "\tveckey.clear();\n";
 						if(old->ground)
 							out << "\tveckey.push_back(" << old->ground->getID() << ");\n";
-						for(ItemVector::iterator iter = old->items.begin(); iter != old->items.end(); ++iter)
+						for(TileItemVector::iterator iter = old->items.begin(); iter != old->items.end(); ++iter)
 							out << "\tveckey.push_back(" << (*iter)->getID() << ");\n";
 						out << "\tstd::sort(veckey.begin(), veckey.end());\n";
 						out << "\treplacement_map.mtm[veckey] = vecval;\n\n";
@@ -141,6 +144,7 @@ bool Map::convert(MapVersion to, bool showdialog) {
 }
 
 bool Map::convert(const ConversionMap &rm, bool showdialog) {
+	prepareTileChanges();
 	if (showdialog) {
 		g_gui.CreateLoadBar("Converting map ...");
 	}
@@ -162,11 +166,12 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 		id_list.clear();
 
 		if (tile->ground) {
-			id_list.push_back(tile->ground->getID());
+			id_list.push_back(PackedItem::getSlotID(tile->ground.getSlot()));
 		}
-		for (ItemVector::const_iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
-			if ((*item_iter)->isBorder()) {
-				id_list.push_back((*item_iter)->getID());
+		for (size_t i = 0; i < tile->items.size(); ++i) {
+			Item* const &slot = tile->items.getSlot(i);
+			if (PackedItem::getSlotType(slot).isBorder) {
+				id_list.push_back(PackedItem::getSlotID(slot));
 			}
 		}
 
@@ -193,7 +198,7 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 				tile->ground = nullptr;
 			}
 
-			for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
+			for (TileItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
 				if (std::find(v.begin(), v.end(), (*item_iter)->getID()) != v.end()) {
 					delete *item_iter;
 					item_iter = tile->items.erase(item_iter);
@@ -240,7 +245,7 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 			}
 		}
 
-		for (ItemVector::iterator replace_item_iter = tile->items.begin() + inserted_items; replace_item_iter != tile->items.end();) {
+		for (TileItemVector::iterator replace_item_iter = tile->items.begin() + inserted_items; replace_item_iter != tile->items.end();) {
 			uint16_t id = (*replace_item_iter)->getID();
 			ConversionMap::STM::const_iterator cf = rm.stm.find(id);
 			if (cf != rm.stm.end()) {
@@ -266,6 +271,9 @@ bool Map::convert(const ConversionMap &rm, bool showdialog) {
 		}
 	}
 
+	// Items were changed in place
+	rebuildTileIndexes();
+
 	if (showdialog) {
 		g_gui.DestroyLoadBar();
 	}
@@ -278,17 +286,31 @@ void Map::cleanInvalidTiles(bool showdialog) {
 		g_gui.CreateLoadBar("Removing invalid tiles...");
 	}
 
-	uint64_t tiles_done = 0;
-
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
-
-		if (tile->size() == 0) {
-			continue;
+	// Looking for the tiles only reads them and runs on all threads, only
+	// those found are changed afterwards
+	const std::vector<Tile*> invalid = find_TilesOnMap(
+		*this,
+		[](const Tile* tile) {
+			for (const Item* item : tile->items.peek()) {
+				if (!g_items.isValidID(item->getID())) {
+					return true;
+				}
+			}
+			return false;
+		},
+		false,
+		[showdialog](size_t done, size_t total) {
+			if (showdialog) {
+				g_gui.SetLoadDone(int(done * 100 / total));
+			}
 		}
+	);
 
-		for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
+	for (Tile* tile : invalid) {
+		const int x = tile->getX(), y = tile->getY(), z = tile->getZ();
+		prepareTileChange(tile);
+		updateTileIndexes(x, y, z, tile, nullptr);
+		for (TileItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end();) {
 			if (g_items.isValidID((*item_iter)->getID())) {
 				++item_iter;
 			} else {
@@ -296,11 +318,8 @@ void Map::cleanInvalidTiles(bool showdialog) {
 				item_iter = tile->items.erase(item_iter);
 			}
 		}
-
-		++tiles_done;
-		if (showdialog && tiles_done % 0x10000 == 0) {
-			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
-		}
+		updateTileIndexes(x, y, z, nullptr, tile);
+		invalidateContentHash(x, y, z);
 	}
 
 	if (showdialog) {
@@ -313,27 +332,23 @@ void Map::cleanDeletedZones(bool showdialog) {
 		g_gui.CreateLoadBar("Removing deleted zones...");
 	}
 
-	uint64_t tiles_done = 0;
-
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
-
-		if (tile->size() == 0) {
-			continue;
+	// Only the leaves known to hold a deleted zone are visited
+	const std::vector<unsigned int> deleted = zones.getDeletedZones();
+	for (size_t i = 0; i < deleted.size(); ++i) {
+		const unsigned int zoneId = deleted[i];
+		for (const auto &leaf : *zones.getZoneLeaves(zoneId)) {
+			int x, y;
+			Zones::getLeafOrigin(leaf.first, x, y);
+			forEachTileInArea(x, y, x + 3, y + 3, rme::MapMinLayer, rme::MapMaxLayer, [&](Tile* tile) {
+				prepareTileChange(tile);
+				tile->removeZone(zoneId);
+				invalidateContentHash(tile->getX(), tile->getY(), tile->getZ());
+			});
 		}
+		zones.clearTiles(zoneId);
 
-		for (auto iter = tile->zones.begin(); iter != tile->zones.end();) {
-			if (zones.hasZone(*iter)) {
-				++iter;
-			} else {
-				iter = tile->zones.erase(iter);
-			}
-		}
-
-		++tiles_done;
-		if (showdialog && tiles_done % 0x10000 == 0) {
-			g_gui.SetLoadDone(int(tiles_done / double(getTileCount()) * 100.0));
+		if (showdialog) {
+			g_gui.SetLoadDone(int((i + 1) * 100 / deleted.size()));
 		}
 	}
 
@@ -343,17 +358,21 @@ void Map::cleanDeletedZones(bool showdialog) {
 }
 
 Position Map::getZonePosition(unsigned int zoneId) {
-	Position pos;
-	for (MapIterator miter = begin(); miter != end(); ++miter) {
-		Tile* tile = (*miter)->get();
-		ASSERT(tile);
-
-		if (tile->size() == 0) {
-			continue;
-		}
+	const ZoneLeafMap* leaves = zones.getZoneLeaves(zoneId);
+	if (!leaves) {
+		return Position();
+	}
 
-		if (tile->zones.find(zoneId) != tile->zones.end()) {
-			pos = tile->getPosition();
+	Position pos;
+	for (const auto &leaf : *leaves) {
+		int x, y;
+		Zones::getLeafOrigin(leaf.first, x, y);
+		forEachTileInArea(x, y, x + 3, y + 3, rme::MapMinLayer, rme::MapMaxLayer, [&](Tile* tile) {
+			if (!pos.isValid() && tile->hasZone(zoneId)) {
+				pos = tile->getPosition();
+			}
+		});
+		if (pos.isValid()) {
 			break;
 		}
 	}
@@ -416,7 +435,7 @@ void Map::setSpawnNpcFilename(const std::string &new_spawnnpcfile) {
 }
 
 bool Map::addSpawnMonster(Tile* tile) {
-	SpawnMonster* spawnMonster = tile->spawnMonster;
+	SpawnMonster* spawnMonster = tile->getSpawnMonster();
 	if (spawnMonster) {
 		int z = tile->getZ();
 		int start_x = tile->getX() - spawnMonster->getSize();
@@ -424,12 +443,9 @@ bool Map::addSpawnMonster(Tile* tile) {
 		int end_x = tile->getX() + spawnMonster->getSize();
 		int end_y = tile->getY() + spawnMonster->getSize();
 
-		for (int y = start_y; y <= end_y; ++y) {
-			for (int x = start_x; x <= end_x; ++x) {
-				TileLocation* ctile_loc = createTileL(x, y, z);
-				ctile_loc->increaseSpawnCount();
-			}
-		}
+		forEachLocationInArea(start_x, start_y, end_x, end_y, z, z, [](TileLocation &location) {
+			location.increaseSpawnCount();
+		}, true);
 		spawnsMonster.addSpawnMonster(tile);
 		return true;
 	}
@@ -437,7 +453,7 @@ bool Map::addSpawnMonster(Tile* tile) {
 }
 
 void Map::removeSpawnMonsterInternal(Tile* tile) {
-	SpawnMonster* spawnMonster = tile->spawnMonster;
+	SpawnMonster* spawnMonster = tile->getSpawnMonster();
 	ASSERT(spawnMonster);
 
 	int z = tile->getZ();
@@ -457,7 +473,7 @@ void Map::removeSpawnMonsterInternal(Tile* tile) {
 }
 
 void Map::removeSpawnMonster(Tile* tile) {
-	if (tile->spawnMonster) {
+	if (tile->getSpawnMonster()) {
 		removeSpawnMonsterInternal(tile);
 		spawnsMonster.removeSpawnMonster(tile);
 	}
@@ -474,63 +490,21 @@ SpawnMonsterList Map::getSpawnMonsterList(const Tile* tile) const {
 		return list;
 	}
 
-	uint32_t found = 0;
-	if (tile->spawnMonster) {
-		++found;
-		list.push_back(tile->spawnMonster);
-	}
-
-	// Scans the border tiles in an expanding square around the original spawn
-	const Position &position = tile->getPosition();
-	int start_x = position.x - 1;
-	int end_x = position.x + 1;
-	int start_y = position.y - 1;
-	int end_y = position.y + 1;
-
-	while (found != location->getSpawnMonsterCount()) {
-		for (int x = start_x; x <= end_x; ++x) {
-			const Tile* start_tile = getTile(x, start_y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-
-			const Tile* end_tile = getTile(x, end_y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
-		}
+	// Nearest spawns first, the tile's own spawn leads
+	const Position position = tile->getPosition();
+	std::vector<std::pair<int, Position>> centers;
+	spawnsMonster.forEachSpawnMonsterAround(position, [&](const Position &center) {
+		centers.emplace_back(std::max(std::abs(center.x - position.x), std::abs(center.y - position.y)), center);
+	});
+	std::sort(centers.begin(), centers.end(), [](const auto &lhs, const auto &rhs) {
+		return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+	});
 
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
-		}
-
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnMonster) {
-				list.push_back(start_tile->spawnMonster);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnMonster) {
-				list.push_back(end_tile->spawnMonster);
-				++found;
-			}
+	for (const auto &center : centers) {
+		const Tile* spawn_tile = getTile(center.second);
+		if (spawn_tile && spawn_tile->getSpawnMonster()) {
+			list.push_back(spawn_tile->getSpawnMonster());
 		}
-		--start_x;
-		--start_y;
-		++end_x;
-		++end_y;
 	}
 	return list;
 }
@@ -546,7 +520,7 @@ SpawnMonsterList Map::getSpawnMonsterList(int x, int y, int z) const {
 }
 
 bool Map::addSpawnNpc(Tile* tile) {
-	SpawnNpc* spawnNpc = tile->spawnNpc;
+	SpawnNpc* spawnNpc = tile->getSpawnNpc();
 	if (spawnNpc) {
 		int z = tile->getZ();
 		int start_x = tile->getX() - spawnNpc->getSize();
@@ -567,7 +541,7 @@ bool Map::addSpawnNpc(Tile* tile) {
 }
 
 void Map::removeSpawnNpcInternal(Tile* tile) {
-	SpawnNpc* spawnNpc = tile->spawnNpc;
+	SpawnNpc* spawnNpc = tile->getSpawnNpc();
 	ASSERT(spawnNpc);
 
 	int z = tile->getZ();
@@ -587,7 +561,7 @@ void Map::removeSpawnNpcInternal(Tile* tile) {
 }
 
 void Map::removeSpawnNpc(Tile* tile) {
-	if (tile->spawnNpc) {
+	if (tile->getSpawnNpc()) {
 		removeSpawnNpcInternal(tile);
 		spawnsNpc.removeSpawnNpc(tile);
 	}
@@ -604,50 +578,21 @@ SpawnNpcList Map::getSpawnNpcList(const Tile* tile) const {
 		return listNpc;
 	}
 
-	uint32_t found = 0;
-	if (tile->spawnNpc) {
-		++found;
-		listNpc.push_back(tile->spawnNpc);
-	}
-
-	// Scans the border tiles in an expanding square around the original spawn
-	const Position &position = tile->getPosition();
-	int start_x = position.x - 1;
-	int end_x = position.x + 1;
-	int start_y = position.y - 1;
-	int end_y = position.y + 1;
-
-	while (found != location->getSpawnNpcCount()) {
-		for (int x = start_x; x <= end_x; ++x) {
-			const Tile* start_tile = getTile(x, start_y, position.z);
-			if (start_tile && start_tile->spawnNpc) {
-				listNpc.push_back(start_tile->spawnNpc);
-				++found;
-			}
-
-			const Tile* end_tile = getTile(x, end_y, position.z);
-			if (end_tile && end_tile->spawnNpc) {
-				listNpc.push_back(end_tile->spawnNpc);
-				++found;
-			}
-		}
+	// Nearest spawns first, the tile's own spawn leads
+	const Position position = tile->getPosition();
+	std::vector<std::pair<int, Position>> centers;
+	spawnsNpc.forEachSpawnNpcAround(position, [&](const Position &center) {
+		centers.emplace_back(std::max(std::abs(center.x - position.x), std::abs(center.y - position.y)), center);
+	});
+	std::sort(centers.begin(), centers.end(), [](const auto &lhs, const auto &rhs) {
+		return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+	});
 
-		for (int y = start_y + 1; y < end_y; ++y) {
-			const Tile* start_tile = getTile(start_x, y, position.z);
-			if (start_tile && start_tile->spawnNpc) {
-				listNpc.push_back(start_tile->spawnNpc);
-				++found;
-			}
-			const Tile* end_tile = getTile(end_x, y, position.z);
-			if (end_tile && end_tile->spawnNpc) {
-				listNpc.push_back(end_tile->spawnNpc);
-				++found;
-			}
+	for (const auto &center : centers) {
+		const Tile* spawn_tile = getTile(center.second);
+		if (spawn_tile && spawn_tile->getSpawnNpc()) {
+			listNpc.push_back(spawn_tile->getSpawnNpc());
 		}
-		--start_x;
-		--start_y;
-		++end_x;
-		++end_y;
 	}
 	return listNpc;
 }
@@ -678,28 +623,12 @@ bool Map::exportMinimap(FileName filename, int floor /*= rme::MapGroundLayer*/,
 			minimap_colors[i] = colorFromEightBit(i).GetRGB();
 		}
 
-		for (MapIterator mit = begin(); mit != end(); ++mit) {
-			if ((*mit)->get() == nullptr || (*mit)->empty()) {
-				continue;
-			}
-
-			Position pos = (*mit)->getPosition();
-
-			if (pos.x < min_x) {
-				min_x = pos.x;
-			}
-
-			if (pos.y < min_y) {
-				min_y = pos.y;
-			}
-
-			if (pos.x > max_x) {
-				max_x = pos.x;
-			}
-
-			if (pos.y > max_y) {
-				max_y = pos.y;
-			}
+		Position from, to;
+		if (getBounds(from, to)) {
+			min_x = from.x;
+			min_y = from.y;
+			max_x = to.x;
+			max_y = to.y;
 		}
 
 		int minimap_width = max_x - min_x + 1;
@@ -725,16 +654,18 @@ bool Map::exportMinimap(FileName filename, int floor /*= rme::MapGroundLayer*/,
 			uint32_t pixelpos = (tile->getY() - min_y) * minimap_width + (tile->getX() - min_x);
 			uint8_t &pixel = pic[pixelpos];
 
-			for (ItemVector::const_reverse_iterator item_iter = tile->items.rbegin(); item_iter != tile->items.rend(); ++item_iter) {
-				if ((*item_iter)->getMiniMapColor()) {
-					pixel = (*item_iter)->getMiniMapColor();
+			PackedItem scratch;
+			for (size_t i = tile->items.size(); i-- > 0;) {
+				uint8_t color = scratch.peek(tile->items.getSlot(i))->getMiniMapColor();
+				if (color) {
+					pixel = color;
 					break;
 				}
 			}
 			if (pixel == 0) {
 				// check ground too
 				if (tile->hasGround()) {
-					pixel = tile->ground->getMiniMapColor();
+					pixel = scratch.peek(tile->ground.getSlot())->getMiniMapColor();
 				}
 			}
 		}
@@ -820,66 +751,47 @@ bool Map::exportMinimap(FileName filename, int floor /*= rme::MapGroundLayer*/,
 	return true;
 }
 
-void Map::updateUniqueIds(Tile* old_tile, Tile* new_tile) {
-	if (old_tile && old_tile->hasUniqueItem()) {
-		if (old_tile->ground) {
-			uint16_t uid = old_tile->ground->getUniqueID();
-			if (uid != 0) {
-				removeUniqueId(uid);
-			}
-		}
-		for (const Item* item : old_tile->items) {
-			if (item) {
-				uint16_t uid = item->getUniqueID();
-				if (uid != 0) {
-					removeUniqueId(uid);
-				}
-			}
-		}
+void Map::updateTileIndexes(int x, int y, int z, Tile* old_tile, Tile* new_tile) {
+	if (old_tile) {
+		itemIndex.removeTile(old_tile, x, y);
+		zones.removeTile(old_tile, x, y);
+		statistics.removeTile(old_tile, z);
 	}
-
-	if (new_tile && new_tile->hasUniqueItem()) {
-		if (new_tile->ground) {
-			uint16_t uid = new_tile->ground->getUniqueID();
-			if (uid != 0) {
-				addUniqueId(uid);
-			}
-		}
-		for (const Item* item : new_tile->items) {
-			if (item) {
-				uint16_t uid = item->getUniqueID();
-				if (uid != 0) {
-					addUniqueId(uid);
-				}
-			}
-		}
+	if (new_tile) {
+		itemIndex.addTile(new_tile, x, y);
+		zones.addTile(new_tile, x, y);
+		statistics.addTile(new_tile, z);
 	}
 }
 
-void Map::addUniqueId(uint16_t uid) {
-	auto it = std::find(uniqueIds.begin(), uniqueIds.end(), uid);
-	if (it == uniqueIds.end()) {
-		uniqueIds.push_back(uid);
-	}
+void Map::beginCreatureChange(const Tile* tile) {
+	statistics.removeTile(tile, tile->getZ());
 }
 
-void Map::removeUniqueId(uint16_t uid) {
-	auto it = std::find(uniqueIds.begin(), uniqueIds.end(), uid);
-	if (it != uniqueIds.end()) {
-		uniqueIds.erase(it);
+void Map::endCreatureChange(const Tile* tile) {
+	statistics.addTile(tile, tile->getZ());
+	invalidateContentHash(tile->getX(), tile->getY(), tile->getZ());
+}
+
+void Map::rebuildTileIndexes() {
+	itemIndex.clear();
+	statistics.clear();
+	for (TileLocation* location : *this) {
+		itemIndex.addTile(location->get(), location->getX(), location->getY());
+		statistics.addTile(location->get(), location->getZ());
 	}
+	invalidateContentHashes();
 }
 
 bool Map::hasUniqueId(uint16_t uid) const {
-	if (uid < rme::MinUniqueId || uniqueIds.empty()) {
+	if (uid < rme::MinUniqueId) {
 		return false;
 	}
-
-	auto it = std::find(uniqueIds.begin(), uniqueIds.end(), uid);
-	return it != uniqueIds.end();
+	return itemIndex.getUniqueCount(uid) != 0;
 }
 
 int64_t RemoveMonstersOnMap(Map &map, bool selectedOnly) {
+	map.prepareTileChanges();
 	int64_t done = 0;
 	int64_t removed = 0;
 
@@ -893,9 +805,11 @@ int64_t RemoveMonstersOnMap(Map &map, bool selectedOnly) {
 			++it;
 			continue;
 		}
-		if (tile->monster) {
-			delete tile->monster;
-			tile->monster = nullptr;
+		if (tile->getMonster()) {
+			map.beginCreatureChange(tile);
+			delete tile->getMonster();
+			tile->setMonster(nullptr);
+			map.endCreatureChange(tile);
 			++removed;
 		}
 
@@ -28,6 +28,8 @@
 #include "zones.h"
 #include "templates.h"
 #include "spawn_npc.h"
+#include "item_index.h"
+#include "map_statistics.h"
 
 class Map : public BaseMap {
 public:
@@ -150,6 +152,24 @@ public:
 
 	bool hasUniqueId(uint16_t uid) const;
 
+	// Where item ids, action ids and unique ids are used
+	const MapItemIndex &getItemIndex() const noexcept {
+		return itemIndex;
+	}
+	// Tile and item counters, per floor or for the whole map
+	const MapStatistics &getStatistics() const noexcept {
+		return statistics;
+	}
+	// Has to be called after tiles on the map were changed in place rather
+	// than replaced through setTile / swapTile, rebuilds the item index and
+	// statistics and drops all content hashes
+	void rebuildTileIndexes();
+	// Creatures and spawns are put on tiles that already sit on the map,
+	// such a tile leaves the statistics before the change and comes back after,
+	// which also drops the content hash of its block
+	void beginCreatureChange(const Tile* tile);
+	void endCreatureChange(const Tile* tile);
+
 protected:
 	// Loads a map
 	bool open(const std::string identifier);
@@ -182,9 +202,7 @@ public:
 	SpawnsNpc spawnsNpc;
 
 protected:
-	void updateUniqueIds(Tile* old_tile, Tile* new_tile) override;
-	void addUniqueId(uint16_t uid);
-	void removeUniqueId(uint16_t uid);
+	void updateTileIndexes(int x, int y, int z, Tile* old_tile, Tile* new_tile) override;
 
 	bool has_changed; // If the map has changed
 	bool unnamed; // If the map has yet to receive a name
@@ -198,9 +216,57 @@ public:
 	Zones zones;
 
 private:
-	std::vector<uint16_t> uniqueIds;
+	MapItemIndex itemIndex;
+	MapStatistics statistics;
 };
 
+// Calls foreach(map, tile, item, done) for every item on the tile, container contents included
+// The items are only peeked at, foreach returns true for those it wants to keep
+// and gets them through foreach.add(tile, item), only those are unpacked.
+template <typename ForeachType>
+inline void foreach_ItemOnTile(Map &map, Tile* tile, ForeachType &foreach, long long done) {
+	PackedItem scratch;
+	if (tile->ground && foreach (map, tile, scratch.peek(tile->ground.getSlot()), done)) {
+		foreach.add(tile, tile->ground.get());
+	}
+
+	// Contents are kept through their path from the item on the tile, a shared
+	// container gets copied by the unpack, the peeked one stays as it is
+	std::queue<std::pair<const Container*, std::vector<size_t>>> containers;
+	for (size_t index = 0; index < tile->items.size(); ++index) {
+		const Item* item = scratch.peek(tile->items.getSlot(index));
+		if (foreach (map, tile, item, done)) {
+			foreach.add(tile, tile->items[index]);
+		}
+
+		const Container* container = dynamic_cast<const Container*>(item);
+		if (!container) {
+			continue;
+		}
+
+		containers.emplace(container, std::vector<size_t>());
+		do {
+			const auto &[current, path] = containers.front();
+			const ItemVector &v = current->getVector();
+			for (size_t i = 0; i < v.size(); ++i) {
+				if (foreach (map, tile, v[i], done)) {
+					Item* found = tile->items[index];
+					for (size_t step : path) {
+						found = static_cast<Container*>(found)->getVector()[step];
+					}
+					foreach.add(tile, static_cast<Container*>(found)->getVector()[i]);
+				}
+				if (const Container* c = dynamic_cast<const Container*>(v[i])) {
+					std::vector<size_t> childPath = path;
+					childPath.push_back(i);
+					containers.emplace(c, std::move(childPath));
+				}
+			}
+			containers.pop();
+		} while (!containers.empty());
+	}
+}
+
 template <typename ForeachType>
 inline void foreach_ItemOnMap(Map &map, ForeachType &foreach, bool selectedTiles) {
 	MapIterator tileiter = map.begin();
@@ -210,43 +276,83 @@ inline void foreach_ItemOnMap(Map &map, ForeachType &foreach, bool selectedTiles
 	while (tileiter != end) {
 		++done;
 		Tile* tile = (*tileiter)->get();
-		if (selectedTiles && !tile->isSelected()) {
-			++tileiter;
-			continue;
+		if (!selectedTiles || tile->isSelected()) {
+			foreach_ItemOnTile(map, tile, foreach, done);
 		}
+		++tileiter;
+	}
+}
 
-		if (tile->ground) {
-			foreach (map, tile, tile->ground, done)
-				;
+// Same as foreach_ItemOnMap, but only visits the tiles of the blocks the item
+// index lists for the item id, items come in the same order as with a full scan
+template <typename ForeachType>
+inline void foreach_ItemWithIdOnMap(Map &map, uint16_t id, ForeachType &foreach, bool selectedTiles) {
+	long long done = 0;
+	for (const MapItemIndex::BlockCount &block : map.getItemIndex().getItemBlocks(id)) {
+		int x, y;
+		MapItemIndex::getBlockOrigin(block.block, x, y);
+		map.forEachTileInBlock(x, y, [&](Tile* tile) {
+			++done;
+			if (!selectedTiles || tile->isSelected()) {
+				foreach_ItemOnTile(map, tile, foreach, done);
+			}
+		});
+	}
+}
+
+// True if match(item) holds for any item on the tile, container contents included
+// Packed items are only peeked at, nothing on the tile is changed, which makes
+// this safe to call from several threads at once.
+template <typename MatchType>
+inline bool any_ItemOnTile(const Tile* tile, MatchType &&match) {
+	if (tile->ground) {
+		PackedItem scratch;
+		if (match(scratch.peek(tile->ground.getSlot()))) {
+			return true;
 		}
+	}
 
-		std::queue<Container*> containers;
-		for (ItemVector::iterator itemiter = tile->items.begin(); itemiter != tile->items.end(); ++itemiter) {
-			Item* item = *itemiter;
-			Container* container = dynamic_cast<Container*>(item);
-			foreach (map, tile, item, done)
-				;
-			if (container) {
-				containers.push(container);
+	std::queue<const Container*> containers;
+	for (const Item* item : tile->items.peek()) {
+		if (match(item)) {
+			return true;
+		}
+		if (const Container* container = dynamic_cast<const Container*>(item)) {
+			containers.push(container);
+		}
+	}
 
-				do {
-					container = containers.front();
-					ItemVector &v = container->getVector();
-					for (ItemVector::iterator containeriter = v.begin(); containeriter != v.end(); ++containeriter) {
-						Item* i = *containeriter;
-						Container* c = dynamic_cast<Container*>(i);
-						foreach (map, tile, i, done)
-							;
-						if (c) {
-							containers.push(c);
-						}
-					}
-					containers.pop();
-				} while (containers.size());
+	while (!containers.empty()) {
+		for (const Item* item : containers.front()->getVector()) {
+			if (match(item)) {
+				return true;
+			}
+			if (const Container* container = dynamic_cast<const Container*>(item)) {
+				containers.push(container);
 			}
 		}
-		++tileiter;
+		containers.pop();
 	}
+	return false;
+}
+
+// Tiles for which match(tile) holds, in the same order as MapIterator
+// Runs on all threads through BaseMap::parallelForEachTile, so match must only
+// read and should look at the items through peek() or any_ItemOnTile.
+template <typename MatchType>
+inline std::vector<Tile*> find_TilesOnMap(Map &map, MatchType &&match, bool selectedTiles, const std::function<void(size_t, size_t)> &progress = nullptr) {
+	return map.parallelForEachTile(
+		std::vector<Tile*>(),
+		[&](std::vector<Tile*> &found, Tile* tile) {
+			if ((!selectedTiles || tile->isSelected()) && match(static_cast<const Tile*>(tile))) {
+				found.push_back(tile);
+			}
+		},
+		[](std::vector<Tile*> &found, std::vector<Tile*> &partial) {
+			found.insert(found.end(), partial.begin(), partial.end());
+		},
+		progress
+	);
 }
 
 template <typename ForeachType>
@@ -284,6 +390,7 @@ inline long long remove_if_TileOnMap(Map &map, RemoveIfType &remove_if) {
 
 template <typename RemoveIfType>
 inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedOnly) {
+	map.prepareTileChanges();
 	int64_t done = 0;
 	int64_t removed = 0;
 
@@ -298,19 +405,18 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 			continue;
 		}
 
+		// Only peek at the items, those removed are deleted without unpacking
+		PackedItem scratch;
 		if (tile->ground) {
-			if (condition(map, tile->ground, removed, done)) {
-				delete tile->ground;
-				tile->ground = nullptr;
+			if (condition(map, scratch.peek(tile->ground.getSlot()), removed, done)) {
+				PackedItem::destroy(tile->ground.release());
 				++removed;
 			}
 		}
 
 		for (auto iit = tile->items.begin(); iit != tile->items.end();) {
-			Item* item = *iit;
-			if (condition(map, item, removed, done)) {
-				iit = tile->items.erase(iit);
-				delete item;
+			if (condition(map, scratch.peek(tile->items.getSlot(iit - tile->items.begin())), removed, done)) {
+				iit = tile->items.destroy(iit);
 				++removed;
 			} else {
 				++iit;
@@ -318,6 +424,10 @@ inline int64_t RemoveItemOnMap(Map &map, RemoveIfType &condition, bool selectedO
 		}
 		++it;
 	}
+
+	if (removed > 0) {
+		map.rebuildTileIndexes();
+	}
 	return removed;
 }
 
@@ -325,6 +435,7 @@ int64_t RemoveMonstersOnMap(Map &map, bool selectedOnly);
 
 template <typename RemoveIfType>
 inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool selectedOnly) {
+	map.prepareTileChanges();
 	int64_t done = 0;
 	int64_t removed = 0;
 
@@ -339,19 +450,18 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 			continue;
 		}
 
+		// Only peek at the items, those removed are deleted without unpacking
+		PackedItem scratch;
 		if (tile->ground) {
-			if (condition(map, tile, tile->ground, removed, done)) {
-				delete tile->ground;
-				tile->ground = nullptr;
+			if (condition(map, tile, scratch.peek(tile->ground.getSlot()), removed, done)) {
+				PackedItem::destroy(tile->ground.release());
 				++removed;
 			}
 		}
 
 		for (auto iit = tile->items.begin(); iit != tile->items.end();) {
-			Item* item = *iit;
-			if (condition(map, tile, item, removed, done)) {
-				iit = tile->items.erase(iit);
-				delete item;
+			if (condition(map, tile, scratch.peek(tile->items.getSlot(iit - tile->items.begin())), removed, done)) {
+				iit = tile->items.destroy(iit);
 				++removed;
 			} else {
 				++iit;
@@ -359,6 +469,10 @@ inline int64_t RemoveItemDuplicateOnMap(Map &map, RemoveIfType &condition, bool
 		}
 		++it;
 	}
+
+	if (removed > 0) {
+		map.rebuildTileIndexes();
+	}
 	return removed;
 }
 
@@ -20,15 +20,37 @@
 
 #include "tile.h"
 #include "map_region.h"
+#include "slab_pool.h"
 
 class BaseMap;
 
+struct MapAllocatorStats {
+	SlabPoolStats tiles; // Shared by every map, tiles move freely between maps
+	SlabPoolStats floors;
+	SlabPoolStats nodes;
+
+	SlabPoolStats getTotal() const noexcept {
+		SlabPoolStats total;
+		total += tiles;
+		total += floors;
+		total += nodes;
+		return total;
+	}
+};
+
+// Floors and tree nodes live and die with the map that owns them, so they
+// are carved from per-map slabs, a slab is handed back to the system once it
+// is empty and the rest in bulk when the map is destroyed. Tiles outlive their map (undo history, copy buffer)
+// and are pooled process wide through Tile::operator new instead.
 class MapAllocator {
 
 public:
 	MapAllocator() { }
 	~MapAllocator() { }
 
+	MapAllocator(const MapAllocator &) = delete;
+	MapAllocator &operator=(const MapAllocator &) = delete;
+
 	// shorthands for tiles
 	Tile* operator()(TileLocation* location) {
 		return allocateTile(location);
@@ -48,19 +70,43 @@ public:
 
 	//
 	Floor* allocateFloor(int x, int y, int z) {
-		return newd Floor(x, y, z);
+		return new (floors.allocate()) Floor(x, y, z);
 	}
 	void freeFloor(Floor* f) {
-		delete f;
+		if (f) {
+			f->~Floor();
+			floors.deallocate(f);
+		}
 	}
 
 	//
 	QTreeNode* allocateNode(BaseMap &map) {
-		return newd QTreeNode(map);
+		return new (nodes.allocate()) QTreeNode(map);
 	}
 	void freeNode(QTreeNode* qt) {
-		delete qt;
+		if (qt) {
+			qt->~QTreeNode();
+			nodes.deallocate(qt);
+		}
 	}
+
+	// Trades the floor and node arenas, used to move a map into new memory
+	void swap(MapAllocator &other) noexcept {
+		floors.swap(other.floors);
+		nodes.swap(other.nodes);
+	}
+
+	MapAllocatorStats getStats() const {
+		MapAllocatorStats stats;
+		stats.tiles = Tile::getPoolStats();
+		stats.floors = floors.getStats();
+		stats.nodes = nodes.getStats();
+		return stats;
+	}
+
+private:
+	SlabPool<Floor, 256> floors;
+	SlabPool<QTreeNode, 256> nodes;
 };
 
 #endif
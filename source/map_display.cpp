@@ -406,16 +406,16 @@ void MapCanvas::UpdatePositionStatus(int x, int y) {
 	ss = "";
 	Tile* tile = editor.getMap().getTile(map_x, map_y, floor);
 	if (tile) {
-		if (tile->spawnMonster && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
-			ss << "Monster spawn radius: " << tile->spawnMonster->getSize();
-		} else if (tile->monster && g_settings.getInteger(Config::SHOW_MONSTERS)) {
+		if (tile->getSpawnMonster() && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
+			ss << "Monster spawn radius: " << tile->getSpawnMonster()->getSize();
+		} else if (tile->getMonster() && g_settings.getInteger(Config::SHOW_MONSTERS)) {
 			ss << ("Monster");
-			ss << " \"" << wxstr(tile->monster->getName()) << "\" spawntime: " << tile->monster->getSpawnMonsterTime();
-		} else if (tile->spawnNpc && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
-			ss << "Npc spawn radius: " << tile->spawnNpc->getSize();
-		} else if (tile->npc && g_settings.getInteger(Config::SHOW_NPCS)) {
+			ss << " \"" << wxstr(tile->getMonster()->getName()) << "\" spawntime: " << tile->getMonster()->getSpawnMonsterTime();
+		} else if (tile->getSpawnNpc() && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
+			ss << "Npc spawn radius: " << tile->getSpawnNpc()->getSize();
+		} else if (tile->getNpc() && g_settings.getInteger(Config::SHOW_NPCS)) {
 			ss << ("NPC");
-			ss << " \"" << wxstr(tile->npc->getName()) << "\" spawntime: " << tile->npc->getSpawnNpcTime();
+			ss << " \"" << wxstr(tile->getNpc()->getName()) << "\" spawntime: " << tile->getNpc()->getSpawnNpcTime();
 		} else if (Item* item = tile->getTopItem()) {
 			ss << "Item \"" << wxstr(item->getName()) << "\"";
 			ss << " id:" << item->getID();
@@ -609,20 +609,20 @@ void MapCanvas::OnMouseLeftDoubleClick(wxMouseEvent &event) {
 		Tile* new_tile = tile->deepCopy(map);
 		wxDialog* dialog = nullptr;
 		// Show monster spawn
-		if (new_tile->spawnMonster && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
-			dialog = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->spawnMonster);
+		if (new_tile->getSpawnMonster() && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
+			dialog = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->getSpawnMonster());
 		}
 		// Show monster
-		else if (new_tile->monster && g_settings.getInteger(Config::SHOW_MONSTERS)) {
-			dialog = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->monster);
+		else if (new_tile->getMonster() && g_settings.getInteger(Config::SHOW_MONSTERS)) {
+			dialog = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->getMonster());
 		}
 		// Show npc
-		else if (new_tile->npc && g_settings.getInteger(Config::SHOW_NPCS)) {
-			dialog = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->npc);
+		else if (new_tile->getNpc() && g_settings.getInteger(Config::SHOW_NPCS)) {
+			dialog = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->getNpc());
 		}
 		// Show npc spawn
-		else if (new_tile->spawnNpc && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
-			dialog = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->spawnNpc);
+		else if (new_tile->getSpawnNpc() && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
+			dialog = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->getSpawnNpc());
 		} else if (Item* item = new_tile->getTopItem()) {
 			if (editor.getMap().getVersion().otbm >= MAP_OTBM_4) {
 				dialog = newd PropertiesWindow(g_gui.root, &editor.getMap(), new_tile, item);
@@ -725,22 +725,22 @@ void MapCanvas::OnMouseActionClick(wxMouseEvent &event) {
 					Tile* tile = editor.getMap().getTile(mouse_map_x, mouse_map_y, floor);
 					if (tile) {
 						// Show monster spawn
-						if (tile->spawnMonster && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
+						if (tile->getSpawnMonster() && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
 							selection.start(); // Start selection session
-							if (tile->spawnMonster->isSelected()) {
-								selection.remove(tile, tile->spawnMonster);
+							if (tile->getSpawnMonster()->isSelected()) {
+								selection.remove(tile, tile->getSpawnMonster());
 							} else {
-								selection.add(tile, tile->spawnMonster);
+								selection.add(tile, tile->getSpawnMonster());
 							}
 							selection.finish(); // Finish selection session
 							selection.updateSelectionCount();
 							// Show monsters
-						} else if (tile->monster && g_settings.getInteger(Config::SHOW_MONSTERS)) {
+						} else if (tile->getMonster() && g_settings.getInteger(Config::SHOW_MONSTERS)) {
 							selection.start(); // Start selection session
-							if (tile->monster->isSelected()) {
-								selection.remove(tile, tile->monster);
+							if (tile->getMonster()->isSelected()) {
+								selection.remove(tile, tile->getMonster());
 							} else {
-								selection.add(tile, tile->monster);
+								selection.add(tile, tile->getMonster());
 							}
 							selection.finish(); // Finish selection session
 							selection.updateSelectionCount();
@@ -758,21 +758,21 @@ void MapCanvas::OnMouseActionClick(wxMouseEvent &event) {
 							}
 						}
 						// Show npcs
-						if (tile->spawnNpc && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
+						if (tile->getSpawnNpc() && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
 							selection.start(); // Start selection session
-							if (tile->spawnNpc->isSelected()) {
-								selection.remove(tile, tile->spawnNpc);
+							if (tile->getSpawnNpc()->isSelected()) {
+								selection.remove(tile, tile->getSpawnNpc());
 							} else {
-								selection.add(tile, tile->spawnNpc);
+								selection.add(tile, tile->getSpawnNpc());
 							}
 							selection.finish(); // Finish selection session
 							selection.updateSelectionCount();
-						} else if (tile->npc && g_settings.getInteger(Config::SHOW_NPCS)) {
+						} else if (tile->getNpc() && g_settings.getInteger(Config::SHOW_NPCS)) {
 							selection.start(); // Start selection session
-							if (tile->npc->isSelected()) {
-								selection.remove(tile, tile->npc);
+							if (tile->getNpc()->isSelected()) {
+								selection.remove(tile, tile->getNpc());
 							} else {
-								selection.add(tile, tile->npc);
+								selection.add(tile, tile->getNpc());
 							}
 							selection.finish(); // Finish selection session
 							selection.updateSelectionCount();
@@ -808,29 +808,29 @@ void MapCanvas::OnMouseActionClick(wxMouseEvent &event) {
 						selection.clear();
 						selection.commit();
 						// Show monster spawn
-						if (tile->spawnMonster && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
-							selection.add(tile, tile->spawnMonster);
+						if (tile->getSpawnMonster() && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
+							selection.add(tile, tile->getSpawnMonster());
 							dragging = true;
 							drag_start_x = mouse_map_x;
 							drag_start_y = mouse_map_y;
 							drag_start_z = floor;
 							// Show monsters
-						} else if (tile->monster && g_settings.getInteger(Config::SHOW_MONSTERS)) {
-							selection.add(tile, tile->monster);
+						} else if (tile->getMonster() && g_settings.getInteger(Config::SHOW_MONSTERS)) {
+							selection.add(tile, tile->getMonster());
 							dragging = true;
 							drag_start_x = mouse_map_x;
 							drag_start_y = mouse_map_y;
 							drag_start_z = floor;
 							// Show npc spawns
-						} else if (tile->spawnNpc && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
-							selection.add(tile, tile->spawnNpc);
+						} else if (tile->getSpawnNpc() && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
+							selection.add(tile, tile->getSpawnNpc());
 							dragging = true;
 							drag_start_x = mouse_map_x;
 							drag_start_y = mouse_map_y;
 							drag_start_z = floor;
 							// Show npcs
-						} else if (tile->npc && g_settings.getInteger(Config::SHOW_NPCS)) {
-							selection.add(tile, tile->npc);
+						} else if (tile->getNpc() && g_settings.getInteger(Config::SHOW_NPCS)) {
+							selection.add(tile, tile->getNpc());
 							dragging = true;
 							drag_start_x = mouse_map_x;
 							drag_start_y = mouse_map_y;
@@ -924,7 +924,7 @@ void MapCanvas::OnMouseActionClick(wxMouseEvent &event) {
 					if (brush->isSpawnMonster() || brush->isMonster()) {
 						if (!g_settings.getBoolean(Config::SHOW_SPAWNS_MONSTER)) {
 							Tile* tile = editor.getMap().getTile(mouse_map_x, mouse_map_y, floor);
-							if (!tile || !tile->spawnMonster) {
+							if (!tile || !tile->getSpawnMonster()) {
 								will_show_spawn = true;
 							}
 						}
@@ -934,7 +934,7 @@ void MapCanvas::OnMouseActionClick(wxMouseEvent &event) {
 
 					if (will_show_spawn) {
 						Tile* tile = editor.getMap().getTile(mouse_map_x, mouse_map_y, floor);
-						if (tile && tile->spawnMonster) {
+						if (tile && tile->getSpawnMonster()) {
 							g_settings.setInteger(Config::SHOW_SPAWNS_MONSTER, true);
 							g_gui.UpdateMenubar();
 						}
@@ -954,7 +954,7 @@ void MapCanvas::OnMouseActionClick(wxMouseEvent &event) {
 					if (brush->isSpawnNpc() || brush->isNpc()) {
 						if (!g_settings.getBoolean(Config::SHOW_SPAWNS_NPC)) {
 							Tile* tile = editor.getMap().getTile(mouse_map_x, mouse_map_y, floor);
-							if (!tile || !tile->spawnNpc) {
+							if (!tile || !tile->getSpawnNpc()) {
 								will_show_spawn_npc = true;
 							}
 						}
@@ -964,7 +964,7 @@ void MapCanvas::OnMouseActionClick(wxMouseEvent &event) {
 
 					if (will_show_spawn_npc) {
 						Tile* tile = editor.getMap().getTile(mouse_map_x, mouse_map_y, floor);
-						if (tile && tile->spawnNpc) {
+						if (tile && tile->getSpawnNpc()) {
 							g_settings.setInteger(Config::SHOW_SPAWNS_NPC, true);
 							g_gui.UpdateMenubar();
 						}
@@ -1181,31 +1181,31 @@ void MapCanvas::OnMouseActionRelease(wxMouseEvent &event) {
 				// User hasn't moved anything, meaning selection/deselection
 				Tile* tile = editor.getMap().getTile(mouse_map_x, mouse_map_y, floor);
 				if (tile) {
-					if (tile->spawnMonster && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
-						if (!tile->spawnMonster->isSelected()) {
+					if (tile->getSpawnMonster() && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
+						if (!tile->getSpawnMonster()->isSelected()) {
 							selection.start(); // Start a selection session
-							selection.add(tile, tile->spawnMonster);
+							selection.add(tile, tile->getSpawnMonster());
 							selection.finish(); // Finish the selection session
 							selection.updateSelectionCount();
 						}
-					} else if (tile->monster && g_settings.getInteger(Config::SHOW_MONSTERS)) {
-						if (!tile->monster->isSelected()) {
+					} else if (tile->getMonster() && g_settings.getInteger(Config::SHOW_MONSTERS)) {
+						if (!tile->getMonster()->isSelected()) {
 							selection.start(); // Start a selection session
-							selection.add(tile, tile->monster);
+							selection.add(tile, tile->getMonster());
 							selection.finish(); // Finish the selection session
 							selection.updateSelectionCount();
 						}
-					} else if (tile->spawnNpc && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
-						if (!tile->spawnNpc->isSelected()) {
+					} else if (tile->getSpawnNpc() && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
+						if (!tile->getSpawnNpc()->isSelected()) {
 							selection.start(); // Start a selection session
-							selection.add(tile, tile->spawnNpc);
+							selection.add(tile, tile->getSpawnNpc());
 							selection.finish(); // Finish the selection session
 							selection.updateSelectionCount();
 						}
-					} else if (tile->npc && g_settings.getInteger(Config::SHOW_NPCS)) {
-						if (!tile->npc->isSelected()) {
+					} else if (tile->getNpc() && g_settings.getInteger(Config::SHOW_NPCS)) {
+						if (!tile->getNpc()->isSelected()) {
 							selection.start(); // Start a selection session
-							selection.add(tile, tile->monster);
+							selection.add(tile, tile->getMonster());
 							selection.finish(); // Finish the selection session
 							selection.updateSelectionCount();
 						}
@@ -1437,14 +1437,14 @@ void MapCanvas::OnMousePropertiesClick(wxMouseEvent &event) {
 		selection.start(); // Start a selection session
 		selection.clear();
 		selection.commit();
-		if (tile->spawnMonster && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
-			selection.add(tile, tile->spawnMonster);
-		} else if (tile->monster && g_settings.getInteger(Config::SHOW_MONSTERS)) {
-			selection.add(tile, tile->monster);
-		} else if (tile->npc && g_settings.getInteger(Config::SHOW_NPCS)) {
-			selection.add(tile, tile->npc);
-		} else if (tile->spawnNpc && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
-			selection.add(tile, tile->spawnNpc);
+		if (tile->getSpawnMonster() && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
+			selection.add(tile, tile->getSpawnMonster());
+		} else if (tile->getMonster() && g_settings.getInteger(Config::SHOW_MONSTERS)) {
+			selection.add(tile, tile->getMonster());
+		} else if (tile->getNpc() && g_settings.getInteger(Config::SHOW_NPCS)) {
+			selection.add(tile, tile->getNpc());
+		} else if (tile->getSpawnNpc() && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
+			selection.add(tile, tile->getSpawnNpc());
 		} else {
 			Item* item = tile->getTopItem();
 			if (item) {
@@ -2297,8 +2297,8 @@ void MapCanvas::OnSelectMonsterBrush(wxCommandEvent &WXUNUSED(event)) {
 		return;
 	}
 
-	if (tile->monster) {
-		g_gui.SelectBrush(tile->monster->getBrush(), TILESET_MONSTER);
+	if (tile->getMonster()) {
+		g_gui.SelectBrush(tile->getMonster()->getBrush(), TILESET_MONSTER);
 	}
 }
 
@@ -2312,8 +2312,8 @@ void MapCanvas::OnSelectNpcBrush(wxCommandEvent &WXUNUSED(event)) {
 		return;
 	}
 
-	if (tile->npc) {
-		g_gui.SelectBrush(tile->npc->getBrush(), TILESET_NPC);
+	if (tile->getNpc()) {
+		g_gui.SelectBrush(tile->getNpc()->getBrush(), TILESET_NPC);
 	}
 }
 
@@ -2380,14 +2380,14 @@ void MapCanvas::OnProperties(wxCommandEvent &WXUNUSED(event)) {
 
 	wxDialog* w = nullptr;
 
-	if (new_tile->spawnMonster && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
-		w = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->spawnMonster);
-	} else if (new_tile->monster && g_settings.getInteger(Config::SHOW_MONSTERS)) {
-		w = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->monster);
-	} else if (new_tile->npc && g_settings.getInteger(Config::SHOW_NPCS)) {
-		w = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->npc);
-	} else if (new_tile->spawnNpc && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
-		w = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->spawnNpc);
+	if (new_tile->getSpawnMonster() && g_settings.getInteger(Config::SHOW_SPAWNS_MONSTER)) {
+		w = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->getSpawnMonster());
+	} else if (new_tile->getMonster() && g_settings.getInteger(Config::SHOW_MONSTERS)) {
+		w = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->getMonster());
+	} else if (new_tile->getNpc() && g_settings.getInteger(Config::SHOW_NPCS)) {
+		w = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->getNpc());
+	} else if (new_tile->getSpawnNpc() && g_settings.getInteger(Config::SHOW_SPAWNS_NPC)) {
+		w = newd OldPropertiesWindow(g_gui.root, &editor.getMap(), new_tile, new_tile->getSpawnNpc());
 	} else {
 		ItemVector selected_items = new_tile->getSelectedItems();
 
@@ -2537,10 +2537,10 @@ void MapPopupMenu::Update() {
 			bool hasTable = false;
 			Item* topItem = nullptr;
 			Item* topSelectedItem = (selected_items.size() == 1 ? selected_items.back() : nullptr);
-			Monster* topMonster = tile->monster;
-			SpawnMonster* topSpawnMonster = tile->spawnMonster;
-			Npc* topNpc = tile->npc;
-			SpawnNpc* topSpawnNpc = tile->spawnNpc;
+			Monster* topMonster = tile->getMonster();
+			SpawnMonster* topSpawnMonster = tile->getSpawnMonster();
+			Npc* topNpc = tile->getNpc();
+			SpawnNpc* topSpawnNpc = tile->getSpawnNpc();
 
 			for (auto* item : tile->items) {
 				if (item->isWall()) {
@@ -325,21 +325,24 @@ void MapDrawer::DrawMap() {
 					}
 
 					if (!live_client || nd->isVisible(map_z > rme::MapGroundLayer)) {
-						for (int map_x = 0; map_x < 4; ++map_x) {
-							for (int map_y = 0; map_y < 4; ++map_y) {
-								TileLocation* location = nd->getTile(map_x, map_y, map_z);
-								DrawTile(location);
-								// draw light, but only if not zoomed too far
-								if (location && options.show_lights && zoom <= 10) {
-									AddLight(location);
-								}
+						// Only the locations holding a tile, in the same x major order
+						const uint16_t occupied = nd->getOccupancy(map_z);
+						if (occupied == 0) {
+							continue;
+						}
+
+						Floor* floor = nd->getFloor(map_z);
+						for (uint32_t bits = occupied; bits != 0; bits &= bits - 1) {
+							TileLocation* location = &floor->locs[std::countr_zero(bits)];
+							DrawTile(location);
+							// draw light, but only if not zoomed too far
+							if (options.show_lights && zoom <= 10) {
+								AddLight(location);
 							}
 						}
 						if (tile_indicators) {
-							for (int map_x = 0; map_x < 4; ++map_x) {
-								for (int map_y = 0; map_y < 4; ++map_y) {
-									DrawTileIndicators(nd->getTile(map_x, map_y, map_z));
-								}
+							for (uint32_t bits = occupied; bits != 0; bits &= bits - 1) {
+								DrawTileIndicators(&floor->locs[std::countr_zero(bits)]);
 							}
 						}
 					} else {
@@ -455,14 +458,15 @@ void MapDrawer::DrawSecondaryMap(int map_z) {
 				if (options.show_special_tiles && tile->getMapFlags() & TILESTATE_NOPVP) {
 					g /= 2;
 				}
-				BlitItem(draw_x, draw_y, tile, tile->ground, true, r, g, b, 160);
+				PackedItem scratch;
+				BlitItem(draw_x, draw_y, tile, scratch.peek(tile->ground.getSlot()), true, r, g, b, 160);
 			}
 
 			bool hidden = options.hide_items_when_zoomed && zoom > 10.f;
 
 			// Draw items
 			if (!hidden && !tile->items.empty()) {
-				for (const Item* item : tile->items) {
+				for (const Item* item : tile->items.peek()) {
 					if (item->isBorder()) {
 						BlitItem(draw_x, draw_y, tile, item, true, 160, r, g, b);
 					} else {
@@ -472,12 +476,12 @@ void MapDrawer::DrawSecondaryMap(int map_z) {
 			}
 
 			// Monsters
-			if (!hidden && options.show_monsters && tile->monster) {
-				BlitCreature(draw_x, draw_y, tile->monster);
+			if (!hidden && options.show_monsters && tile->getMonster()) {
+				BlitCreature(draw_x, draw_y, tile->getMonster());
 			}
 			// NPCS
-			if (!hidden && options.show_npcs && tile->npc) {
-				BlitCreature(draw_x, draw_y, tile->npc);
+			if (!hidden && options.show_npcs && tile->getNpc()) {
+				BlitCreature(draw_x, draw_y, tile->getNpc());
 			}
 		}
 	}
@@ -607,17 +611,17 @@ void MapDrawer::DrawDraggingShadow() {
 				}
 			}
 
-			if (options.show_monsters && tile->monster && tile->monster->isSelected()) {
-				BlitCreature(draw_x, draw_y, tile->monster);
+			if (options.show_monsters && tile->getMonster() && tile->getMonster()->isSelected()) {
+				BlitCreature(draw_x, draw_y, tile->getMonster());
 			}
-			if (tile->spawnMonster && tile->spawnMonster->isSelected()) {
+			if (tile->getSpawnMonster() && tile->getSpawnMonster()->isSelected()) {
 				DrawIndicator(draw_x, draw_y, EDITOR_SPRITE_MONSTERS, 160, 160, 160, 160);
 			}
 
-			if (options.show_npcs && tile->npc && tile->npc->isSelected()) {
-				BlitCreature(draw_x, draw_y, tile->npc);
+			if (options.show_npcs && tile->getNpc() && tile->getNpc()->isSelected()) {
+				BlitCreature(draw_x, draw_y, tile->getNpc());
 			}
-			if (tile->spawnNpc && tile->spawnNpc->isSelected()) {
+			if (tile->getSpawnNpc() && tile->getSpawnNpc()->isSelected()) {
 				DrawIndicator(draw_x, draw_y, EDITOR_SPRITE_NPCS, 160, 160, 160, 160);
 			}
 		}
@@ -645,16 +649,18 @@ void MapDrawer::DrawHigherFloors() {
 			getDrawPosition(tile->getPosition(), draw_x, draw_y);
 
 			if (tile->ground) {
+				PackedItem scratch;
+				const Item* ground = scratch.peek(tile->ground.getSlot());
 				if (tile->isPZ()) {
-					BlitItem(draw_x, draw_y, tile, tile->ground, false, 128, 255, 128, 96);
+					BlitItem(draw_x, draw_y, tile, ground, false, 128, 255, 128, 96);
 				} else {
-					BlitItem(draw_x, draw_y, tile, tile->ground, false, 255, 255, 255, 96);
+					BlitItem(draw_x, draw_y, tile, ground, false, 255, 255, 255, 96);
 				}
 			}
 
 			bool hidden = options.hide_items_when_zoomed && zoom > 10.f;
 			if (!hidden && !tile->items.empty()) {
-				for (const Item* item : tile->items) {
+				for (const Item* item : tile->items.peek()) {
 					BlitItem(draw_x, draw_y, tile, item, false, 255, 255, 255, 96);
 				}
 			}
@@ -1506,7 +1512,7 @@ void MapDrawer::DrawTile(TileLocation* location) {
 			}
 
 			int item_count = tile->items.size();
-			if (options.highlight_items && item_count > 0 && !tile->items.back()->isBorder()) {
+			if (options.highlight_items && item_count > 0 && !PackedItem::getSlotType(tile->items.getSlot(item_count - 1)).isBorder) {
 				static const float factor[5] = { 0.75f, 0.6f, 0.48f, 0.40f, 0.33f };
 				int idx = (item_count < 5 ? item_count : 5) - 1;
 				g = int(g * factor[idx]);
@@ -1554,7 +1560,7 @@ void MapDrawer::DrawTile(TileLocation* location) {
 				r /= 1.5;
 				g /= 2;
 			}
-			if (showspecial && ((!tile->zones.empty() && !zone_active) || tile->zones.size() > 1)) {
+			if (showspecial && ((!tile->getZones().empty() && !zone_active) || tile->getZones().size() > 1)) {
 				r /= 1.4;
 				g /= 1.6;
 				b /= 1.3;
@@ -1579,22 +1585,25 @@ void MapDrawer::DrawTile(TileLocation* location) {
 			}
 			glEnable(GL_TEXTURE_2D);
 		} else {
+			PackedItem scratch;
+			const Item* ground = scratch.peek(tile->ground.getSlot());
 			if (options.show_preview && zoom <= 2.0) {
-				tile->ground->animate();
+				ground->animate();
 			}
 
-			BlitItem(draw_x, draw_y, tile, tile->ground, false, r, g, b);
+			BlitItem(draw_x, draw_y, tile, ground, false, r, g, b);
 		}
 
 		if (show_tooltips && position.z == floor) {
-			WriteTooltip(tile->ground, tooltip);
+			PackedItem scratch;
+			WriteTooltip(scratch.peek(tile->ground.getSlot()), tooltip);
 		}
 	}
 
 	bool hidden = only_colors || (options.hide_items_when_zoomed && zoom > 10.f);
 
 	if (!hidden && !tile->items.empty()) {
-		for (Item* item : tile->items) {
+		for (const Item* item : tile->items.peek()) {
 			if (show_tooltips && position.z == floor) {
 				WriteTooltip(item, tooltip);
 			}
@@ -1611,12 +1620,12 @@ void MapDrawer::DrawTile(TileLocation* location) {
 		}
 	}
 
-	if (!hidden && options.show_monsters && tile->monster) {
-		BlitCreature(draw_x, draw_y, tile->monster);
+	if (!hidden && options.show_monsters && tile->getMonster()) {
+		BlitCreature(draw_x, draw_y, tile->getMonster());
 	}
 
-	if (!hidden && options.show_npcs && tile->npc) {
-		BlitCreature(draw_x, draw_y, tile->npc);
+	if (!hidden && options.show_npcs && tile->getNpc()) {
+		BlitCreature(draw_x, draw_y, tile->getNpc());
 	}
 
 	if (show_tooltips) {
@@ -1742,7 +1751,7 @@ void MapDrawer::DrawTileIndicators(TileLocation* location) {
 			green = 0x00;
 			blue = 0x00;
 		}
-		for (const Item* item : tile->items) {
+		for (const Item* item : tile->items.peek()) {
 			const ItemType &type = g_items.getItemType(item->getID());
 			if ((type.pickupable && options.show_pickupables) || (type.moveable && options.show_moveables)) {
 				if (type.pickupable && options.show_pickupables && type.moveable && options.show_moveables) {
@@ -1764,16 +1773,16 @@ void MapDrawer::DrawTileIndicators(TileLocation* location) {
 		}
 	}
 
-	if (options.show_spawns_monster && tile->spawnMonster) {
-		if (tile->spawnMonster->isSelected()) {
+	if (options.show_spawns_monster && tile->getSpawnMonster()) {
+		if (tile->getSpawnMonster()->isSelected()) {
 			DrawIndicator(x, y, EDITOR_SPRITE_MONSTERS, 128, 128, 128);
 		} else {
 			DrawIndicator(x, y, EDITOR_SPRITE_MONSTERS);
 		}
 	}
 
-	if (tile->spawnNpc && options.show_spawns_npc) {
-		if (tile->spawnNpc->isSelected()) {
+	if (tile->getSpawnNpc() && options.show_spawns_npc) {
+		if (tile->getSpawnNpc()->isSelected()) {
 			DrawIndicator(x, y, EDITOR_SPRITE_NPCS, 128, 128, 128);
 		} else {
 			DrawIndicator(x, y, EDITOR_SPRITE_NPCS, 255, 255, 255);
@@ -1954,17 +1963,19 @@ void MapDrawer::AddLight(TileLocation* location) {
 		return;
 	}
 
-	auto &position = location->getPosition();
+	const auto position = location->getPosition();
 
 	if (tile->ground) {
-		if (tile->ground->hasLight()) {
-			light_drawer->addLight(position.x, position.y, position.z, tile->ground->getLight());
+		PackedItem scratch;
+		const Item* ground = scratch.peek(tile->ground.getSlot());
+		if (ground->hasLight()) {
+			light_drawer->addLight(position.x, position.y, position.z, ground->getLight());
 		}
 	}
 
 	bool hidden = options.hide_items_when_zoomed && zoom > 10.f;
 	if (!hidden && !tile->items.empty()) {
-		for (auto item : tile->items) {
+		for (const Item* item : tile->items.peek()) {
 			if (item->hasLight()) {
 				light_drawer->addLight(position.x, position.y, position.z, item->getLight());
 			}
@@ -21,29 +21,32 @@
 #include "basemap.h"
 #include "position.h"
 #include "tile.h"
+#include "content_hash.h"
 
 //**************** Tile Location **********************
 
+// A location finds its floor by stepping back to locs[0]
+static_assert(offsetof(Floor, locs) == 0, "Floor::locs must come first");
+static_assert(sizeof(TileLocation) <= 2 * sizeof(void*), "TileLocation grew");
+
 TileLocation::TileLocation() :
 	tile(nullptr),
-	position(0, 0, 0),
 	spawn_monster_count(0),
 	spawn_npc_count(0),
 	waypoint_count(0),
-	house_exits(nullptr) {
+	index(0) {
 	////
 }
 
 TileLocation::~TileLocation() {
 	delete tile;
-	delete house_exits;
 }
 
 int TileLocation::size() const {
 	if (tile) {
 		return tile->size();
 	}
-	return spawn_monster_count + spawn_npc_count + waypoint_count + (house_exits ? 1 : 0);
+	return spawn_monster_count + spawn_npc_count + waypoint_count + (getHouseExits() ? 1 : 0);
 }
 
 bool TileLocation::empty() const {
@@ -51,30 +54,85 @@ bool TileLocation::empty() const {
 }
 
 HouseExitList* TileLocation::createHouseExits() {
-	if (!house_exits) {
-		house_exits = new HouseExitList();
+	Floor* floor = getFloor();
+	if (!floor->house_exits) {
+		floor->house_exits = newd HouseExitList*[rme::MapLayers]();
+	}
+
+	HouseExitList*&exits = floor->house_exits[index];
+	if (!exits) {
+		exits = newd HouseExitList();
 	}
-	return house_exits;
+	return exits;
 }
 
 //**************** Floor **********************
 
-Floor::Floor(int sx, int sy, int z) {
-	sx = sx & ~3;
-	sy = sy & ~3;
+Floor::Floor(int sx, int sy, int sz) :
+	house_exits(nullptr),
+	content_hash(0),
+	x(static_cast<uint16_t>(sx & ~3)),
+	y(static_cast<uint16_t>(sy & ~3)),
+	z(static_cast<uint8_t>(sz)),
+	occupied(0) {
+	for (int i = 0; i < rme::MapLayers; ++i) {
+		locs[i].index = static_cast<uint8_t>(i);
+	}
+}
 
+Floor::~Floor() {
+	if (house_exits) {
+		for (int i = 0; i < rme::MapLayers; ++i) {
+			delete house_exits[i];
+		}
+		delete[] house_exits;
+	}
+}
+
+void Floor::adopt(Floor &other) noexcept {
 	for (int i = 0; i < rme::MapLayers; ++i) {
-		locs[i].position.x = sx + (i >> 2);
-		locs[i].position.y = sy + (i & 3);
-		locs[i].position.z = z;
+		TileLocation &from = other.locs[i];
+		TileLocation &to = locs[i];
+		to.tile = from.tile;
+		if (to.tile) {
+			to.tile->setLocation(&to);
+		}
+		to.spawn_monster_count = from.spawn_monster_count;
+		to.spawn_npc_count = from.spawn_npc_count;
+		to.waypoint_count = from.waypoint_count;
+		from.tile = nullptr;
+	}
+	house_exits = other.house_exits;
+	other.house_exits = nullptr;
+	occupied = other.occupied;
+	other.occupied = 0;
+	content_hash = other.content_hash;
+	other.content_hash = 0;
+}
+
+uint64_t Floor::getContentHash() {
+	if (content_hash != 0) {
+		return content_hash;
+	}
+
+	ContentHasher hasher;
+	for (uint16_t mask = occupied; mask != 0; mask &= mask - 1) {
+		const int index = std::countr_zero(mask);
+		hasher.add(index);
+		hasher.add(locs[index].tile->getContentHash());
 	}
+	content_hash = hasher.get();
+	return content_hash;
 }
 
 //**************** QTreeNode **********************
 
 QTreeNode::QTreeNode(BaseMap &map) :
 	map(map),
+	parent(nullptr),
 	visible(0),
+	tile_count(0),
+	content_hash(0),
 	isLeaf(false) {
 	// Doesn't matter if we're leaf or node
 	for (int i = 0; i < rme::MapLayers; ++i) {
@@ -85,11 +143,11 @@ QTreeNode::QTreeNode(BaseMap &map) :
 QTreeNode::~QTreeNode() {
 	if (isLeaf) {
 		for (int i = 0; i < rme::MapLayers; ++i) {
-			delete array[i];
+			map.allocator.freeFloor(array[i]);
 		}
 	} else {
 		for (int i = 0; i < rme::MapLayers; ++i) {
-			delete child[i];
+			map.allocator.freeNode(child[i]);
 		}
 	}
 }
@@ -128,12 +186,12 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 			}
 
 		} else {
+			qt = map.allocator.allocateNode(map);
+			qt->parent = node;
 			if (level == 0) {
-				qt = newd QTreeNode(map);
 				qt->isLeaf = true;
+				map.leaves.insert(x, y, qt);
 				return qt;
-			} else {
-				qt = newd QTreeNode(map);
 			}
 		}
 		node = node->child[index];
@@ -148,11 +206,78 @@ QTreeNode* QTreeNode::getLeafForce(int x, int y) {
 Floor* QTreeNode::createFloor(int x, int y, int z) {
 	ASSERT(isLeaf);
 	if (!array[z]) {
-		array[z] = newd Floor(x, y, z);
+		array[z] = map.allocator.allocateFloor(x, y, z);
 	}
 	return array[z];
 }
 
+uint16_t QTreeNode::getFloorMask() const {
+	ASSERT(isLeaf);
+	uint16_t mask = 0;
+	for (int z = 0; z < rme::MapLayers; ++z) {
+		if (array[z] && array[z]->occupied) {
+			mask |= 1 << z;
+		}
+	}
+	return mask;
+}
+
+void QTreeNode::updateOccupancy(Floor* floor, int index, bool occupied) noexcept {
+	ASSERT(isLeaf);
+	const int x = floor->x + (index >> 2);
+	const int y = floor->y + (index & 3);
+	if (occupied) {
+		floor->occupied |= 1 << index;
+		for (QTreeNode* node = this; node; node = node->parent) {
+			++node->tile_count;
+		}
+		map.addFloorTile(x, y, floor->z);
+	} else {
+		floor->occupied &= ~(1 << index);
+		for (QTreeNode* node = this; node; node = node->parent) {
+			--node->tile_count;
+		}
+		map.removeFloorTile(x, y, floor->z);
+	}
+}
+
+uint64_t QTreeNode::getContentHash() {
+	if (content_hash != 0) {
+		return content_hash;
+	}
+
+	// Empty floors and subtrees are left out, so it doesn't matter whether
+	// compact() has freed them yet
+	ContentHasher hasher;
+	for (int i = 0; i < rme::MapLayers; ++i) {
+		if (isLeaf) {
+			Floor* floor = array[i];
+			if (floor && floor->occupied) {
+				hasher.add(i);
+				hasher.add(floor->getContentHash());
+			}
+		} else {
+			QTreeNode* node = child[i];
+			if (node && node->tile_count > 0) {
+				hasher.add(i);
+				hasher.add(node->getContentHash());
+			}
+		}
+	}
+	content_hash = hasher.get();
+	return content_hash;
+}
+
+void QTreeNode::invalidateContentHash(Floor* floor) noexcept {
+	ASSERT(isLeaf);
+	floor->content_hash = 0;
+	// No early out at the first stale node, empty subtrees are never hashed
+	// and may still be stale under a clean parent
+	for (QTreeNode* node = this; node; node = node->parent) {
+		node->content_hash = 0;
+	}
+}
+
 bool QTreeNode::isVisible(bool underground) {
 	return testFlags(visible, underground + 1);
 }
@@ -238,15 +363,19 @@ Tile* QTreeNode::setTile(int x, int y, int z, Tile* newtile) {
 
 	int offset_x = x & 3;
 	int offset_y = y & 3;
+	int index = offset_x * 4 + offset_y;
 
-	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
+	TileLocation* tmp = &f->locs[index];
 	Tile* oldtile = tmp->tile;
 	tmp->tile = newtile;
+	invalidateContentHash(f);
 
 	if (newtile && !oldtile) {
 		++map.tilecount;
+		updateOccupancy(f, index, true);
 	} else if (oldtile && !newtile) {
 		--map.tilecount;
+		updateOccupancy(f, index, false);
 	}
 
 	return oldtile;
@@ -258,8 +387,59 @@ void QTreeNode::clearTile(int x, int y, int z) {
 
 	int offset_x = x & 3;
 	int offset_y = y & 3;
+	int index = offset_x * 4 + offset_y;
 
-	TileLocation* tmp = &f->locs[offset_x * 4 + offset_y];
-	delete tmp->tile;
+	TileLocation* tmp = &f->locs[index];
+	if (tmp->tile) {
+		delete tmp->tile;
+	} else {
+		++map.tilecount;
+		updateOccupancy(f, index, true);
+	}
 	tmp->tile = map.allocator(tmp);
+	invalidateContentHash(f);
+}
+
+//**************** QTreeLeafIndex **********************
+
+QTreeLeafIndex::~QTreeLeafIndex() {
+	clear();
+}
+
+void QTreeLeafIndex::insert(int x, int y, QTreeNode* leaf) {
+	if (!pages) {
+		pages = newd QTreeNode**[DirectorySize]();
+	}
+
+	const uint32_t leaf_x = (static_cast<uint32_t>(x) & 0xFFFF) >> 2;
+	const uint32_t leaf_y = (static_cast<uint32_t>(y) & 0xFFFF) >> 2;
+	QTreeNode**& page = pages[getPageIndex(leaf_x, leaf_y)];
+	if (!page) {
+		page = newd QTreeNode*[PageSize]();
+	}
+	page[getSlotIndex(leaf_x, leaf_y)] = leaf;
+}
+
+void QTreeLeafIndex::remove(int x, int y) noexcept {
+	if (!pages) {
+		return;
+	}
+
+	const uint32_t leaf_x = (static_cast<uint32_t>(x) & 0xFFFF) >> 2;
+	const uint32_t leaf_y = (static_cast<uint32_t>(y) & 0xFFFF) >> 2;
+	if (QTreeNode** page = pages[getPageIndex(leaf_x, leaf_y)]) {
+		page[getSlotIndex(leaf_x, leaf_y)] = nullptr;
+	}
+}
+
+void QTreeLeafIndex::clear() noexcept {
+	if (!pages) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < DirectorySize; ++i) {
+		delete[] pages[i];
+	}
+	delete[] pages;
+	pages = nullptr;
 }
@@ -35,12 +35,16 @@ public:
 	TileLocation &operator=(const TileLocation &) = delete;
 
 protected:
+	// Kept down to 16 bytes, the position is derived from the owning floor
+	// and house exits live in a side table of the floor.
 	Tile* tile;
-	Position position;
-	size_t spawn_monster_count;
-	size_t spawn_npc_count;
-	size_t waypoint_count;
-	HouseExitList* house_exits; // Any house exits pointing here
+	uint16_t spawn_monster_count;
+	uint16_t spawn_npc_count;
+	uint16_t waypoint_count;
+	uint8_t index; // Slot in Floor::locs
+
+	Floor* getFloor() noexcept;
+	const Floor* getFloor() const noexcept;
 
 public:
 	// Access tile
@@ -54,24 +58,20 @@ public:
 
 	int size() const;
 	bool empty() const;
+	// Holds neither a tile nor anything else pointing at this spot, so the
+	// floor it belongs to may be freed
+	bool isUnused() const noexcept;
 
-	const Position &getPosition() const noexcept {
-		return position;
-	}
-	int getX() const noexcept {
-		return position.x;
-	}
-	int getY() const noexcept {
-		return position.y;
-	}
-	int getZ() const noexcept {
-		return position.z;
-	}
+	Position getPosition() const noexcept;
+	int getX() const noexcept;
+	int getY() const noexcept;
+	int getZ() const noexcept;
 
 	size_t getSpawnMonsterCount() const noexcept {
 		return spawn_monster_count;
 	}
 	void increaseSpawnCount() noexcept {
+		ASSERT(spawn_monster_count < UINT16_MAX);
 		spawn_monster_count++;
 	}
 	void decreaseSpawnMonsterCount() noexcept {
@@ -82,6 +82,7 @@ public:
 		return spawn_npc_count;
 	}
 	void increaseSpawnNpcCount() noexcept {
+		ASSERT(spawn_npc_count < UINT16_MAX);
 		spawn_npc_count++;
 	}
 	void decreaseSpawnNpcCount() noexcept {
@@ -92,27 +93,92 @@ public:
 		return waypoint_count;
 	}
 	void increaseWaypointCount() {
+		ASSERT(waypoint_count < UINT16_MAX);
 		waypoint_count++;
 	}
 	void decreaseWaypointCount() {
 		waypoint_count--;
 	}
 	HouseExitList* createHouseExits();
-	HouseExitList* getHouseExits() noexcept {
-		return house_exits;
-	}
+	HouseExitList* getHouseExits() noexcept;
+	const HouseExitList* getHouseExits() const noexcept;
 
 	friend class Floor;
 	friend class QTreeNode;
 	friend class Waypoints;
 };
 
+// 16 locations of 16 bytes plus a small header, locs has to stay the first
+// member so that a location can find its floor
 class Floor {
 public:
 	Floor(int x, int y, int z);
+	~Floor();
+
+	Floor(const Floor &) = delete;
+	Floor &operator=(const Floor &) = delete;
+
+	// Moves everything stored on other (a floor at the same position) over to
+	// this empty floor and points the tiles at their new locations
+	void adopt(Floor &other) noexcept;
+
+	// Hash of the tiles on this floor, recomputed if it was invalidated
+	uint64_t getContentHash();
+
 	TileLocation locs[rme::MapLayers];
+	// House exits of every location, only allocated once one has any
+	HouseExitList** house_exits;
+	// 0 while stale, cleared by QTreeNode whenever a tile is replaced
+	uint64_t content_hash;
+	uint16_t x, y; // Position of locs[0]
+	uint8_t z;
+	// Bit i is set while locs[i] holds a tile, kept up to date by QTreeNode
+	uint16_t occupied;
 };
 
+inline Floor* TileLocation::getFloor() noexcept {
+	return reinterpret_cast<Floor*>(this - index);
+}
+
+inline const Floor* TileLocation::getFloor() const noexcept {
+	return reinterpret_cast<const Floor*>(this - index);
+}
+
+inline Position TileLocation::getPosition() const noexcept {
+	const Floor* floor = getFloor();
+	return Position(floor->x + (index >> 2), floor->y + (index & 3), floor->z);
+}
+
+inline int TileLocation::getX() const noexcept {
+	return getFloor()->x + (index >> 2);
+}
+
+inline int TileLocation::getY() const noexcept {
+	return getFloor()->y + (index & 3);
+}
+
+inline int TileLocation::getZ() const noexcept {
+	return getFloor()->z;
+}
+
+inline HouseExitList* TileLocation::getHouseExits() noexcept {
+	Floor* floor = getFloor();
+	return floor->house_exits ? floor->house_exits[index] : nullptr;
+}
+
+inline const HouseExitList* TileLocation::getHouseExits() const noexcept {
+	const Floor* floor = getFloor();
+	return floor->house_exits ? floor->house_exits[index] : nullptr;
+}
+
+inline bool TileLocation::isUnused() const noexcept {
+	if (tile || spawn_monster_count != 0 || spawn_npc_count != 0 || waypoint_count != 0) {
+		return false;
+	}
+	const HouseExitList* exits = getHouseExits();
+	return !exits || exits->empty();
+}
+
 // This is not a QuadTree, but a HexTree (16 child nodes to every node), so the name is abit misleading
 class QTreeNode {
 public:
@@ -140,6 +206,24 @@ public:
 		return array;
 	}
 
+	// Number of tiles anywhere below this node
+	uint32_t getTileCount() const noexcept {
+		return tile_count;
+	}
+	// Leaf only, the occupied mask of floor z (0 if it's not allocated)
+	uint16_t getOccupancy(uint32_t z) const {
+		ASSERT(isLeaf);
+		return array[z] ? array[z]->occupied : 0;
+	}
+	// Leaf only, bit z is set if floor z holds any tile
+	uint16_t getFloorMask() const;
+
+	// Hash over the hashes of all non empty children (floors for a leaf),
+	// only stale parts of the subtree are recomputed
+	uint64_t getContentHash();
+	// Marks floor (of this leaf) and every node up to the root as stale
+	void invalidateContentHash(Floor* floor) noexcept;
+
 	void setVisible(bool overground, bool underground);
 	void setVisible(uint32_t client, bool underground, bool value);
 	bool isVisible(uint32_t client, bool underground);
@@ -150,8 +234,15 @@ public:
 	bool isRequested(bool underground);
 
 protected:
+	// Flags location index of floor as (un)occupied and updates the counts up to the root
+	void updateOccupancy(Floor* floor, int index, bool occupied) noexcept;
+
 	BaseMap &map;
+	QTreeNode* parent;
 	uint32_t visible;
+	uint32_t tile_count;
+	// 0 while stale
+	uint64_t content_hash;
 
 	bool isLeaf;
 
@@ -167,4 +258,94 @@ protected:
 	friend class MapIterator;
 };
 
+// Direct lookup table from map coordinates to QTreeNode leaves
+// Two levels, a directory of pages where every page covers 64x64 leaves
+// (256x256 tiles), so finding a leaf costs two loads instead of walking
+// the tree. Pages are only allocated where leaves exist, the tree remains
+// the owner of the nodes.
+class QTreeLeafIndex {
+public:
+	QTreeLeafIndex() = default;
+	~QTreeLeafIndex();
+
+	QTreeLeafIndex(const QTreeLeafIndex &) = delete;
+	QTreeLeafIndex &operator=(const QTreeLeafIndex &) = delete;
+
+	// Might return nullptr
+	QTreeNode* find(int x, int y) const noexcept {
+		if (!pages) {
+			return nullptr;
+		}
+
+		const uint32_t leaf_x = (static_cast<uint32_t>(x) & 0xFFFF) >> 2;
+		const uint32_t leaf_y = (static_cast<uint32_t>(y) & 0xFFFF) >> 2;
+		QTreeNode** page = pages[getPageIndex(leaf_x, leaf_y)];
+		if (!page) {
+			return nullptr;
+		}
+		return page[getSlotIndex(leaf_x, leaf_y)];
+	}
+
+	void insert(int x, int y, QTreeNode* leaf);
+	void remove(int x, int y) noexcept;
+	void clear() noexcept;
+
+	// Calls func(leaf, leaf_x, leaf_y) for every leaf overlapping the tile
+	// area, leaf_x/leaf_y being the leaf's first tile. Bounds are inclusive
+	// and pages without any leaf are skipped as a whole.
+	template <typename Func>
+	void forEachLeaf(int start_x, int start_y, int end_x, int end_y, Func &&func) const {
+		if (!pages || end_x < 0 || end_y < 0 || start_x > 0xFFFF || start_y > 0xFFFF) {
+			return;
+		}
+
+		const uint32_t first_x = static_cast<uint32_t>(std::max(start_x, 0)) >> 2;
+		const uint32_t first_y = static_cast<uint32_t>(std::max(start_y, 0)) >> 2;
+		const uint32_t last_x = static_cast<uint32_t>(std::min(end_x, 0xFFFF)) >> 2;
+		const uint32_t last_y = static_cast<uint32_t>(std::min(end_y, 0xFFFF)) >> 2;
+		if (first_x > last_x || first_y > last_y) {
+			return;
+		}
+
+		for (uint32_t page_x = first_x >> PageBits; page_x <= last_x >> PageBits; ++page_x) {
+			const uint32_t from_x = std::max(first_x, page_x << PageBits);
+			const uint32_t to_x = std::min(last_x, (page_x << PageBits) | PageMask);
+			for (uint32_t page_y = first_y >> PageBits; page_y <= last_y >> PageBits; ++page_y) {
+				QTreeNode** page = pages[(page_x << DirectoryBits) | page_y];
+				if (!page) {
+					continue;
+				}
+
+				const uint32_t from_y = std::max(first_y, page_y << PageBits);
+				const uint32_t to_y = std::min(last_y, (page_y << PageBits) | PageMask);
+				for (uint32_t leaf_x = from_x; leaf_x <= to_x; ++leaf_x) {
+					for (uint32_t leaf_y = from_y; leaf_y <= to_y; ++leaf_y) {
+						if (QTreeNode* leaf = page[getSlotIndex(leaf_x, leaf_y)]) {
+							func(leaf, static_cast<int>(leaf_x << 2), static_cast<int>(leaf_y << 2));
+						}
+					}
+				}
+			}
+		}
+	}
+
+private:
+	// 16 bit coordinates with 4x4 tiles per leaf
+	static constexpr uint32_t LeafBits = 14;
+	static constexpr uint32_t PageBits = 6;
+	static constexpr uint32_t PageMask = (1 << PageBits) - 1;
+	static constexpr uint32_t DirectoryBits = LeafBits - PageBits;
+	static constexpr uint32_t PageSize = 1 << (PageBits * 2);
+	static constexpr uint32_t DirectorySize = 1 << (DirectoryBits * 2);
+
+	static uint32_t getPageIndex(uint32_t leaf_x, uint32_t leaf_y) noexcept {
+		return ((leaf_x >> PageBits) << DirectoryBits) | (leaf_y >> PageBits);
+	}
+	static uint32_t getSlotIndex(uint32_t leaf_x, uint32_t leaf_y) noexcept {
+		return ((leaf_x & PageMask) << PageBits) | (leaf_y & PageMask);
+	}
+
+	QTreeNode*** pages = nullptr;
+};
+
 #endif
@@ -0,0 +1,153 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_snapshot.h"
+#include "basemap.h"
+#include "tile.h"
+
+// Two bits of x and y per level down to the leaves, then the floor and the
+// location in the leaf
+uint64_t MapSnapshot::getIterationKey(const Position &position) noexcept {
+	uint64_t key = 0;
+	for (int shift = 14; shift >= 2; shift -= 2) {
+		key = (key << 4) | ((position.x >> shift) & 3) | (((position.y >> shift) & 3) << 2);
+	}
+	key = (key << 4) | position.z;
+	return (key << 4) | ((position.x & 3) * 4 + (position.y & 3));
+}
+
+MapSnapshot::MapSnapshot(BaseMap &map, int block_shift) :
+	map(map) {
+	// Squares are whole subtrees, so their tiles come in one piece
+	ASSERT(block_shift >= 2 && block_shift % 2 == 0);
+	// Map tiles are read in place, items they share must outlive the readers
+	PackedItem::holdReleases();
+	tiles.reserve(map.getTileCount());
+
+	int area_x = -1, area_y = -1, area_z = -1;
+	int block_x = -1, block_y = -1;
+	for (MapIterator it = map.begin(); it != map.end(); ++it) {
+		const Tile* tile = (*it)->get();
+		// Leftovers without anything on them are not worth keeping
+		if (!tile || tile->empty()) {
+			continue;
+		}
+
+		// A new tile area is written whenever the area or the floor changes,
+		// blocks only start along with one
+		const Position &position = tile->getPosition();
+		if ((position.x & 0xFF00) != area_x || (position.y & 0xFF00) != area_y || position.z != area_z) {
+			if ((position.x >> block_shift) != block_x || (position.y >> block_shift) != block_y) {
+				block_starts.push_back(tiles.size());
+				block_x = position.x >> block_shift;
+				block_y = position.y >> block_shift;
+			}
+			area_x = position.x & 0xFF00;
+			area_y = position.y & 0xFF00;
+			area_z = position.z;
+		}
+		ASSERT(tiles.empty() || getIterationKey(tiles.back()->getPosition()) < getIterationKey(position));
+		tiles.push_back(tile);
+	}
+
+	if (block_starts.empty()) {
+		block_starts.push_back(0);
+	}
+	block_states.resize(block_starts.size(), BLOCK_PENDING);
+	copied.resize(tiles.size());
+	block_starts.push_back(tiles.size());
+}
+
+MapSnapshot::~MapSnapshot() {
+	for (Tile* copy : copies) {
+		delete copy;
+	}
+	PackedItem::resumeReleases();
+}
+
+Position MapSnapshot::getBlockPosition(size_t block) const {
+	return tiles[block_starts[block]]->getPosition();
+}
+
+Position MapSnapshot::getBlockLastPosition(size_t block) const {
+	return tiles[block_starts[block + 1] - 1]->getPosition();
+}
+
+const Tile* const* MapSnapshot::acquireBlock(size_t block, size_t &count) {
+	std::lock_guard<std::mutex> lock(mutex);
+	ASSERT(block_states[block] == BLOCK_PENDING);
+	block_states[block] = BLOCK_READING;
+	count = block_starts[block + 1] - block_starts[block];
+	return tiles.data() + block_starts[block];
+}
+
+void MapSnapshot::releaseBlock(size_t block) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		block_states[block] = BLOCK_DONE;
+	}
+	released.notify_all();
+}
+
+void MapSnapshot::preserve(const Tile* tile) {
+	const uint64_t key = getIterationKey(tile->getPosition());
+	const auto it = std::lower_bound(tiles.begin(), tiles.end(), key, [](const Tile* lhs, uint64_t key) {
+		return getIterationKey(lhs->getPosition()) < key;
+	});
+	// Not in the snapshot, or already replaced by a copy
+	if (it == tiles.end() || *it != tile) {
+		return;
+	}
+
+	const size_t index = it - tiles.begin();
+	const size_t block = std::upper_bound(block_starts.begin(), block_starts.end(), index) - block_starts.begin() - 1;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	if (waitForBlock(lock, block)) {
+		copyTile(index);
+	}
+}
+
+void MapSnapshot::preserveAll() {
+	std::unique_lock<std::mutex> lock(mutex);
+	for (size_t block = 0; block < block_states.size(); ++block) {
+		if (waitForBlock(lock, block)) {
+			for (size_t index = block_starts[block]; index < block_starts[block + 1]; ++index) {
+				copyTile(index);
+			}
+		}
+	}
+}
+
+bool MapSnapshot::waitForBlock(std::unique_lock<std::mutex> &lock, size_t block) {
+	released.wait(lock, [this, block] {
+		return block_states[block] != BLOCK_READING;
+	});
+	return block_states[block] == BLOCK_PENDING;
+}
+
+void MapSnapshot::copyTile(size_t index) {
+	if (copied[index]) {
+		return;
+	}
+	Tile* copy = tiles[index]->deepCopy(map);
+	tiles[index] = copy;
+	copies.push_back(copy);
+	copied[index] = true;
+}
@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_SNAPSHOT_H
+#define RME_MAP_SNAPSHOT_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class BaseMap;
+class Position;
+class Tile;
+
+// The tiles of a map as they were at one point in time
+// Taking a snapshot only gathers pointers to the live tiles that hold
+// anything, in MapIterator order. While the snapshot is attached to its map (BaseMap::setSnapshot)
+// every tile the map is about to replace, delete or change in place is
+// handed to preserve() first, which swaps a private copy into the snapshot
+// unless the tile was already read.
+// Readers on any thread claim the tiles block by block. A block holds whole
+// runs of tiles from one 256x256 area and floor, the way they are written as
+// tile areas, and starts with the first run that begins in another square of
+// 1 << block_shift tiles. Everything else is for the thread that edits the map.
+class MapSnapshot {
+public:
+	MapSnapshot(BaseMap &map, int block_shift);
+	~MapSnapshot();
+
+	MapSnapshot(const MapSnapshot &) = delete;
+	MapSnapshot &operator=(const MapSnapshot &) = delete;
+
+	// Orders positions the way MapIterator walks the tree
+	static uint64_t getIterationKey(const Position &position) noexcept;
+
+	size_t size() const noexcept {
+		return tiles.size();
+	}
+	size_t getBlockCount() const noexcept {
+		return block_starts.size() - 1;
+	}
+	// Tiles in front of the block
+	size_t getBlockStart(size_t block) const noexcept {
+		return block_starts[block];
+	}
+	// Position of the first and the last tile in the block, not for readers
+	Position getBlockPosition(size_t block) const;
+	Position getBlockLastPosition(size_t block) const;
+
+	// The tiles stay untouched until the block is released
+	const Tile* const* acquireBlock(size_t block, size_t &count);
+	void releaseBlock(size_t block);
+
+	void preserve(const Tile* tile);
+	// Copies every tile that has not been read yet
+	void preserveAll();
+
+private:
+	enum BlockState : uint8_t {
+		BLOCK_PENDING,
+		BLOCK_READING,
+		BLOCK_DONE,
+	};
+
+	// Waits until nobody reads the block, returns true if it is still to be read
+	bool waitForBlock(std::unique_lock<std::mutex> &lock, size_t block);
+	void copyTile(size_t index);
+
+	BaseMap &map;
+	std::vector<const Tile*> tiles;
+	std::vector<size_t> block_starts;
+	std::vector<BlockState> block_states;
+	std::vector<Tile*> copies;
+	std::vector<bool> copied;
+
+	std::mutex mutex;
+	std::condition_variable released;
+};
+
+#endif
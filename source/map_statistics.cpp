@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "map_statistics.h"
+#include "tile.h"
+#include "item.h"
+#include "complexitem.h"
+
+TileStatistics &TileStatistics::operator+=(const TileStatistics &other) noexcept {
+	tile_count += other.tile_count;
+	detailed_tile_count += other.detailed_tile_count;
+	blocking_tile_count += other.blocking_tile_count;
+	walkable_tile_count += other.walkable_tile_count;
+	spawn_monster_count += other.spawn_monster_count;
+	spawn_npc_count += other.spawn_npc_count;
+	monster_count += other.monster_count;
+	npc_count += other.npc_count;
+	item_count += other.item_count;
+	loose_item_count += other.loose_item_count;
+	depot_count += other.depot_count;
+	action_item_count += other.action_item_count;
+	unique_item_count += other.unique_item_count;
+	container_count += other.container_count;
+	return *this;
+}
+
+void MapStatistics::addTile(const Tile* tile, int z) {
+	update(tile, z, 1);
+}
+
+void MapStatistics::removeTile(const Tile* tile, int z) {
+	update(tile, z, -1);
+}
+
+void MapStatistics::clear() {
+	for (TileStatistics &floor : floors) {
+		floor = TileStatistics();
+	}
+}
+
+TileStatistics MapStatistics::getTotal() const noexcept {
+	TileStatistics total;
+	for (const TileStatistics &floor : floors) {
+		total += floor;
+	}
+	return total;
+}
+
+void MapStatistics::update(const Tile* tile, int z, int64_t delta) {
+	// Only what the tile holds itself, Tile::empty also looks at the spawn
+	// radius and house exits of its location which other tiles change
+	if (!tile->ground && tile->items.empty() && !tile->getMonster() && !tile->getSpawnMonster() && !tile->getNpc() && !tile->getSpawnNpc()) {
+		return;
+	}
+
+	TileStatistics &stats = floors[z];
+	stats.tile_count += delta;
+
+	bool is_detailed = false;
+	if (tile->ground) {
+		PackedItem scratch;
+		is_detailed |= updateItem(scratch.peek(tile->ground.getSlot()), stats, delta);
+	}
+	for (const Item* item : tile->items.peek()) {
+		is_detailed |= updateItem(item, stats, delta);
+	}
+
+	if (tile->getSpawnMonster()) {
+		stats.spawn_monster_count += delta;
+	}
+	if (tile->getSpawnNpc()) {
+		stats.spawn_npc_count += delta;
+	}
+	if (tile->getMonster()) {
+		stats.monster_count += delta;
+	}
+	if (tile->getNpc()) {
+		stats.npc_count += delta;
+	}
+
+	if (tile->isBlocking()) {
+		stats.blocking_tile_count += delta;
+	} else {
+		stats.walkable_tile_count += delta;
+	}
+	if (is_detailed) {
+		stats.detailed_tile_count += delta;
+	}
+}
+
+bool MapStatistics::updateItem(const Item* item, TileStatistics &stats, int64_t delta) {
+	stats.item_count += delta;
+	if (item->isGroundTile() || item->isBorder()) {
+		return false;
+	}
+
+	const ItemType &it = g_items.getItemType(item->getID());
+	if (it.moveable) {
+		stats.loose_item_count += delta;
+	}
+	if (it.isDepot()) {
+		stats.depot_count += delta;
+	}
+	if (item->getActionID() > 0) {
+		stats.action_item_count += delta;
+	}
+	if (item->getUniqueID() > 0) {
+		stats.unique_item_count += delta;
+	}
+	if (const Container* container = dynamic_cast<const Container*>(item)) {
+		if (container->getItemCount()) {
+			stats.container_count += delta;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_MAP_STATISTICS_H
+#define RME_MAP_STATISTICS_H
+
+#include "const.h"
+
+#include <cstdint>
+
+class Tile;
+class Item;
+
+struct TileStatistics {
+	int64_t tile_count = 0; // Tiles holding a ground, an item, a creature or a spawn
+	int64_t detailed_tile_count = 0;
+	int64_t blocking_tile_count = 0;
+	int64_t walkable_tile_count = 0;
+	int64_t spawn_monster_count = 0;
+	int64_t spawn_npc_count = 0;
+	int64_t monster_count = 0;
+	int64_t npc_count = 0;
+
+	int64_t item_count = 0;
+	int64_t loose_item_count = 0;
+	int64_t depot_count = 0;
+	int64_t action_item_count = 0;
+	int64_t unique_item_count = 0;
+	int64_t container_count = 0; // Only includes containers containing more than 1 item
+
+	TileStatistics &operator+=(const TileStatistics &other) noexcept;
+};
+
+// Per floor tile, creature and item counters of a map
+// Kept up to date by Map whenever a tile is placed, swapped or removed, so
+// reading them costs nothing. Creatures and spawns put on a tile that is
+// already on the map go through Map::beginCreatureChange.
+class MapStatistics {
+public:
+	void addTile(const Tile* tile, int z);
+	void removeTile(const Tile* tile, int z);
+	void clear();
+
+	const TileStatistics &getFloor(int z) const noexcept {
+		return floors[z];
+	}
+	TileStatistics getTotal() const noexcept;
+
+private:
+	void update(const Tile* tile, int z, int64_t delta);
+	// Returns true if the item counts as detail
+	bool updateItem(const Item* item, TileStatistics &stats, int64_t delta);
+
+	TileStatistics floors[rme::MapLayers];
+};
+
+#endif
@@ -55,6 +55,8 @@ MapTab::~MapTab() {
 	if (iref->owner_count <= 0) {
 		delete iref->editor;
 		delete iref;
+		// The items of the map went into this thread's cache, let their slabs go
+		ItemAllocator::trim();
 	}
 }
 
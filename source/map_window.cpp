@@ -118,7 +118,15 @@ void MapWindow::GetViewSize(int* x, int* y) {
 
 void MapWindow::FitToMap() {
 	const Map &map = editor.getMap();
-	SetSize(map.getWidth() * rme::TileSize, map.getHeight() * rme::TileSize, true);
+	// Tiles placed beyond the declared size (imports, old maps) stay reachable
+	int width = map.getWidth();
+	int height = map.getHeight();
+	Position from, to;
+	if (map.getBounds(from, to)) {
+		width = std::max(width, to.x + 1);
+		height = std::max(height, to.y + 1);
+	}
+	SetSize(width * rme::TileSize, height * rme::TileSize, true);
 }
 
 Position MapWindow::GetScreenCenterPosition() {
@@ -366,7 +366,7 @@ void Materials::addToTileset(std::string tilesetName, int itemId, TilesetCategor
 	}
 }
 
-bool Materials::isInTileset(Item* item, std::string tilesetName) const {
+bool Materials::isInTileset(const Item* item, std::string tilesetName) const {
 	const ItemType &type = g_items.getItemType(item->getID());
 	return type.id != 0 && (isInTileset(type.brush, tilesetName) || isInTileset(type.doodad_brush, tilesetName) || isInTileset(type.raw_brush, tilesetName));
 }
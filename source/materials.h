@@ -38,7 +38,7 @@ public:
 	void addToTileset(std::string tilesetName, int itemId, TilesetCategoryType categoryType);
 	void createNpcTileset();
 
-	bool isInTileset(Item* item, std::string tileset) const;
+	bool isInTileset(const Item* item, std::string tileset) const;
 	bool isInTileset(Brush* brush, std::string tileset) const;
 	bool needSave() const {
 		return modified;
@@ -123,21 +123,16 @@ void MinimapWindow::OnPaint(wxPaintEvent &event) {
 	// printf("Draw from %d:%d to %d:%d\n", start_x, start_y, end_x, end_y);
 	uint8_t last = 0;
 	if (g_gui.IsRenderingEnabled()) {
-		for (int y = start_y, window_y = 0; y <= end_y; ++y, ++window_y) {
-			for (int x = start_x, window_x = 0; x <= end_x; ++x, ++window_x) {
-				const Tile* tile = map.getTile(x, y, floor);
-				if (tile) {
-					uint8_t color = tile->getMiniMapColor();
-					if (color) {
-						if (last != color) {
-							pdc.SetPen(*pens[color]);
-							last = color;
-						}
-						pdc.DrawPoint(window_x, window_y);
-					}
+		map.forEachTileInArea(start_x, start_y, end_x, end_y, floor, floor, [&](const Tile* tile) {
+			uint8_t color = tile->getMiniMapColor();
+			if (color) {
+				if (last != color) {
+					pdc.SetPen(*pens[color]);
+					last = color;
 				}
+				pdc.DrawPoint(tile->getX() - start_x, tile->getY() - start_y);
 			}
-		}
+		});
 
 		if (g_settings.getInteger(Config::MINIMAP_VIEW_BOX)) {
 			pdc.SetPen(*wxWHITE_PEN);
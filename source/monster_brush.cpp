@@ -64,8 +64,8 @@ bool MonsterBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void MonsterBrush::undraw(BaseMap* map, Tile* tile) {
-	delete tile->monster;
-	tile->monster = nullptr;
+	delete tile->getMonster();
+	tile->setMonster(nullptr);
 }
 
 void MonsterBrush::drawMonster(BaseMap* map, Tile* tile, void* parameter) {
@@ -74,8 +74,8 @@ void MonsterBrush::drawMonster(BaseMap* map, Tile* tile, void* parameter) {
 	if (canDraw(map, tile->getPosition())) {
 		undraw(map, tile);
 		if (monster_type) {
-			tile->monster = newd Monster(monster_type);
-			tile->monster->setSpawnMonsterTime(*(int*)parameter);
+			tile->setMonster(newd Monster(monster_type));
+			tile->getMonster()->setSpawnMonsterTime(*(int*)parameter);
 		}
 	}
 }
@@ -86,9 +86,9 @@ void MonsterBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	if (canDraw(map, tile->getPosition())) {
 		undraw(map, tile);
 		if (monster_type) {
-			if (tile->spawnMonster == nullptr && tile->getLocation()->getSpawnMonsterCount() == 0) {
+			if (tile->getSpawnMonster() == nullptr && tile->getLocation()->getSpawnMonsterCount() == 0) {
 				// manually place spawnMonster on location
-				tile->spawnMonster = newd SpawnMonster(1);
+				tile->setSpawnMonster(newd SpawnMonster(1));
 			}
 			drawMonster(map, tile, parameter);
 		}
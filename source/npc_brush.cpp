@@ -63,8 +63,8 @@ bool NpcBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void NpcBrush::undraw(BaseMap* map, Tile* tile) {
-	delete tile->npc;
-	tile->npc = nullptr;
+	delete tile->getNpc();
+	tile->setNpc(nullptr);
 }
 
 void NpcBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
@@ -73,12 +73,12 @@ void NpcBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	if (canDraw(map, tile->getPosition())) {
 		undraw(map, tile);
 		if (npc_type) {
-			if (tile->spawnNpc == nullptr && tile->getLocation()->getSpawnNpcCount() == 0) {
+			if (tile->getSpawnNpc() == nullptr && tile->getLocation()->getSpawnNpcCount() == 0) {
 				// manually place npc spawn on location
-				tile->spawnNpc = newd SpawnNpc(1);
+				tile->setSpawnNpc(newd SpawnNpc(1));
 			}
-			tile->npc = newd Npc(npc_type);
-			tile->npc->setSpawnNpcTime(*(int*)parameter);
+			tile->setNpc(newd Npc(npc_type));
+			tile->getNpc()->setSpawnNpcTime(*(int*)parameter);
 		}
 	}
 }
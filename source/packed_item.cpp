@@ -0,0 +1,207 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "packed_item.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <typeinfo>
+#include <vector>
+
+namespace {
+	// See PackedItem::holdReleases
+	std::mutex releases_mutex;
+	int releases_held = 0;
+	std::vector<Item*> held_releases;
+}
+
+bool PackedItem::canPack(const Item* item) noexcept {
+	if (!item || isPacked(item) || isShared(item) || typeid(*item) != typeid(Item)) {
+		return false;
+	}
+	return item->id != 0 && !item->attributes && item->subtype <= MaxSubtype;
+}
+
+Item* PackedItem::pack(Item* item) noexcept {
+	if (!canPack(item)) {
+		return item;
+	}
+	Item* packed = encode(item->id, item->subtype, item->selected);
+	delete item;
+	return packed;
+}
+
+Item* PackedItem::copy(Item* const &slot) {
+	Item* value = load(slot);
+	if (!value || isPacked(value)) {
+		return value;
+	}
+	if (isShared(value)) {
+		Item* item = const_cast<Item*>(getSlotItem(value));
+		uint16_t shares = item->shares.load(std::memory_order_relaxed);
+		while (shares != MaxShares) {
+			if (item->shares.compare_exchange_weak(shares, shares + 1, std::memory_order_relaxed)) {
+				return value;
+			}
+		}
+		return item->deepCopy();
+	}
+	if (canPack(value)) {
+		// Same subtype Item::deepCopy would end up with
+		return encode(value->id, value->hasSubtype() ? value->subtype : 1, value->selected);
+	}
+	// A tile is copied and edited by one thread at a time, from here on the
+	// slot shares the item too and nobody writes to it any more
+	value->shares.store(2, std::memory_order_relaxed);
+	std::atomic_ref<Item*>(const_cast<Item*&>(slot)).store(share(value), std::memory_order_release);
+	return share(value);
+}
+
+void PackedItem::destroy(Item* slot) noexcept {
+	if (isShared(slot)) {
+		release(const_cast<Item*>(getSlotItem(slot)));
+	} else if (!isPacked(slot)) {
+		delete slot;
+	}
+}
+
+void PackedItem::release(Item* item) noexcept {
+	if (item->shares.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(releases_mutex);
+		if (releases_held > 0) {
+			held_releases.push_back(item);
+			return;
+		}
+	}
+	delete item;
+}
+
+void PackedItem::holdReleases() {
+	std::lock_guard<std::mutex> lock(releases_mutex);
+	++releases_held;
+}
+
+void PackedItem::resumeReleases() {
+	std::vector<Item*> released;
+	{
+		std::lock_guard<std::mutex> lock(releases_mutex);
+		if (--releases_held == 0) {
+			released.swap(held_releases);
+		}
+	}
+	for (Item* item : released) {
+		delete item;
+	}
+}
+
+Item* PackedItem::load(Item* const &slot) noexcept {
+	return std::atomic_ref<Item*>(const_cast<Item*&>(slot)).load(std::memory_order_acquire);
+}
+
+bool PackedItem::exchange(Item* const &slot, Item*&expected, Item* desired) noexcept {
+	return std::atomic_ref<Item*>(const_cast<Item*&>(slot)).compare_exchange_strong(expected, desired, std::memory_order_acq_rel, std::memory_order_acquire);
+}
+
+Item* PackedItem::unpack(Item* const &slot) {
+	Item* value = load(slot);
+	while (isPacked(value) || isShared(value)) {
+		Item* item;
+		Item* shared = nullptr;
+		if (isPacked(value)) {
+			item = newd Item(getPackedID(value), 1);
+			item->subtype = getPackedSubtype(value);
+			item->selected = isPackedSelected(value);
+		} else {
+			// The last slot holding the item takes it back, any other gets a
+			// copy. Nobody else can share it meanwhile, that takes this tile.
+			shared = const_cast<Item*>(getSlotItem(value));
+			item = shared->shares.load(std::memory_order_acquire) == 1 ? shared : shared->deepCopy();
+		}
+		if (exchange(slot, value, item)) {
+			if (item == shared) {
+				shared->shares.store(0, std::memory_order_relaxed);
+			} else if (shared) {
+				release(shared);
+			}
+			return item;
+		}
+		// Somebody else changed the slot first, value holds what they put there
+		if (item != shared) {
+			delete item;
+		}
+	}
+	return value;
+}
+
+void PackedItem::setSelected(Item* const &slot, bool selected) {
+	Item* value = load(slot);
+	while (isPacked(value)) {
+		Item* changed = reinterpret_cast<Item*>(selected ? reinterpret_cast<uintptr_t>(value) | SelectedFlag : reinterpret_cast<uintptr_t>(value) & ~SelectedFlag);
+		if (changed == value || exchange(slot, value, changed)) {
+			return;
+		}
+	}
+	if (isShared(value)) {
+		if (getSlotItem(value)->isSelected() == selected) {
+			return;
+		}
+		value = unpack(slot);
+	}
+	if (value) {
+		if (selected) {
+			value->select();
+		} else {
+			value->deselect();
+		}
+	}
+}
+
+const Item* PackedItem::peek(const Item* slot) noexcept {
+	if (!isPacked(slot)) {
+		return getSlotItem(slot);
+	}
+	id = getPackedID(slot);
+	subtype = getPackedSubtype(slot);
+	selected = isPackedSelected(slot);
+	frame = 0;
+	return this;
+}
+
+void TileItemVector::pack() noexcept {
+	for (Item*&slot : slots) {
+		slot = PackedItem::pack(slot);
+	}
+}
+
+void TileItemVector::copyTo(TileItemVector &other) const {
+	other.slots.reserve(other.slots.size() + slots.size());
+	for (Item* const &slot : slots) {
+		other.slots.push_back(PackedItem::copy(slot));
+	}
+}
+
+void TileItemVector::checkIndex(size_t index) const {
+	if (index >= slots.size()) {
+		throw std::out_of_range("TileItemVector::at");
+	}
+}
@@ -0,0 +1,479 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_PACKED_ITEM_H
+#define RME_PACKED_ITEM_H
+
+#include "item.h"
+#include "small_vector.h"
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+// Plain items packed into the slot that would point to them
+// Most items on a map are nothing but an id and a subtype. Tiles keep those
+// packed into the pointer slot itself instead of pointing to an Item: id,
+// subtype and selection share 32 bits with the lowest bit set, which a real
+// Item* never has. A packed item is turned into a real Item the first time
+// a pointer to it is asked for, peek() reads it without unpacking.
+// Any other item is shared when its tile is copied: both slots point to it
+// with the second lowest bit set and the item counts the slots. A shared
+// item is never written to, the first time a pointer to it is asked for the
+// slot gets an item of its own, or takes it back if it is the last one.
+// Slots are loaded and unpacked atomically, the background saver reads
+// tiles while the editor may be unpacking their items.
+class PackedItem : public Item {
+public:
+	// Scratch item for peek()
+	PackedItem() :
+		Item(0, 0) { }
+
+	static bool isPacked(const Item* slot) noexcept {
+		return (reinterpret_cast<uintptr_t>(slot) & PackedTag) != 0;
+	}
+	static bool isShared(const Item* slot) noexcept {
+		return (reinterpret_cast<uintptr_t>(slot) & (PackedTag | SharedTag)) == SharedTag;
+	}
+	// True for items that carry nothing but an id and a subtype
+	static bool canPack(const Item* item) noexcept;
+	// Packs a plain item and deletes it, any other item is returned as it is
+	static Item* pack(Item* item) noexcept;
+	// Copy of whatever the slot holds, plain items come out packed and any
+	// other item is shared between the slot and the copy
+	static Item* copy(Item* const &slot);
+	// Deletes whatever the slot holds, a shared item once no slot is left
+	static void destroy(Item* slot) noexcept;
+
+	static Item* load(Item* const &slot) noexcept;
+	// Gives the slot an item of its own, returns the item in the slot
+	static Item* unpack(Item* const &slot);
+	// Changes the selection without unpacking, unless a shared item changes
+	static void setSelected(Item* const &slot, bool selected);
+
+	static uint16_t getPackedID(const Item* slot) noexcept {
+		return static_cast<uint16_t>(reinterpret_cast<uintptr_t>(slot) >> IDShift);
+	}
+	static uint16_t getPackedSubtype(const Item* slot) noexcept {
+		return static_cast<uint16_t>((reinterpret_cast<uintptr_t>(slot) >> SubtypeShift) & MaxSubtype);
+	}
+	static bool isPackedSelected(const Item* slot) noexcept {
+		return (reinterpret_cast<uintptr_t>(slot) & SelectedFlag) != 0;
+	}
+	// The item a slot points to, shared or not, nullptr for a packed one
+	static const Item* getSlotItem(const Item* slot) noexcept {
+		return isPacked(slot) ? nullptr : reinterpret_cast<const Item*>(reinterpret_cast<uintptr_t>(slot) & ~SharedTag);
+	}
+	// Id of the item in the slot, packed or not
+	static uint16_t getSlotID(const Item* slot) noexcept {
+		return isPacked(slot) ? getPackedID(slot) : getSlotItem(slot)->getID();
+	}
+	static const ItemType &getSlotType(const Item* slot) {
+		return g_items.getItemType(getSlotID(slot));
+	}
+
+	// The item in the slot, a packed one is loaded into this scratch item
+	// and only stays valid until the next call
+	const Item* peek(const Item* slot) noexcept;
+	const Item* peek(Item* const &slot) noexcept {
+		return peek(static_cast<const Item*>(load(slot)));
+	}
+
+	// Shared items dropped while a snapshot is read are only deleted once
+	// the last snapshot is gone, its readers may still be looking at them
+	static void holdReleases();
+	static void resumeReleases();
+
+private:
+	static Item* encode(uint16_t id, uint16_t subtype, bool selected) noexcept {
+		return reinterpret_cast<Item*>((uintptr_t(id) << IDShift) | (uintptr_t(subtype) << SubtypeShift) | (selected ? SelectedFlag : 0) | PackedTag);
+	}
+	static Item* share(Item* item) noexcept {
+		return reinterpret_cast<Item*>(reinterpret_cast<uintptr_t>(item) | SharedTag);
+	}
+	static bool exchange(Item* const &slot, Item*&expected, Item* desired) noexcept;
+	static void release(Item* item) noexcept;
+
+	static constexpr uintptr_t PackedTag = 1;
+	static constexpr uintptr_t SelectedFlag = 2;
+	static constexpr uintptr_t SharedTag = 2;
+	static constexpr int SubtypeShift = 2;
+	static constexpr int IDShift = 16;
+	static constexpr uint16_t MaxSubtype = 0x3FFF;
+	static constexpr uint16_t MaxShares = 0xFFFF;
+};
+
+// Holds one tile item, which may be packed or shared
+// Reads like an Item*, the item is unpacked once it is dereferenced or
+// converted to a pointer. Testing it against nullptr leaves it as it is.
+class TileItemSlot {
+public:
+	TileItemSlot() noexcept = default;
+	TileItemSlot(const TileItemSlot &) = delete;
+	TileItemSlot &operator=(const TileItemSlot &) = delete;
+
+	TileItemSlot &operator=(Item* item) noexcept {
+		value = item;
+		return *this;
+	}
+
+	Item* get() const {
+		return PackedItem::unpack(value);
+	}
+	operator Item*() const {
+		return get();
+	}
+	Item* operator->() const {
+		return get();
+	}
+	explicit operator bool() const noexcept {
+		return value != nullptr;
+	}
+	bool operator==(std::nullptr_t) const noexcept {
+		return value == nullptr;
+	}
+
+	// The raw slot, packed or not
+	Item* const &getSlot() const noexcept {
+		return value;
+	}
+	// Takes the item out without unpacking it
+	Item* release() noexcept {
+		Item* item = value;
+		value = nullptr;
+		return item;
+	}
+
+private:
+	mutable Item* value = nullptr;
+};
+
+// The items of a tile above the ground
+// Behaves like a vector of Item*, a packed or shared item is unpacked as soon as an
+// iterator or accessor hands out a pointer to it. Read only passes that go
+// over many tiles walk the items through peek() instead.
+class TileItemVector {
+	// Most tiles only carry a couple of items, keep those inside the tile
+	typedef SmallVector<Item*, 3> Slots;
+
+public:
+	class iterator;
+
+	class const_iterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef Item* value_type;
+		typedef ptrdiff_t difference_type;
+		typedef Item* const* pointer;
+		typedef Item* const &reference;
+
+		const_iterator() noexcept = default;
+
+		reference operator*() const {
+			PackedItem::unpack(*slot);
+			return *slot;
+		}
+		reference operator[](difference_type n) const {
+			return *(*this + n);
+		}
+
+		const_iterator &operator++() noexcept {
+			++slot;
+			return *this;
+		}
+		const_iterator operator++(int) noexcept {
+			return const_iterator(slot++);
+		}
+		const_iterator &operator--() noexcept {
+			--slot;
+			return *this;
+		}
+		const_iterator operator--(int) noexcept {
+			return const_iterator(slot--);
+		}
+		const_iterator &operator+=(difference_type n) noexcept {
+			slot += n;
+			return *this;
+		}
+		const_iterator &operator-=(difference_type n) noexcept {
+			slot -= n;
+			return *this;
+		}
+		friend const_iterator operator+(const_iterator it, difference_type n) noexcept {
+			return it += n;
+		}
+		friend const_iterator operator+(difference_type n, const_iterator it) noexcept {
+			return it += n;
+		}
+		friend const_iterator operator-(const_iterator it, difference_type n) noexcept {
+			return it -= n;
+		}
+		friend difference_type operator-(const const_iterator &lhs, const const_iterator &rhs) noexcept {
+			return lhs.slot - rhs.slot;
+		}
+
+		bool operator==(const const_iterator &other) const noexcept = default;
+		auto operator<=>(const const_iterator &other) const noexcept = default;
+
+	private:
+		friend class TileItemVector;
+		explicit const_iterator(Item* const* slot) noexcept :
+			slot(slot) { }
+
+		Item* const* slot = nullptr;
+	};
+
+	class iterator {
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef Item* value_type;
+		typedef ptrdiff_t difference_type;
+		typedef Item** pointer;
+		typedef Item*&reference;
+
+		iterator() noexcept = default;
+		operator const_iterator() const noexcept {
+			return const_iterator(slot);
+		}
+
+		reference operator*() const {
+			PackedItem::unpack(*slot);
+			return *slot;
+		}
+		reference operator[](difference_type n) const {
+			return *(*this + n);
+		}
+
+		iterator &operator++() noexcept {
+			++slot;
+			return *this;
+		}
+		iterator operator++(int) noexcept {
+			return iterator(slot++);
+		}
+		iterator &operator--() noexcept {
+			--slot;
+			return *this;
+		}
+		iterator operator--(int) noexcept {
+			return iterator(slot--);
+		}
+		iterator &operator+=(difference_type n) noexcept {
+			slot += n;
+			return *this;
+		}
+		iterator &operator-=(difference_type n) noexcept {
+			slot -= n;
+			return *this;
+		}
+		friend iterator operator+(iterator it, difference_type n) noexcept {
+			return it += n;
+		}
+		friend iterator operator+(difference_type n, iterator it) noexcept {
+			return it += n;
+		}
+		friend iterator operator-(iterator it, difference_type n) noexcept {
+			return it -= n;
+		}
+		friend difference_type operator-(const iterator &lhs, const iterator &rhs) noexcept {
+			return lhs.slot - rhs.slot;
+		}
+
+		bool operator==(const iterator &other) const noexcept = default;
+		auto operator<=>(const iterator &other) const noexcept = default;
+
+	private:
+		friend class TileItemVector;
+		explicit iterator(Item** slot) noexcept :
+			slot(slot) { }
+
+		Item** slot = nullptr;
+	};
+
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	// Walks the items without unpacking them, see PackedItem::peek
+	class PeekRange {
+	public:
+		class Iterator {
+		public:
+			const Item* operator*() const noexcept {
+				return scratch->peek(*slot);
+			}
+			Iterator &operator++() noexcept {
+				++slot;
+				return *this;
+			}
+			bool operator==(const Iterator &other) const noexcept {
+				return slot == other.slot;
+			}
+
+		private:
+			friend class PeekRange;
+			Iterator(Item* const* slot, PackedItem* scratch) noexcept :
+				slot(slot), scratch(scratch) { }
+
+			Item* const* slot;
+			PackedItem* scratch;
+		};
+
+		Iterator begin() noexcept {
+			return Iterator(first, &scratch);
+		}
+		Iterator end() noexcept {
+			return Iterator(last, &scratch);
+		}
+
+	private:
+		friend class TileItemVector;
+		PeekRange(Item* const* first, Item* const* last) noexcept :
+			first(first), last(last) { }
+
+		Item* const* first;
+		Item* const* last;
+		PackedItem scratch;
+	};
+
+	// Capacity
+	bool empty() const noexcept {
+		return slots.empty();
+	}
+	size_t size() const noexcept {
+		return slots.size();
+	}
+	size_t capacity() const noexcept {
+		return slots.capacity();
+	}
+	// True while the slots live inside the tile
+	bool isInline() const noexcept {
+		return slots.isInline();
+	}
+	void reserve(size_t wanted) {
+		slots.reserve(wanted);
+	}
+
+	// Iterators, dereferencing one unpacks the item
+	iterator begin() noexcept {
+		return iterator(slots.data());
+	}
+	const_iterator begin() const noexcept {
+		return const_iterator(slots.data());
+	}
+	const_iterator cbegin() const noexcept {
+		return begin();
+	}
+	iterator end() noexcept {
+		return iterator(slots.data() + slots.size());
+	}
+	const_iterator end() const noexcept {
+		return const_iterator(slots.data() + slots.size());
+	}
+	const_iterator cend() const noexcept {
+		return end();
+	}
+	reverse_iterator rbegin() noexcept {
+		return reverse_iterator(end());
+	}
+	const_reverse_iterator rbegin() const noexcept {
+		return const_reverse_iterator(end());
+	}
+	reverse_iterator rend() noexcept {
+		return reverse_iterator(begin());
+	}
+	const_reverse_iterator rend() const noexcept {
+		return const_reverse_iterator(begin());
+	}
+
+	// Element access, unpacks the item
+	Item*&operator[](size_t index) {
+		return *(begin() + index);
+	}
+	Item* const &operator[](size_t index) const {
+		return *(begin() + index);
+	}
+	Item*&at(size_t index) {
+		checkIndex(index);
+		return (*this)[index];
+	}
+	Item* const &at(size_t index) const {
+		checkIndex(index);
+		return (*this)[index];
+	}
+	Item*&front() {
+		return *begin();
+	}
+	Item* const &front() const {
+		return *begin();
+	}
+	Item*&back() {
+		return *(end() - 1);
+	}
+	Item* const &back() const {
+		return *(end() - 1);
+	}
+
+	// Modifiers, they neither delete nor unpack anything
+	void clear() noexcept {
+		slots.clear();
+	}
+	void push_back(Item* item) {
+		slots.push_back(item);
+	}
+	void pop_back() noexcept {
+		slots.pop_back();
+	}
+	iterator insert(const_iterator position, Item* item) {
+		return iterator(slots.insert(position.slot, item));
+	}
+	iterator erase(const_iterator position) noexcept {
+		return iterator(slots.erase(position.slot));
+	}
+	iterator erase(const_iterator first, const_iterator last) noexcept {
+		return iterator(slots.erase(first.slot, last.slot));
+	}
+	// Deletes the item in the slot, unpacked or not, and removes the slot
+	iterator destroy(const_iterator position) noexcept {
+		PackedItem::destroy(*position.slot);
+		return erase(position);
+	}
+	void swap(TileItemVector &other) noexcept {
+		slots.swap(other.slots);
+	}
+
+	// Slot access, nothing gets unpacked
+	Item* const &getSlot(size_t index) const noexcept {
+		return slots[index];
+	}
+	PeekRange peek() const noexcept {
+		return PeekRange(slots.data(), slots.data() + slots.size());
+	}
+	// Packs every plain item, only for items nobody else points to yet
+	void pack() noexcept;
+	// Copies the items into an empty vector, plain items come out packed and
+	// the others are shared
+	void copyTo(TileItemVector &other) const;
+
+private:
+	void checkIndex(size_t index) const;
+
+	// Unpacking swaps the item into the slot on otherwise const tiles
+	mutable Slots slots;
+};
+
+#endif
@@ -326,6 +326,13 @@ void HousePalettePanel::OnListBoxDoubleClick(wxCommandEvent &event) {
 	// I find it extremly unlikely that one actually wants the exit at 0,0,0, so just treat it as the null value
 	if (house && house->getExit() != Position(0, 0, 0)) {
 		g_gui.SetScreenCenterPosition(house->getExit());
+		return;
+	}
+
+	// No exit yet, go to the middle of the house instead
+	Position from, to;
+	if (house && house->getBounds(from, to)) {
+		g_gui.SetScreenCenterPosition(Position((from.x + to.x) / 2, (from.y + to.y) / 2, to.z));
 	}
 }
 
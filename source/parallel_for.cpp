@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "parallel_for.h"
+
+#include <atomic>
+#include <memory>
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+namespace {
+	// Remaining blocks of one thread, begin in the low and end in the high half
+	// so the owner and thieves can both update it with a single CAS.
+	struct alignas(64) BlockRange {
+		std::atomic<uint64_t> packed { 0 };
+
+		static uint64_t pack(uint32_t begin, uint32_t end) noexcept {
+			return uint64_t(end) << 32 | begin;
+		}
+		static uint32_t begin(uint64_t range) noexcept {
+			return static_cast<uint32_t>(range);
+		}
+		static uint32_t end(uint64_t range) noexcept {
+			return static_cast<uint32_t>(range >> 32);
+		}
+	};
+
+	bool takeBlock(BlockRange &range, size_t &block) noexcept {
+		uint64_t current = range.packed.load();
+		while (BlockRange::begin(current) < BlockRange::end(current)) {
+			const uint32_t begin = BlockRange::begin(current);
+			if (range.packed.compare_exchange_weak(current, BlockRange::pack(begin + 1, BlockRange::end(current)))) {
+				block = begin;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Moves the back half of the largest range into the (empty) range of thief
+	bool stealBlocks(BlockRange* ranges, size_t range_count, BlockRange &thief) noexcept {
+		while (true) {
+			BlockRange* victim = nullptr;
+			uint64_t victim_range = 0;
+			uint32_t largest = 0;
+			for (size_t i = 0; i < range_count; ++i) {
+				const uint64_t current = ranges[i].packed.load();
+				const uint32_t remaining = BlockRange::end(current) - std::min(BlockRange::begin(current), BlockRange::end(current));
+				if (remaining > largest) {
+					victim = &ranges[i];
+					victim_range = current;
+					largest = remaining;
+				}
+			}
+			if (!victim) {
+				return false;
+			}
+
+			const uint32_t end = BlockRange::end(victim_range);
+			const uint32_t middle = end - (largest + 1) / 2;
+			if (victim->packed.compare_exchange_strong(victim_range, BlockRange::pack(BlockRange::begin(victim_range), middle))) {
+				// Nobody touches an empty range, so a plain store is enough
+				thief.packed.store(BlockRange::pack(middle, end));
+				return true;
+			}
+		}
+	}
+}
+
+void parallelForBlocks(size_t count, const std::function<void(size_t)> &body, const std::function<void(size_t, size_t)> &progress) {
+	if (count == 0) {
+		return;
+	}
+
+#ifdef _OPENMP
+	const size_t thread_count = std::min<size_t>(std::max(omp_get_max_threads(), 1), count);
+#else
+	const size_t thread_count = 1;
+#endif
+	if (thread_count == 1) {
+		for (size_t block = 0; block < count; ++block) {
+			body(block);
+			if (progress) {
+				progress(block + 1, count);
+			}
+		}
+		return;
+	}
+
+#ifdef _OPENMP
+	std::unique_ptr<BlockRange[]> ranges(newd BlockRange[thread_count]);
+	for (size_t i = 0; i < thread_count; ++i) {
+		ranges[i].packed.store(BlockRange::pack(static_cast<uint32_t>(count * i / thread_count), static_cast<uint32_t>(count * (i + 1) / thread_count)));
+	}
+	std::atomic<size_t> done { 0 };
+
+	#pragma omp parallel num_threads(static_cast<int>(thread_count))
+	{
+		// The team may be smaller than asked for, missing threads get robbed
+		BlockRange &own = ranges[omp_get_thread_num()];
+		const bool reporting = progress && omp_get_thread_num() == 0;
+
+		size_t block;
+		while (true) {
+			if (!takeBlock(own, block)) {
+				if (stealBlocks(ranges.get(), thread_count, own)) {
+					continue;
+				}
+				break;
+			}
+
+			body(block);
+			const size_t finished = ++done;
+			if (reporting) {
+				progress(finished, count);
+			}
+		}
+	}
+
+	if (progress) {
+		progress(count, count);
+	}
+#endif
+}
@@ -0,0 +1,34 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_PARALLEL_FOR_H
+#define RME_PARALLEL_FOR_H
+
+#include <cstddef>
+#include <functional>
+
+// Runs body(block) once for every block in [0, count) on all OpenMP threads
+// Each thread starts out owning an even contiguous share of the blocks and
+// takes them from the front, a thread that runs dry steals the back half of
+// the largest share left. Blocks are handed out in no particular order, so
+// results that must not depend on scheduling should be kept per block and
+// combined afterwards. progress(done, count) is only ever called from the
+// calling thread, which makes it safe to drive GUI feedback from it.
+// body must not throw. Without OpenMP everything runs on the calling thread.
+void parallelForBlocks(size_t count, const std::function<void(size_t)> &body, const std::function<void(size_t, size_t)> &progress = nullptr);
+
+#endif
@@ -22,6 +22,7 @@
 #include <cstdint>
 #include <vector>
 #include <list>
+#include <functional>
 
 class Position {
 public:
@@ -141,4 +142,15 @@ inline Position abs(const Position &position) {
 typedef std::vector<Position> PositionVector;
 typedef std::list<Position> PositionList;
 
+namespace std {
+	template <>
+	struct hash<Position> {
+		size_t operator()(const Position &position) const noexcept {
+			// x and y fit in 16 bits, z in 4
+			const uint64_t key = (static_cast<uint64_t>(position.z & 0xF) << 32) | (static_cast<uint64_t>(position.y & 0xFFFF) << 16) | static_cast<uint64_t>(position.x & 0xFFFF);
+			return hash<uint64_t>()(key);
+		}
+	};
+}
+
 #endif
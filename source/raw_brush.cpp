@@ -64,7 +64,7 @@ void RAWBrush::undraw(BaseMap* map, Tile* tile) {
 		delete tile->ground;
 		tile->ground = nullptr;
 	}
-	for (ItemVector::iterator iter = tile->items.begin(); iter != tile->items.end();) {
+	for (TileItemVector::iterator iter = tile->items.begin(); iter != tile->items.end();) {
 		Item* item = *iter;
 		if (item->getID() == itemtype->id) {
 			delete item;
@@ -82,7 +82,7 @@ void RAWBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 
 	bool b = parameter ? *reinterpret_cast<bool*>(parameter) : false;
 	if ((g_settings.getInteger(Config::RAW_LIKE_SIMONE) && !b) && itemtype->alwaysOnBottom && itemtype->alwaysOnTopOrder == 2) {
-		for (ItemVector::iterator iter = tile->items.begin(); iter != tile->items.end();) {
+		for (TileItemVector::iterator iter = tile->items.begin(); iter != tile->items.end();) {
 			Item* item = *iter;
 			if (item->getTopOrder() == itemtype->alwaysOnTopOrder) {
 				delete item;
@@ -89,16 +89,14 @@ struct ItemFinder {
 	ItemFinder(uint16_t itemid, int32_t limit = -1) :
 		itemid(itemid), limit(limit), exceeded(false) { }
 
-	void operator()(Map &map, Tile* tile, Item* item, long long done) {
-		if (exceeded) {
-			return;
-		}
+	bool operator()(Map &map, Tile* tile, const Item* item, long long done) {
+		return !exceeded && item->getID() == itemid;
+	}
 
-		if (item->getID() == itemid) {
-			result.push_back(std::make_pair(tile, item));
-			if (limit > 0 && result.size() >= size_t(limit)) {
-				exceeded = true;
-			}
+	void add(Tile* tile, Item* item) {
+		result.push_back(std::make_pair(tile, item));
+		if (limit > 0 && result.size() >= size_t(limit)) {
+			exceeded = true;
 		}
 	}
 
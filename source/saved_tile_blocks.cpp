@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#include "main.h"
+
+#include "saved_tile_blocks.h"
+#include "filehandle.h"
+
+void SavedTileBlocks::reset(std::shared_ptr<FileRangeReadHandle> new_file, uint64_t new_format) {
+	file = std::move(new_file);
+	format = new_format;
+	blocks.clear();
+}
+
+void SavedTileBlocks::clear() {
+	file.reset();
+	format = 0;
+	blocks.clear();
+}
+
+SavedTileBlocks::Range SavedTileBlocks::find(const Position &first, const Position &last, uint32_t tile_count) const {
+	if (!file) {
+		return Range();
+	}
+	const auto it = blocks.find(getBlockKey(first));
+	if (it == blocks.end()) {
+		return Range();
+	}
+	const Block &block = it->second;
+	return block.first == first && block.last == last && block.tile_count == tile_count ? block.range : Range();
+}
+
+void SavedTileBlocks::eraseSquare(BlockMap &from, uint32_t key) {
+	// Blocks don't overlap, the ones that reach into the square come right
+	// before the first block starting after it
+	auto it = from.upper_bound(key);
+	while (it != from.begin()) {
+		--it;
+		if (getBlockKey(it->second.last) < key) {
+			break;
+		}
+		it = from.erase(it);
+	}
+}
+
+void SavedTileBlocks::forgetBlock(uint32_t key) {
+	eraseSquare(blocks, key);
+	if (saving && !forgot_all) {
+		forgotten.insert(key);
+	}
+}
+
+void SavedTileBlocks::forgetAll() {
+	blocks.clear();
+	if (saving) {
+		forgot_all = true;
+		forgotten.clear();
+	}
+}
+
+void SavedTileBlocks::beginSave() {
+	saving = true;
+	forgot_all = false;
+	forgotten.clear();
+}
+
+void SavedTileBlocks::finishSave(std::shared_ptr<FileRangeReadHandle> new_file, uint64_t new_format, std::vector<Block> &&new_blocks) {
+	if (new_file) {
+		file = std::move(new_file);
+		format = new_format;
+		blocks.clear();
+		if (!forgot_all) {
+			for (const Block &block : new_blocks) {
+				add(block);
+			}
+		}
+		for (uint32_t key : forgotten) {
+			eraseSquare(blocks, key);
+		}
+	}
+
+	saving = false;
+	forgot_all = false;
+	forgotten.clear();
+}
@@ -0,0 +1,118 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SAVED_TILE_BLOCKS_H
+#define RME_SAVED_TILE_BLOCKS_H
+
+#include "position.h"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+class FileRangeReadHandle;
+
+// Where the tiles of a map lie in the file it was last loaded from or saved to
+// Maps are saved in blocks, runs of whole tile areas that start in one square
+// of tiles (see MapSnapshot). The bytes of a block can be copied from that
+// file as they are while the block holds the very same tiles and nothing in
+// the squares it covers was touched since, any change to a tile forgets the
+// blocks that cover its square.
+class SavedTileBlocks {
+public:
+	static constexpr int BlockShift = 6;
+	static_assert(BlockShift % 2 == 0, "squares have to be whole subtrees");
+
+	struct Range {
+		uint64_t offset = 0;
+		uint64_t size = 0;
+	};
+
+	struct Block {
+		Position first;
+		Position last;
+		uint32_t tile_count = 0;
+		Range range;
+	};
+
+	// Squares are numbered in the order MapIterator visits them
+	static uint32_t getBlockKey(int x, int y) noexcept {
+		uint32_t key = 0;
+		for (int shift = 14; shift >= BlockShift; shift -= 2) {
+			key = (key << 4) | ((x >> shift) & 3) | (((y >> shift) & 3) << 2);
+		}
+		return key;
+	}
+	static uint32_t getBlockKey(const Position &position) noexcept {
+		return getBlockKey(position.x, position.y);
+	}
+
+	// Starts over with the blocks of another file, format tells how the tiles
+	// in it are encoded and has to match for them to be copied
+	void reset(std::shared_ptr<FileRangeReadHandle> new_file, uint64_t new_format);
+	void clear();
+	void setFile(std::shared_ptr<FileRangeReadHandle> new_file) {
+		file = std::move(new_file);
+	}
+	void add(const Block &block) {
+		blocks[getBlockKey(block.first)] = block;
+	}
+
+	const std::shared_ptr<FileRangeReadHandle> &getFile() const noexcept {
+		return file;
+	}
+	uint64_t getFormat() const noexcept {
+		return format;
+	}
+	// Where a block of exactly these tiles lies, an empty range if it is not known
+	Range find(const Position &first, const Position &last, uint32_t tile_count) const;
+
+	void forget(int x, int y) {
+		if (!blocks.empty() || saving) {
+			forgetBlock(getBlockKey(x, y));
+		}
+	}
+	// Same as forget, by the key of the square
+	void forgetBlock(uint32_t key);
+	void forgetAll();
+
+	// Blocks changed while a save is running are also forgotten in the file
+	// that is being written, see finishSave
+	void beginSave();
+	// Switches over to the file that was just written, nullptr keeps the
+	// blocks of the file from before
+	void finishSave(std::shared_ptr<FileRangeReadHandle> new_file, uint64_t new_format, std::vector<Block> &&new_blocks);
+
+private:
+	typedef std::map<uint32_t, Block> BlockMap;
+
+	// Drops the blocks that cover the square
+	static void eraseSquare(BlockMap &from, uint32_t key);
+
+	std::shared_ptr<FileRangeReadHandle> file;
+	uint64_t format = 0;
+	// By the square of their first tile
+	BlockMap blocks;
+
+	bool saving = false;
+	bool forgot_all = false;
+	std::unordered_set<uint32_t> forgotten;
+};
+
+#endif
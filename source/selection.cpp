@@ -89,10 +89,12 @@ void Selection::add(const Tile* tile, Item* item) {
 		return;
 	}
 
-	// Make a copy of the tile with the item selected
-	item->select();
+	// Make a copy of the tile with the item selected, the copy shares its
+	// items with the tile so the item is selected on the copy
 	Tile* new_tile = tile->deepCopy(editor.getMap());
-	item->deselect();
+	Item* new_item = new_tile->getItemAt(tile->getIndexOf(item));
+	ASSERT(new_item);
+	new_item->select();
 
 	if (g_settings.getInteger(Config::BORDER_IS_GROUND)) {
 		if (item->isBorder()) {
@@ -186,12 +188,10 @@ void Selection::remove(Tile* tile, Item* item) {
 	ASSERT(tile);
 	ASSERT(item);
 
-	bool selected = item->isSelected();
-	item->deselect();
 	Tile* new_tile = tile->deepCopy(editor.getMap());
-	if (selected) {
-		item->select();
-	}
+	Item* new_item = new_tile->getItemAt(tile->getIndexOf(item));
+	ASSERT(new_item);
+	new_item->deselect();
 	if (item->isBorder() && g_settings.getInteger(Config::BORDER_IS_GROUND)) {
 		new_tile->deselectGround();
 	}
@@ -384,16 +384,9 @@ wxThread::ExitCode SelectionThread::Entry() {
 	selection.start(Selection::SUBTHREAD);
 	bool compesated = g_settings.getInteger(Config::COMPENSATED_SELECT);
 	for (int z = start.z; z >= end.z; --z) {
-		for (int x = start.x; x <= end.x; ++x) {
-			for (int y = start.y; y <= end.y; ++y) {
-				Tile* tile = editor.getMap().getTile(x, y, z);
-				if (!tile) {
-					continue;
-				}
-
-				selection.add(tile);
-			}
-		}
+		editor.getMap().forEachTileInArea(start.x, start.y, end.x, end.y, z, z, [&](Tile* tile) {
+			selection.add(tile);
+		});
 		if (compesated && z <= rme::MapGroundLayer) {
 			++start.x;
 			++start.y;
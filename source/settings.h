@@ -81,6 +81,7 @@ namespace Config {
 		BORDERIZE_PASTE_THRESHOLD,
 		ICON_BACKGROUND,
 		ALWAYS_MAKE_BACKUP,
+		SAVE_IN_BACKGROUND,
 		USE_AUTOMAGIC,
 		HOUSE_BRUSH_REMOVE_ITEMS,
 		AUTO_ASSIGN_DOORID,
@@ -0,0 +1,220 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SLAB_POOL_H
+#define RME_SLAB_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+struct SlabPoolStats {
+	size_t live_objects = 0;
+	size_t used_bytes = 0; // Bytes held by live objects
+	size_t reserved_bytes = 0; // Bytes requested from the system
+
+	// Share of the reserved memory that does not hold a live object (0.0 - 1.0)
+	double getFragmentation() const noexcept {
+		if (reserved_bytes == 0) {
+			return 0.0;
+		}
+		return 1.0 - double(used_bytes) / double(reserved_bytes);
+	}
+
+	SlabPoolStats &operator+=(const SlabPoolStats &other) noexcept {
+		live_objects += other.live_objects;
+		used_bytes += other.used_bytes;
+		reserved_bytes += other.reserved_bytes;
+		return *this;
+	}
+};
+
+// Fixed size block arena
+// Blocks are carved out of large slabs, each slab recycles its own blocks
+// through an intrusive free list. A slab that has no live object left goes
+// back to the system, except for one kept around so an object coming and
+// going at the edge of a slab does not allocate a whole slab every time.
+// Once the arena holds no object at all everything is returned. The arena
+// only deals with raw memory, constructing and destroying the objects is up
+// to the caller.
+// Not thread safe, callers sharing an arena between threads must lock it.
+class SlabArena {
+public:
+	SlabArena(size_t object_size, size_t object_align, size_t slab_objects) :
+		object_size(object_size),
+		block_size(blockSizeFor(object_size, object_align)),
+		slab_objects(slab_objects) {
+		////
+	}
+	~SlabArena() {
+		release();
+	}
+
+	SlabArena(const SlabArena &) = delete;
+	SlabArena &operator=(const SlabArena &) = delete;
+
+	void* allocate() {
+		if (partial.empty()) {
+			addSlab();
+		}
+
+		Slab* slab = partial.back();
+		void* block;
+		if (slab->free_list) {
+			block = slab->free_list;
+			slab->free_list = slab->free_list->next;
+		} else {
+			block = slab->memory + slab->used * block_size;
+			++slab->used;
+		}
+
+		if (slab->live++ == 0) {
+			--empty_slabs;
+		}
+		if (slab->live == slab_objects) {
+			partial.pop_back();
+		}
+		++live_objects;
+		return block;
+	}
+
+	void deallocate(void* ptr) noexcept {
+		if (!ptr) {
+			return;
+		}
+
+		Slab* slab = findSlab(ptr);
+		FreeBlock* block = static_cast<FreeBlock*>(ptr);
+		block->next = slab->free_list;
+		slab->free_list = block;
+
+		if (slab->live-- == slab_objects) {
+			partial.push_back(slab);
+		}
+		if (--live_objects == 0) {
+			release();
+		} else if (slab->live == 0) {
+			if (empty_slabs > 0) {
+				removeSlab(slab);
+			} else {
+				++empty_slabs;
+			}
+		}
+	}
+
+	// Returns every slab to the system in one go
+	// Any object still living in the arena is left dangling, so only call
+	// this once they have all been destroyed.
+	void release() noexcept {
+		for (Slab* slab : slabs) {
+			delete[] slab->memory;
+			delete slab;
+		}
+		slabs.clear();
+		partial.clear();
+		empty_slabs = 0;
+		live_objects = 0;
+	}
+
+	// Exchanges all blocks with an arena of the same block size
+	void swap(SlabArena &other) noexcept {
+		std::swap(slabs, other.slabs);
+		std::swap(partial, other.partial);
+		std::swap(empty_slabs, other.empty_slabs);
+		std::swap(live_objects, other.live_objects);
+	}
+
+	size_t getLiveObjects() const noexcept {
+		return live_objects;
+	}
+
+	SlabPoolStats getStats() const noexcept {
+		SlabPoolStats stats;
+		stats.live_objects = live_objects;
+		stats.used_bytes = live_objects * object_size;
+		stats.reserved_bytes = slabs.size() * slab_objects * block_size;
+		return stats;
+	}
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	struct Slab {
+		uint8_t* memory = nullptr;
+		FreeBlock* free_list = nullptr;
+		size_t used = 0; // Blocks carved out so far
+		size_t live = 0;
+	};
+
+	static constexpr size_t blockSizeFor(size_t size, size_t align) noexcept {
+		if (align < alignof(FreeBlock)) {
+			align = alignof(FreeBlock);
+		}
+		if (size < sizeof(FreeBlock)) {
+			size = sizeof(FreeBlock);
+		}
+		return (size + align - 1) / align * align;
+	}
+
+	static bool isBefore(const uint8_t* ptr, const Slab* slab) noexcept {
+		return std::less<const uint8_t*>()(ptr, slab->memory);
+	}
+
+	void addSlab() {
+		Slab* slab = newd Slab;
+		slab->memory = newd uint8_t[slab_objects * block_size];
+		slabs.insert(std::upper_bound(slabs.begin(), slabs.end(), slab->memory, isBefore), slab);
+		partial.push_back(slab);
+		++empty_slabs;
+	}
+
+	void removeSlab(Slab* slab) noexcept {
+		slabs.erase(std::upper_bound(slabs.begin(), slabs.end(), slab->memory, isBefore) - 1);
+		partial.erase(std::find(partial.begin(), partial.end(), slab));
+		delete[] slab->memory;
+		delete slab;
+	}
+
+	// The slab a block was carved out of, slabs are kept ordered by address
+	Slab* findSlab(void* ptr) const noexcept {
+		return *(std::upper_bound(slabs.begin(), slabs.end(), static_cast<const uint8_t*>(ptr), isBefore) - 1);
+	}
+
+	const size_t object_size;
+	const size_t block_size;
+	const size_t slab_objects;
+
+	std::vector<Slab*> slabs;
+	std::vector<Slab*> partial; // Slabs with room for another block
+	size_t empty_slabs = 0;
+	size_t live_objects = 0;
+};
+
+// Typed shorthand for an arena holding objects of a single class
+template <typename T, size_t SlabObjects = 1024>
+class SlabPool : public SlabArena {
+public:
+	SlabPool() :
+		SlabArena(sizeof(T), alignof(T), SlabObjects) { }
+};
+
+#endif
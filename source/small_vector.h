@@ -0,0 +1,308 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SMALL_VECTOR_H
+#define RME_SMALL_VECTOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+// Vector with room for a few elements inside the object itself
+// Only spills to the heap once more than N elements are stored, the inline
+// buffer shares its space with the heap pointer so the object stays small.
+// Restricted to trivially copyable types (pointers mostly), elements are
+// moved around with memmove and never constructed or destroyed.
+template <typename T, size_t N>
+class SmallVector {
+	static_assert(std::is_trivially_copyable<T>::value, "SmallVector only holds trivially copyable types");
+	static_assert(N > 0, "SmallVector needs an inline capacity");
+
+public:
+	typedef T value_type;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+	typedef T &reference;
+	typedef const T &const_reference;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T* iterator;
+	typedef const T* const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	SmallVector() noexcept { }
+	SmallVector(const SmallVector &other) {
+		assign(other.begin(), other.end());
+	}
+	SmallVector(SmallVector &&other) noexcept {
+		steal(other);
+	}
+	~SmallVector() {
+		if (!isInline()) {
+			delete[] storage.heap;
+		}
+	}
+
+	SmallVector &operator=(const SmallVector &other) {
+		if (this != &other) {
+			assign(other.begin(), other.end());
+		}
+		return *this;
+	}
+	SmallVector &operator=(SmallVector &&other) noexcept {
+		if (this != &other) {
+			if (!isInline()) {
+				delete[] storage.heap;
+			}
+			steal(other);
+		}
+		return *this;
+	}
+
+	template <typename InputIt>
+	void assign(InputIt first, InputIt last) {
+		clear();
+		insert(end(), first, last);
+	}
+
+	// Element access
+	T* data() noexcept {
+		return isInline() ? storage.inline_items : storage.heap;
+	}
+	const T* data() const noexcept {
+		return isInline() ? storage.inline_items : storage.heap;
+	}
+
+	reference operator[](size_t index) noexcept {
+		return data()[index];
+	}
+	const_reference operator[](size_t index) const noexcept {
+		return data()[index];
+	}
+	reference at(size_t index) {
+		if (index >= count) {
+			throw std::out_of_range("SmallVector::at");
+		}
+		return data()[index];
+	}
+	const_reference at(size_t index) const {
+		if (index >= count) {
+			throw std::out_of_range("SmallVector::at");
+		}
+		return data()[index];
+	}
+
+	reference front() noexcept {
+		return data()[0];
+	}
+	const_reference front() const noexcept {
+		return data()[0];
+	}
+	reference back() noexcept {
+		return data()[count - 1];
+	}
+	const_reference back() const noexcept {
+		return data()[count - 1];
+	}
+
+	// Iterators
+	iterator begin() noexcept {
+		return data();
+	}
+	const_iterator begin() const noexcept {
+		return data();
+	}
+	const_iterator cbegin() const noexcept {
+		return data();
+	}
+	iterator end() noexcept {
+		return data() + count;
+	}
+	const_iterator end() const noexcept {
+		return data() + count;
+	}
+	const_iterator cend() const noexcept {
+		return data() + count;
+	}
+	reverse_iterator rbegin() noexcept {
+		return reverse_iterator(end());
+	}
+	const_reverse_iterator rbegin() const noexcept {
+		return const_reverse_iterator(end());
+	}
+	reverse_iterator rend() noexcept {
+		return reverse_iterator(begin());
+	}
+	const_reverse_iterator rend() const noexcept {
+		return const_reverse_iterator(begin());
+	}
+
+	// Capacity
+	bool empty() const noexcept {
+		return count == 0;
+	}
+	size_t size() const noexcept {
+		return count;
+	}
+	size_t capacity() const noexcept {
+		return reserved;
+	}
+	// True while the elements live inside the object
+	bool isInline() const noexcept {
+		return reserved == N;
+	}
+
+	void reserve(size_t wanted) {
+		if (wanted <= reserved) {
+			return;
+		}
+
+		T* items = newd T[wanted];
+		if (count > 0) {
+			std::memcpy(static_cast<void*>(items), data(), count * sizeof(T));
+		}
+		if (!isInline()) {
+			delete[] storage.heap;
+		}
+		storage.heap = items;
+		reserved = static_cast<uint32_t>(wanted);
+	}
+
+	// Moves the elements back inside the object when they fit
+	void shrink_to_fit() noexcept {
+		if (isInline() || count > N) {
+			return;
+		}
+
+		T* items = storage.heap;
+		if (count > 0) {
+			std::memcpy(static_cast<void*>(storage.inline_items), items, count * sizeof(T));
+		}
+		delete[] items;
+		reserved = N;
+	}
+
+	// Modifiers
+	void clear() noexcept {
+		count = 0;
+	}
+
+	void push_back(const T &value) {
+		if (count == reserved) {
+			// value may point into our own storage
+			const T copy = value;
+			grow(count + 1);
+			data()[count++] = copy;
+			return;
+		}
+		data()[count++] = value;
+	}
+	void pop_back() noexcept {
+		--count;
+	}
+
+	iterator insert(const_iterator position, const T &value) {
+		const size_t index = position - begin();
+		const T copy = value;
+		if (count == reserved) {
+			grow(count + 1);
+		}
+
+		T* items = data();
+		std::memmove(static_cast<void*>(items + index + 1), items + index, (count - index) * sizeof(T));
+		items[index] = copy;
+		++count;
+		return items + index;
+	}
+
+	template <typename InputIt>
+	iterator insert(const_iterator position, InputIt first, InputIt last) {
+		const size_t index = position - begin();
+		const size_t added = std::distance(first, last);
+		if (added == 0) {
+			return begin() + index;
+		}
+		if (count + added > reserved) {
+			grow(count + added);
+		}
+
+		T* items = data();
+		std::memmove(static_cast<void*>(items + index + added), items + index, (count - index) * sizeof(T));
+		std::copy(first, last, items + index);
+		count += static_cast<uint32_t>(added);
+		return items + index;
+	}
+
+	iterator erase(const_iterator position) noexcept {
+		return erase(position, position + 1);
+	}
+	iterator erase(const_iterator first, const_iterator last) noexcept {
+		T* items = data();
+		const size_t index = first - items;
+		const size_t removed = last - first;
+		std::memmove(static_cast<void*>(items + index), items + index + removed, (count - index - removed) * sizeof(T));
+		count -= static_cast<uint32_t>(removed);
+		return items + index;
+	}
+
+	void swap(SmallVector &other) noexcept {
+		SmallVector temp(std::move(other));
+		other = std::move(*this);
+		*this = std::move(temp);
+	}
+
+private:
+	void grow(size_t wanted) {
+		reserve(std::max<size_t>(wanted, reserved * 2));
+	}
+
+	void steal(SmallVector &other) noexcept {
+		count = other.count;
+		reserved = other.reserved;
+		if (other.isInline()) {
+			std::memcpy(static_cast<void*>(storage.inline_items), other.storage.inline_items, count * sizeof(T));
+		} else {
+			storage.heap = other.storage.heap;
+		}
+		other.count = 0;
+		other.reserved = N;
+	}
+
+	uint32_t count = 0;
+	uint32_t reserved = N;
+	union Storage {
+		T* heap;
+		T inline_items[N];
+	} storage;
+};
+
+template <typename T, size_t N>
+bool operator==(const SmallVector<T, N> &lhs, const SmallVector<T, N> &rhs) {
+	return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T, size_t N>
+bool operator!=(const SmallVector<T, N> &lhs, const SmallVector<T, N> &rhs) {
+	return !(lhs == rhs);
+}
+
+#endif
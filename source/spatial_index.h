@@ -0,0 +1,162 @@
+//////////////////////////////////////////////////////////////////////
+// This file is part of Remere's Map Editor
+//////////////////////////////////////////////////////////////////////
+// Remere's Map Editor is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Remere's Map Editor is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program. If not, see <http://www.gnu.org/licenses/>.
+//////////////////////////////////////////////////////////////////////
+
+#ifndef RME_SPATIAL_INDEX_H
+#define RME_SPATIAL_INDEX_H
+
+#include "position.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Sparse grid of values keyed by map position
+// Positions are bucketed into cells of 32x32 tiles on a single floor, only
+// cells holding a value are allocated. Point lookups touch a single cell,
+// area and radius queries only the cells overlapping the area, so the cost
+// depends on how many values are near the query instead of how many there
+// are on the map. Several values may share a position.
+template <typename T>
+class SpatialIndex {
+public:
+	static constexpr int CellShift = 5;
+
+	void insert(const Position &position, const T &value) {
+		cells[getCellKey(position.x, position.y, position.z)].push_back(Entry { position, value });
+		++count;
+	}
+
+	// Removes one entry matching both position and value
+	bool erase(const Position &position, const T &value) {
+		auto cell = cells.find(getCellKey(position.x, position.y, position.z));
+		if (cell == cells.end()) {
+			return false;
+		}
+
+		std::vector<Entry> &entries = cell->second;
+		auto it = std::find_if(entries.begin(), entries.end(), [&](const Entry &entry) {
+			return entry.position == position && entry.value == value;
+		});
+		if (it == entries.end()) {
+			return false;
+		}
+
+		*it = entries.back();
+		entries.pop_back();
+		if (entries.empty()) {
+			cells.erase(cell);
+		}
+		--count;
+		return true;
+	}
+
+	// Removes every entry at position, returns how many there were
+	size_t erase(const Position &position) {
+		auto cell = cells.find(getCellKey(position.x, position.y, position.z));
+		if (cell == cells.end()) {
+			return 0;
+		}
+
+		std::vector<Entry> &entries = cell->second;
+		const size_t removed = std::erase_if(entries, [&](const Entry &entry) {
+			return entry.position == position;
+		});
+		if (entries.empty()) {
+			cells.erase(cell);
+		}
+		count -= removed;
+		return removed;
+	}
+
+	void clear() {
+		cells.clear();
+		count = 0;
+	}
+
+	size_t size() const noexcept {
+		return count;
+	}
+	bool empty() const noexcept {
+		return count == 0;
+	}
+
+	// Returns a value stored at position, or the default value if there is none
+	T find(const Position &position) const {
+		auto cell = cells.find(getCellKey(position.x, position.y, position.z));
+		if (cell != cells.end()) {
+			for (const Entry &entry : cell->second) {
+				if (entry.position == position) {
+					return entry.value;
+				}
+			}
+		}
+		return T();
+	}
+
+	// Calls func(const Position&, const T&) for every value inside the area on floor z, bounds are inclusive
+	template <typename Func>
+	void forEachInArea(int start_x, int start_y, int end_x, int end_y, int z, Func &&func) const {
+		if (cells.empty()) {
+			return;
+		}
+
+		start_x = std::max(start_x, 0);
+		start_y = std::max(start_y, 0);
+		end_x = std::min(end_x, 0xFFFF);
+		end_y = std::min(end_y, 0xFFFF);
+		for (int cell_x = start_x >> CellShift; cell_x <= end_x >> CellShift; ++cell_x) {
+			for (int cell_y = start_y >> CellShift; cell_y <= end_y >> CellShift; ++cell_y) {
+				auto cell = cells.find(getCellKey(cell_x << CellShift, cell_y << CellShift, z));
+				if (cell == cells.end()) {
+					continue;
+				}
+
+				for (const Entry &entry : cell->second) {
+					const Position &position = entry.position;
+					if (position.x >= start_x && position.x <= end_x && position.y >= start_y && position.y <= end_y) {
+						func(position, entry.value);
+					}
+				}
+			}
+		}
+	}
+
+	// Same as forEachInArea, for the square of the given radius around center
+	template <typename Func>
+	void forEachInRadius(const Position &center, int radius, Func &&func) const {
+		forEachInArea(center.x - radius, center.y - radius, center.x + radius, center.y + radius, center.z, func);
+	}
+
+private:
+	struct Entry {
+		Position position;
+		T value;
+	};
+
+	// 11 bits for each cell coordinate and 4 for the floor
+	static uint32_t getCellKey(int x, int y, int z) noexcept {
+		const uint32_t cell_x = (static_cast<uint32_t>(x) & 0xFFFF) >> CellShift;
+		const uint32_t cell_y = (static_cast<uint32_t>(y) & 0xFFFF) >> CellShift;
+		return (static_cast<uint32_t>(z) & 0xF) << 22 | cell_x << 11 | cell_y;
+	}
+
+	std::unordered_map<uint32_t, std::vector<Entry>> cells;
+	size_t count = 0;
+};
+
+#endif
@@ -33,15 +33,20 @@ SpawnMonster* SpawnMonster::deepCopy() const {
 }
 
 void SpawnsMonster::addSpawnMonster(Tile* tile) {
-	ASSERT(tile->spawnMonster);
+	ASSERT(tile->getSpawnMonster());
 
 	auto it = spawnsMonster.insert(tile->getPosition());
 	ASSERT(it.second);
+
+	const int size = tile->getSpawnMonster()->getSize();
+	index.insert(tile->getPosition(), size);
+	max_size = std::max(max_size, size);
 }
 
 void SpawnsMonster::removeSpawnMonster(Tile* tile) {
-	ASSERT(tile->spawnMonster);
+	ASSERT(tile->getSpawnMonster());
 	spawnsMonster.erase(tile->getPosition());
+	index.erase(tile->getPosition());
 #if 0
 	SpawnMonsterPositionList::iterator iter = begin();
 	while(iter != end()) {
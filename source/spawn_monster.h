@@ -18,6 +18,8 @@
 #ifndef RME_SPAWN_MONSTER_H_
 #define RME_SPAWN_MONSTER_H_
 
+#include "spatial_index.h"
+
 class Tile;
 
 class SpawnMonster {
@@ -78,15 +80,29 @@ public:
 	SpawnMonsterPositionList::const_iterator end() const noexcept {
 		return spawnsMonster.end();
 	}
-	void erase(SpawnMonsterPositionList::iterator iter) noexcept {
+	void erase(SpawnMonsterPositionList::iterator iter) {
+		index.erase(*iter);
 		spawnsMonster.erase(iter);
 	}
 	SpawnMonsterPositionList::iterator find(Position &pos) {
 		return spawnsMonster.find(pos);
 	}
 
+	// Calls func(const Position&) for every spawn whose area covers position
+	template <typename Func>
+	void forEachSpawnMonsterAround(const Position &position, Func &&func) const {
+		index.forEachInRadius(position, max_size, [&](const Position &center, int size) {
+			if (std::abs(center.x - position.x) <= size && std::abs(center.y - position.y) <= size) {
+				func(center);
+			}
+		});
+	}
+
 private:
 	SpawnMonsterPositionList spawnsMonster;
+	// Spawn positions along with their size
+	SpatialIndex<int> index;
+	int max_size = 0;
 };
 
 #endif
@@ -45,7 +45,7 @@ std::string SpawnMonsterBrush::getName() const {
 bool SpawnMonsterBrush::canDraw(BaseMap* map, const Position &position) const {
 	Tile* tile = map->getTile(position);
 	if (tile) {
-		if (tile->spawnMonster) {
+		if (tile->getSpawnMonster()) {
 			return false;
 		}
 	}
@@ -53,8 +53,8 @@ bool SpawnMonsterBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void SpawnMonsterBrush::undraw(BaseMap* map, Tile* tile) {
-	delete tile->spawnMonster;
-	tile->spawnMonster = nullptr;
+	delete tile->getSpawnMonster();
+	tile->setSpawnMonster(nullptr);
 }
 
 void SpawnMonsterBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
@@ -64,8 +64,8 @@ void SpawnMonsterBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	auto side = size * 2 + 1;
 	int time = g_settings.getInteger(Config::DEFAULT_SPAWN_MONSTER_TIME);
 	int density = g_settings.getInteger(Config::SPAWN_MONSTER_DENSITY);
-	if (tile->spawnMonster == nullptr) {
-		tile->spawnMonster = newd SpawnMonster(size);
+	if (tile->getSpawnMonster() == nullptr) {
+		tile->setSpawnMonster(newd SpawnMonster(size));
 		auto toSpawn = (int)std::ceil((side * side) * (density / 100.0));
 		std::set<Position> positions;
 		for (int i = 0; i < side; i++) {
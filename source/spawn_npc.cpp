@@ -33,15 +33,20 @@ SpawnNpc* SpawnNpc::deepCopy() const {
 }
 
 void SpawnsNpc::addSpawnNpc(Tile* tile) {
-	ASSERT(tile->spawnNpc);
+	ASSERT(tile->getSpawnNpc());
 
 	auto it = spawnsNpc.insert(tile->getPosition());
 	ASSERT(it.second);
+
+	const int size = tile->getSpawnNpc()->getSize();
+	index.insert(tile->getPosition(), size);
+	max_size = std::max(max_size, size);
 }
 
 void SpawnsNpc::removeSpawnNpc(Tile* tile) {
-	ASSERT(tile->spawnNpc);
+	ASSERT(tile->getSpawnNpc());
 	spawnsNpc.erase(tile->getPosition());
+	index.erase(tile->getPosition());
 #if 0
 	SpawnNpcPositionList::iterator iter = begin();
 	while(iter != end()) {
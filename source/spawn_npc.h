@@ -18,6 +18,8 @@
 #ifndef RME_SPAWN_NPC_H_
 #define RME_SPAWN_NPC_H_
 
+#include "spatial_index.h"
+
 class Tile;
 
 class SpawnNpc {
@@ -78,15 +80,29 @@ public:
 	SpawnNpcPositionList::const_iterator end() const noexcept {
 		return spawnsNpc.end();
 	}
-	void erase(SpawnNpcPositionList::iterator iter) noexcept {
+	void erase(SpawnNpcPositionList::iterator iter) {
+		index.erase(*iter);
 		spawnsNpc.erase(iter);
 	}
 	SpawnNpcPositionList::iterator find(Position &pos) {
 		return spawnsNpc.find(pos);
 	}
 
+	// Calls func(const Position&) for every spawn whose area covers position
+	template <typename Func>
+	void forEachSpawnNpcAround(const Position &position, Func &&func) const {
+		index.forEachInRadius(position, max_size, [&](const Position &center, int size) {
+			if (std::abs(center.x - position.x) <= size && std::abs(center.y - position.y) <= size) {
+				func(center);
+			}
+		});
+	}
+
 private:
 	SpawnNpcPositionList spawnsNpc;
+	// Spawn positions along with their size
+	SpatialIndex<int> index;
+	int max_size = 0;
 };
 
 #endif
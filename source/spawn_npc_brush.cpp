@@ -44,7 +44,7 @@ std::string SpawnNpcBrush::getName() const {
 bool SpawnNpcBrush::canDraw(BaseMap* map, const Position &position) const {
 	Tile* tile = map->getTile(position);
 	if (tile) {
-		if (tile->spawnNpc) {
+		if (tile->getSpawnNpc()) {
 			return false;
 		}
 	}
@@ -52,14 +52,14 @@ bool SpawnNpcBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void SpawnNpcBrush::undraw(BaseMap* map, Tile* tile) {
-	delete tile->spawnNpc;
-	tile->spawnNpc = nullptr;
+	delete tile->getSpawnNpc();
+	tile->setSpawnNpc(nullptr);
 }
 
 void SpawnNpcBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	ASSERT(tile);
 	ASSERT(parameter); // Should contain an int which is the size of the newd spawn npc
-	if (tile->spawnNpc == nullptr) {
-		tile->spawnNpc = newd SpawnNpc(std::max(1, *(int*)parameter));
+	if (tile->getSpawnNpc() == nullptr) {
+		tile->setSpawnNpc(newd SpawnNpc(std::max(1, *(int*)parameter)));
 	}
 }
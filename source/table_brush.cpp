@@ -115,7 +115,7 @@ bool TableBrush::canDraw(BaseMap* map, const Position &position) const {
 }
 
 void TableBrush::undraw(BaseMap* map, Tile* t) {
-	ItemVector::iterator it = t->items.begin();
+	TileItemVector::iterator it = t->items.begin();
 	while (it != t->items.end()) {
 		if ((*it)->isTable()) {
 			TableBrush* tb = (*it)->getTableBrush();
@@ -160,7 +160,7 @@ bool hasMatchingTableBrushAtTile(BaseMap* map, TableBrush* table_brush, uint32_t
 		return false;
 	}
 
-	ItemVector::const_iterator it = t->items.begin();
+	TileItemVector::const_iterator it = t->items.begin();
 	for (; it != t->items.end(); ++it) {
 		TableBrush* tb = (*it)->getTableBrush();
 		if (tb == table_brush) {
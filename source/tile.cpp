@@ -30,15 +30,41 @@
 #include "table_brush.h"
 #include "npc.h"
 #include "spawn_npc.h"
+#include "content_hash.h"
+
+#include <mutex>
+
+namespace {
+	// Never destroyed, tiles may still be freed while static objects are torn down
+	SlabPool<Tile, 4096>* tile_pool = newd SlabPool<Tile, 4096>;
+	std::mutex tile_pool_mutex;
+}
+
+void* Tile::operator new(size_t size) {
+	if (size != sizeof(Tile)) {
+		return ::operator new(size);
+	}
+	std::lock_guard<std::mutex> lock(tile_pool_mutex);
+	return tile_pool->allocate();
+}
+
+void Tile::operator delete(void* ptr, size_t size) {
+	if (size != sizeof(Tile)) {
+		::operator delete(ptr);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(tile_pool_mutex);
+	tile_pool->deallocate(ptr);
+}
+
+SlabPoolStats Tile::getPoolStats() {
+	std::lock_guard<std::mutex> lock(tile_pool_mutex);
+	return tile_pool->getStats();
+}
 
 Tile::Tile(int x, int y, int z) :
 	location(nullptr),
-	ground(nullptr),
-	monster(nullptr),
-	spawnMonster(nullptr),
-	npc(nullptr),
-	spawnNpc(nullptr),
-	house_id(0),
+	extras(nullptr),
 	mapflags(0),
 	statflags(0),
 	minimapColor(INVALID_MINIMAP_COLOR) {
@@ -47,12 +73,7 @@ Tile::Tile(int x, int y, int z) :
 
 Tile::Tile(TileLocation &loc) :
 	location(&loc),
-	ground(nullptr),
-	monster(nullptr),
-	spawnMonster(nullptr),
-	npc(nullptr),
-	spawnNpc(nullptr),
-	house_id(0),
+	extras(nullptr),
 	mapflags(0),
 	statflags(0),
 	minimapColor(INVALID_MINIMAP_COLOR) {
@@ -61,58 +82,188 @@ Tile::Tile(TileLocation &loc) :
 
 Tile::~Tile() {
 	while (!items.empty()) {
-		delete items.back();
+		PackedItem::destroy(items.getSlot(items.size() - 1));
 		items.pop_back();
 	}
-	delete monster;
-	// printf("%d,%d,%d,%p\n", tilePos.x, tilePos.y, tilePos.z, ground);
-	delete ground;
-	delete spawnMonster;
-	delete npc;
-	delete spawnNpc;
+	PackedItem::destroy(ground.release());
+	if (extras) {
+		delete extras->monster;
+		delete extras->spawnMonster;
+		delete extras->npc;
+		delete extras->spawnNpc;
+		delete extras;
+	}
 }
 
-Tile* Tile::deepCopy(BaseMap &map) const {
-	Tile* copy = map.allocator.allocateTile(location);
-	copy->flags = flags;
-	copy->house_id = house_id;
-	if (spawnMonster) {
-		copy->spawnMonster = spawnMonster->deepCopy();
+TileExtras* Tile::getExtras() {
+	if (!extras) {
+		extras = newd TileExtras;
+	}
+	return extras;
+}
+
+void Tile::compactExtras() {
+	if (extras && extras->empty()) {
+		delete extras;
+		extras = nullptr;
+	}
+}
+
+void Tile::setMonster(Monster* newMonster) {
+	if (newMonster || extras) {
+		getExtras()->monster = newMonster;
+		compactExtras();
+	}
+}
+
+void Tile::setSpawnMonster(SpawnMonster* newSpawnMonster) {
+	if (newSpawnMonster || extras) {
+		getExtras()->spawnMonster = newSpawnMonster;
+		compactExtras();
+	}
+}
+
+void Tile::setNpc(Npc* newNpc) {
+	if (newNpc || extras) {
+		getExtras()->npc = newNpc;
+		compactExtras();
+	}
+}
+
+void Tile::setSpawnNpc(SpawnNpc* newSpawnNpc) {
+	if (newSpawnNpc || extras) {
+		getExtras()->spawnNpc = newSpawnNpc;
+		compactExtras();
+	}
+}
+
+const TileZoneList &Tile::getZones() const noexcept {
+	static const TileZoneList no_zones;
+	return extras ? extras->zones : no_zones;
+}
+
+void Tile::addZone(unsigned int zone) {
+	if (zone == 0) {
+		return;
 	}
-	if (spawnNpc) {
-		copy->spawnNpc = spawnNpc->deepCopy();
+
+	TileZoneList &zones = getExtras()->zones;
+	const uint16_t id = static_cast<uint16_t>(zone);
+	auto it = std::lower_bound(zones.begin(), zones.end(), id);
+	if (it == zones.end() || *it != id) {
+		zones.insert(it, id);
 	}
-	if (monster) {
-		copy->monster = monster->deepCopy();
+}
+
+void Tile::removeZone(unsigned int zone) {
+	if (!extras) {
+		return;
 	}
-	if (npc) {
-		copy->npc = npc->deepCopy();
+
+	TileZoneList &zones = extras->zones;
+	const uint16_t id = static_cast<uint16_t>(zone);
+	auto it = std::lower_bound(zones.begin(), zones.end(), id);
+	if (it != zones.end() && *it == id) {
+		zones.erase(it);
+		compactExtras();
+	}
+}
+
+Tile* Tile::deepCopy(BaseMap &map) const {
+	Tile* copy = map.allocator.allocateTile(location);
+	copy->flags = flags;
+	if (extras) {
+		TileExtras* copyExtras = copy->getExtras();
+		copyExtras->house_id = extras->house_id;
+		if (extras->spawnMonster) {
+			copyExtras->spawnMonster = extras->spawnMonster->deepCopy();
+		}
+		if (extras->spawnNpc) {
+			copyExtras->spawnNpc = extras->spawnNpc->deepCopy();
+		}
+		if (extras->monster) {
+			copyExtras->monster = extras->monster->deepCopy();
+		}
+		if (extras->npc) {
+			copyExtras->npc = extras->npc->deepCopy();
+		}
+		copyExtras->zones = extras->zones;
 	}
 	// Spawncount & exits are not transferred on copy!
+	copy->ground = PackedItem::copy(ground.getSlot());
+	items.copyTo(copy->items);
+	return copy;
+}
+
+void Tile::packItems() noexcept {
+	ground = PackedItem::pack(ground.release());
+	items.pack();
+}
+
+uint64_t Tile::getContentHash() const {
+	ContentHasher hasher;
+	hasher.add(mapflags);
+	hasher.add(getHouseID());
+
+	const TileZoneList &zones = getZones();
+	hasher.add(zones.size());
+	for (uint16_t zone : zones) {
+		hasher.add(zone);
+	}
+
+	PackedItem scratch;
 	if (ground) {
-		copy->ground = ground->deepCopy();
+		scratch.peek(ground.getSlot())->hashContent(hasher);
+	} else {
+		hasher.add(0);
+	}
+	hasher.add(items.size());
+	for (const Item* item : items.peek()) {
+		item->hashContent(hasher);
 	}
 
-	for (const Item* item : items) {
-		copy->items.push_back(item->deepCopy());
+	if (const Monster* monster = getMonster()) {
+		hasher.add(monster->getName());
+		hasher.add(monster->getSpawnMonsterTime());
+		hasher.add(monster->getDirection());
+	} else {
+		hasher.add(0);
 	}
-	for (unsigned int zone : zones) {
-		copy->zones.insert(zone);
+	if (const Npc* npc = getNpc()) {
+		hasher.add(npc->getName());
+		hasher.add(npc->getSpawnNpcTime());
+		hasher.add(npc->getDirection());
+	} else {
+		hasher.add(0);
 	}
-	return copy;
+
+	const SpawnMonster* spawnMonster = getSpawnMonster();
+	hasher.add(spawnMonster ? spawnMonster->getSize() + 1 : 0);
+	const SpawnNpc* spawnNpc = getSpawnNpc();
+	hasher.add(spawnNpc ? spawnNpc->getSize() + 1 : 0);
+	return hasher.get();
 }
 
 uint32_t Tile::memsize() const {
 	uint32_t mem = sizeof(*this);
-	if (ground) {
-		mem += ground->memsize();
+	if (extras) {
+		mem += sizeof(TileExtras);
 	}
-
-	for (const Item* item : items) {
+	// Packed items live in their slot
+	if (const Item* item = PackedItem::getSlotItem(ground.getSlot())) {
 		mem += item->memsize();
 	}
 
-	mem += sizeof(Item*) * items.capacity();
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (const Item* item = PackedItem::getSlotItem(items.getSlot(i))) {
+			mem += item->memsize();
+		}
+	}
+
+	// Inline items are already part of sizeof(Tile)
+	if (!items.isInline()) {
+		mem += sizeof(Item*) * items.capacity();
+	}
 
 	return mem;
 }
@@ -123,17 +274,19 @@ int Tile::size() const {
 		++sz;
 	}
 	sz += items.size();
-	if (monster) {
-		++sz;
-	}
-	if (spawnMonster) {
-		++sz;
-	}
-	if (npc) {
-		++sz;
-	}
-	if (spawnNpc) {
-		++sz;
+	if (extras) {
+		if (extras->monster) {
+			++sz;
+		}
+		if (extras->spawnMonster) {
+			++sz;
+		}
+		if (extras->npc) {
+			++sz;
+		}
+		if (extras->spawnNpc) {
+			++sz;
+		}
 	}
 	if (location) {
 		if (location->getHouseExits()) {
@@ -161,50 +314,37 @@ void Tile::merge(Tile* other) {
 	if (other->isPZ()) {
 		setPZ(true);
 	}
-	if (other->house_id) {
-		house_id = other->house_id;
+	if (other->getHouseID()) {
+		setHouseID(other->getHouseID());
 	}
 
 	if (other->ground) {
-		delete ground;
-		ground = other->ground;
-		other->ground = nullptr;
-	}
-
-	if (other->monster) {
-		delete monster;
-		monster = other->monster;
-		other->monster = nullptr;
-	}
-
-	if (other->spawnMonster) {
-		delete spawnMonster;
-		spawnMonster = other->spawnMonster;
-		other->spawnMonster = nullptr;
+		PackedItem::destroy(ground.release());
+		ground = other->ground.release();
 	}
 
-	if (other->npc) {
-		delete npc;
-		npc = other->npc;
-		other->npc = nullptr;
+	if (Monster* otherMonster = other->getMonster()) {
+		delete getMonster();
+		setMonster(otherMonster);
+		other->setMonster(nullptr);
 	}
 
-	if (other->spawnNpc) {
-		delete spawnNpc;
-		spawnNpc = other->spawnNpc;
-		other->spawnNpc = nullptr;
+	if (SpawnMonster* otherSpawnMonster = other->getSpawnMonster()) {
+		delete getSpawnMonster();
+		setSpawnMonster(otherSpawnMonster);
+		other->setSpawnMonster(nullptr);
 	}
 
-	if (other->monster) {
-		delete monster;
-		monster = other->monster;
-		other->monster = nullptr;
+	if (Npc* otherNpc = other->getNpc()) {
+		delete getNpc();
+		setNpc(otherNpc);
+		other->setNpc(nullptr);
 	}
 
-	if (other->npc) {
-		delete npc;
-		npc = other->npc;
-		other->npc = nullptr;
+	if (SpawnNpc* otherSpawnNpc = other->getSpawnNpc()) {
+		delete getSpawnNpc();
+		setSpawnNpc(otherSpawnNpc);
+		other->setSpawnNpc(nullptr);
 	}
 
 	for (Item* item : other->items) {
@@ -218,11 +358,12 @@ bool Tile::hasProperty(enum ITEMPROPERTY prop) const {
 		return true;
 	}
 
-	if (ground && ground->hasProperty(prop)) {
+	PackedItem scratch;
+	if (ground && scratch.peek(ground.getSlot())->hasProperty(prop)) {
 		return true;
 	}
 
-	for (const Item* item : items) {
+	for (const Item* item : items.peek()) {
 		if (item->hasProperty(prop)) {
 			return true;
 		}
@@ -232,8 +373,12 @@ bool Tile::hasProperty(enum ITEMPROPERTY prop) const {
 }
 
 uint16_t Tile::getGroundSpeed() const noexcept {
-	if (ground && !ground->isMetaItem()) {
-		return ground->getGroundSpeed();
+	if (ground) {
+		PackedItem scratch;
+		const Item* item = scratch.peek(ground.getSlot());
+		if (!item->isMetaItem()) {
+			return item->getGroundSpeed();
+		}
 	}
 	return 0;
 }
@@ -243,29 +388,28 @@ int Tile::getIndexOf(Item* item) const {
 		return wxNOT_FOUND;
 	}
 
+	// A packed slot never equals a real item, a shared one may
 	int index = 0;
 	if (ground) {
-		if (ground == item) {
+		if (PackedItem::getSlotItem(ground.getSlot()) == item) {
 			return index;
 		}
 		index++;
 	}
 
-	if (!items.empty()) {
-		auto it = std::find(items.begin(), items.end(), item);
-		if (it != items.end()) {
-			index += (it - items.begin());
-			return index;
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (PackedItem::getSlotItem(items.getSlot(i)) == item) {
+			return index + i;
 		}
 	}
 	return wxNOT_FOUND;
 }
 
 Item* Tile::getTopItem() const {
-	if (!items.empty() && !items.back()->isMetaItem()) {
+	if (!items.empty() && !PackedItem::getSlotType(items.getSlot(items.size() - 1)).isMetaItem()) {
 		return items.back();
 	}
-	if (ground && !ground->isMetaItem()) {
+	if (ground && !PackedItem::getSlotType(ground.getSlot()).isMetaItem()) {
 		return ground;
 	}
 	return nullptr;
@@ -292,41 +436,43 @@ void Tile::addItem(Item* item) {
 		return;
 	}
 	if (item->isGroundTile()) {
-		// printf("ADDING GROUND\n");
-		delete ground;
+		PackedItem::destroy(ground.release());
 		ground = item;
 		return;
 	}
 
-	ItemVector::iterator it;
+	// Only the item types are looked at, nothing gets unpacked
+	size_t index;
 
 	uint16_t gid = item->getGroundEquivalent();
 	if (gid != 0) {
-		delete ground;
+		PackedItem::destroy(ground.release());
 		ground = Item::Create(gid);
 		// At the very bottom!
-		it = items.begin();
+		index = 0;
 	} else {
 		if (item->isAlwaysOnBottom()) {
-			it = items.begin();
+			index = 0;
 			while (true) {
-				if (it == items.end()) {
+				if (index == items.size()) {
 					break;
-				} else if ((*it)->isAlwaysOnBottom()) {
-					if (item->getTopOrder() < (*it)->getTopOrder()) {
+				}
+				const ItemType &type = PackedItem::getSlotType(items.getSlot(index));
+				if (type.alwaysOnBottom) {
+					if (item->getTopOrder() < type.alwaysOnTopOrder) {
 						break;
 					}
 				} else { // Always on top
 					break;
 				}
-				++it;
+				++index;
 			}
 		} else {
-			it = items.end();
+			index = items.size();
 		}
 	}
 
-	items.insert(it, item);
+	items.insert(items.begin() + index, item);
 
 	if (item->isSelected()) {
 		statflags |= TILESTATE_SELECTED;
@@ -338,23 +484,25 @@ void Tile::select() {
 		return;
 	}
 	if (ground) {
-		ground->select();
+		PackedItem::setSelected(ground.getSlot(), true);
 	}
-	if (spawnMonster) {
-		spawnMonster->select();
-	}
-	if (spawnNpc) {
-		spawnNpc->select();
-	}
-	if (monster) {
-		monster->select();
-	}
-	if (npc) {
-		npc->select();
+	if (extras) {
+		if (extras->spawnMonster) {
+			extras->spawnMonster->select();
+		}
+		if (extras->spawnNpc) {
+			extras->spawnNpc->select();
+		}
+		if (extras->monster) {
+			extras->monster->select();
+		}
+		if (extras->npc) {
+			extras->npc->select();
+		}
 	}
 
-	for (Item* item : items) {
-		item->select();
+	for (size_t i = 0; i < items.size(); ++i) {
+		PackedItem::setSelected(items.getSlot(i), true);
 	}
 
 	statflags |= TILESTATE_SELECTED;
@@ -362,36 +510,43 @@ void Tile::select() {
 
 void Tile::deselect() {
 	if (ground) {
-		ground->deselect();
-	}
-	if (spawnMonster) {
-		spawnMonster->deselect();
-	}
-	if (spawnNpc) {
-		spawnNpc->deselect();
+		PackedItem::setSelected(ground.getSlot(), false);
 	}
-	if (monster) {
-		monster->deselect();
-	}
-	if (npc) {
-		npc->deselect();
+	if (extras) {
+		if (extras->spawnMonster) {
+			extras->spawnMonster->deselect();
+		}
+		if (extras->spawnNpc) {
+			extras->spawnNpc->deselect();
+		}
+		if (extras->monster) {
+			extras->monster->deselect();
+		}
+		if (extras->npc) {
+			extras->npc->deselect();
+		}
 	}
 
-	for (Item* item : items) {
-		item->deselect();
+	for (size_t i = 0; i < items.size(); ++i) {
+		PackedItem::setSelected(items.getSlot(i), false);
 	}
 
 	statflags &= ~TILESTATE_SELECTED;
 }
 
 Item* Tile::getTopSelectedItem() {
-	for (auto it = items.rbegin(); it != items.rend(); ++it) {
-		if ((*it)->isSelected() && !(*it)->isMetaItem()) {
-			return *it;
+	PackedItem scratch;
+	for (size_t i = items.size(); i-- > 0;) {
+		const Item* item = scratch.peek(items.getSlot(i));
+		if (item->isSelected() && !item->isMetaItem()) {
+			return items[i];
 		}
 	}
-	if (ground && ground->isSelected() && !ground->isMetaItem()) {
-		return ground;
+	if (ground) {
+		const Item* item = scratch.peek(ground.getSlot());
+		if (item->isSelected() && !item->isMetaItem()) {
+			return ground;
+		}
 	}
 	return nullptr;
 }
@@ -403,18 +558,18 @@ ItemVector Tile::popSelectedItems(bool ignoreTileSelected) {
 		return pop_items;
 	}
 
-	if (ground && ground->isSelected()) {
+	PackedItem scratch;
+	if (ground && scratch.peek(ground.getSlot())->isSelected()) {
 		pop_items.push_back(ground);
 		ground = nullptr;
 	}
 
-	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
-		if (item->isSelected()) {
-			pop_items.push_back(item);
-			it = items.erase(it);
+	for (size_t i = 0; i < items.size();) {
+		if (scratch.peek(items.getSlot(i))->isSelected()) {
+			pop_items.push_back(items[i]);
+			items.erase(items.begin() + i);
 		} else {
-			++it;
+			++i;
 		}
 	}
 
@@ -429,13 +584,14 @@ ItemVector Tile::getSelectedItems() {
 		return selected_items;
 	}
 
-	if (ground && ground->isSelected()) {
+	PackedItem scratch;
+	if (ground && scratch.peek(ground.getSlot())->isSelected()) {
 		selected_items.push_back(ground);
 	}
 
-	for (Item* item : items) {
-		if (item->isSelected()) {
-			selected_items.push_back(item);
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (scratch.peek(items.getSlot(i))->isSelected()) {
+			selected_items.push_back(items[i]);
 		}
 	}
 
@@ -447,8 +603,9 @@ uint8_t Tile::getMiniMapColor() const {
 		return minimapColor;
 	}
 
-	for (auto it = items.rbegin(); it != items.rend(); ++it) {
-		uint8_t color = (*it)->getMiniMapColor();
+	PackedItem scratch;
+	for (size_t i = items.size(); i-- > 0;) {
+		uint8_t color = scratch.peek(items.getSlot(i))->getMiniMapColor();
 		if (color != 0) {
 			return color;
 		}
@@ -456,7 +613,7 @@ uint8_t Tile::getMiniMapColor() const {
 
 	// check ground too
 	if (hasGround()) {
-		return ground->getMiniMapColor();
+		return scratch.peek(ground.getSlot())->getMiniMapColor();
 	}
 
 	return 0;
@@ -465,35 +622,39 @@ uint8_t Tile::getMiniMapColor() const {
 void Tile::update() {
 	statflags &= TILESTATE_MODIFIED;
 
-	if (spawnMonster && spawnMonster->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
-	}
-	if (spawnNpc && spawnNpc->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
-	}
-	if (monster && monster->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
-	}
-	if (npc && npc->isSelected()) {
-		statflags |= TILESTATE_SELECTED;
+	if (extras) {
+		if (extras->spawnMonster && extras->spawnMonster->isSelected()) {
+			statflags |= TILESTATE_SELECTED;
+		}
+		if (extras->spawnNpc && extras->spawnNpc->isSelected()) {
+			statflags |= TILESTATE_SELECTED;
+		}
+		if (extras->monster && extras->monster->isSelected()) {
+			statflags |= TILESTATE_SELECTED;
+		}
+		if (extras->npc && extras->npc->isSelected()) {
+			statflags |= TILESTATE_SELECTED;
+		}
 	}
 
 	if (ground) {
-		if (ground->isSelected()) {
+		PackedItem scratch;
+		const Item* item = scratch.peek(ground.getSlot());
+		if (item->isSelected()) {
 			statflags |= TILESTATE_SELECTED;
 		}
-		if (ground->isBlocking()) {
+		if (item->isBlocking()) {
 			statflags |= TILESTATE_BLOCKING;
 		}
-		if (ground->getUniqueID() != 0) {
+		if (item->getUniqueID() != 0) {
 			statflags |= TILESTATE_UNIQUE;
 		}
-		if (ground->getMiniMapColor() != 0) {
-			minimapColor = ground->getMiniMapColor();
+		if (item->getMiniMapColor() != 0) {
+			minimapColor = item->getMiniMapColor();
 		}
 	}
 
-	for (const Item* item : items) {
+	for (const Item* item : items.peek()) {
 		if (item->isSelected()) {
 			statflags |= TILESTATE_SELECTED;
 		}
@@ -540,8 +701,9 @@ void Tile::addBorderItem(Item* item) {
 }
 
 GroundBrush* Tile::getGroundBrush() const {
-	if (ground && ground->getGroundBrush()) {
-		return ground->getGroundBrush();
+	if (ground) {
+		PackedItem scratch;
+		return scratch.peek(ground.getSlot())->getGroundBrush();
 	}
 	return nullptr;
 }
@@ -552,14 +714,12 @@ void Tile::cleanBorders() {
 	}
 
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
 		// Borders should only be on the bottom, we can ignore the rest of the items
-		if (!item->isBorder()) {
+		if (!PackedItem::getSlotType(items.getSlot(it - items.begin())).isBorder) {
 			break;
 		}
 
-		delete item;
-		it = items.erase(it);
+		it = items.destroy(it);
 	}
 }
 
@@ -568,27 +728,27 @@ void Tile::wallize(BaseMap* parent) {
 }
 
 Item* Tile::getWall() const {
-	for (Item* item : items) {
-		if (item->isWall()) {
-			return item;
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (PackedItem::getSlotType(items.getSlot(i)).isWall) {
+			return items[i];
 		}
 	}
 	return nullptr;
 }
 
 Item* Tile::getCarpet() const {
-	for (Item* item : items) {
-		if (item->isCarpet()) {
-			return item;
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (PackedItem::getSlotType(items.getSlot(i)).isCarpet) {
+			return items[i];
 		}
 	}
 	return nullptr;
 }
 
 Item* Tile::getTable() const {
-	for (Item* item : items) {
-		if (item->isTable()) {
-			return item;
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (PackedItem::getSlotType(items.getSlot(i)).isTable) {
+			return items[i];
 		}
 	}
 	return nullptr;
@@ -608,13 +768,12 @@ void Tile::cleanWalls(bool dontdelete) {
 		return;
 	}
 
+	// dontdelete only leaves items of the tile's own to the caller, nobody else
+	// points at a packed item and a shared one still has to be released
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
-		if (item && item->isWall()) {
-			if (!dontdelete) {
-				delete item;
-			}
-			it = items.erase(it);
+		const Item* slot = items.getSlot(it - items.begin());
+		if (slot && PackedItem::getSlotType(slot).isWall) {
+			it = dontdelete && !PackedItem::isPacked(slot) && !PackedItem::isShared(slot) ? items.erase(it) : items.destroy(it);
 		} else {
 			++it;
 		}
@@ -622,13 +781,11 @@ void Tile::cleanWalls(bool dontdelete) {
 }
 
 void Tile::cleanWalls(WallBrush* brush) {
-	ItemVector::iterator it;
-
+	PackedItem scratch;
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
+		const Item* item = scratch.peek(items.getSlot(it - items.begin()));
 		if (item && item->isWall() && brush->hasWall(item)) {
-			delete item;
-			it = items.erase(it);
+			it = items.destroy(it);
 		} else {
 			++it;
 		}
@@ -640,13 +797,11 @@ void Tile::cleanTables(bool dontdelete) {
 		return;
 	}
 
+	// Same as cleanWalls
 	for (auto it = items.begin(); it != items.end();) {
-		Item* item = (*it);
-		if (item && item->isTable()) {
-			if (!dontdelete) {
-				delete item;
-			}
-			it = items.erase(it);
+		const Item* slot = items.getSlot(it - items.begin());
+		if (slot && PackedItem::getSlotType(slot).isTable) {
+			it = dontdelete && !PackedItem::isPacked(slot) && !PackedItem::isShared(slot) ? items.erase(it) : items.destroy(it);
 		} else {
 			++it;
 		}
@@ -664,16 +819,15 @@ void Tile::carpetize(BaseMap* parent) {
 void Tile::selectGround() {
 	bool selected = false;
 	if (ground) {
-		ground->select();
+		PackedItem::setSelected(ground.getSlot(), true);
 		selected = true;
 	}
-	ItemVector::iterator it;
 
-	for (Item* item : items) {
-		if (!item->isBorder()) {
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (!PackedItem::getSlotType(items.getSlot(i)).isBorder) {
 			break;
 		}
-		item->select();
+		PackedItem::setSelected(items.getSlot(i), true);
 		selected = true;
 	}
 
@@ -684,19 +838,26 @@ void Tile::selectGround() {
 
 void Tile::deselectGround() {
 	if (ground) {
-		ground->deselect();
+		PackedItem::setSelected(ground.getSlot(), false);
 	}
-	for (Item* item : items) {
-		if (!item->isBorder()) {
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (!PackedItem::getSlotType(items.getSlot(i)).isBorder) {
 			break;
 		}
 
-		item->deselect();
+		PackedItem::setSelected(items.getSlot(i), false);
 	}
 }
 
 void Tile::setHouse(House* house) {
-	house_id = (house ? house->id : 0);
+	setHouseID(house ? house->id : 0);
+}
+
+void Tile::setHouseID(uint32_t houseId) {
+	if (houseId != 0 || extras) {
+		getExtras()->house_id = houseId;
+		compactExtras();
+	}
 }
 
 void Tile::addHouseExit(House* house) {
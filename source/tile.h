@@ -20,9 +20,11 @@
 
 #include "position.h"
 #include "item.h"
+#include "packed_item.h"
 #include "map_region.h"
 #include "spawn_npc.h"
 #include "npc.h"
+#include "slab_pool.h"
 #include <unordered_set>
 
 enum {
@@ -47,17 +49,31 @@ enum : uint8_t {
 	INVALID_MINIMAP_COLOR = 0xFF
 };
 
+// Zone ids of a tile, kept sorted
+// Zone ids are 16 bit on disk, a handful fit inside the vector itself.
+typedef SmallVector<uint16_t, 4> TileZoneList;
+
+// Data that only a small share of the tiles carry
+// Kept out of Tile so plain ground and item tiles stay small, it is created
+// the first time one of the fields is set and dropped once it is empty again.
+struct TileExtras {
+	Monster* monster = nullptr;
+	SpawnMonster* spawnMonster = nullptr;
+	Npc* npc = nullptr;
+	SpawnNpc* spawnNpc = nullptr;
+	uint32_t house_id = 0; // House id for this tile (pointer not safe)
+	TileZoneList zones;
+
+	bool empty() const noexcept {
+		return !monster && !spawnMonster && !npc && !spawnNpc && house_id == 0 && zones.empty();
+	}
+};
+
 class Tile {
 public: // Members
 	TileLocation* location;
-	Item* ground;
-	ItemVector items;
-	Monster* monster;
-	SpawnMonster* spawnMonster;
-	Npc* npc;
-	SpawnNpc* spawnNpc;
-	uint32_t house_id; // House id for this tile (pointer not safe)
-	std::set<unsigned int> zones;
+	TileItemSlot ground;
+	TileItemVector items;
 
 public:
 	// ALWAYS use this constructor if the Tile is EVER going to be placed on a map
@@ -67,8 +83,21 @@ public:
 
 	~Tile();
 
+	// Tiles are pooled, see MapAllocator
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr, size_t size);
+#ifdef DEBUG_MEM
+	// newd passes the allocation site along, the pool does not track it
+	static void* operator new(size_t size, const char*, int) {
+		return operator new(size);
+	}
+#endif
+	static SlabPoolStats getPoolStats();
+
 	// Argument is a the map to allocate the tile from
 	Tile* deepCopy(BaseMap &map) const;
+	// Packs the plain items of a tile nobody points into yet, see PackedItem
+	void packItems() noexcept;
 
 	// The location of the tile
 	// Stores state that remains between the tile being moved (like house exits)
@@ -83,7 +112,7 @@ public:
 	}
 
 	// Position of the tile
-	const Position &getPosition() const noexcept {
+	Position getPosition() const noexcept {
 		return location->getPosition();
 	}
 	int getX() const noexcept {
@@ -98,6 +127,24 @@ public:
 
 	uint16_t getGroundSpeed() const noexcept;
 
+	// Creatures and spawns, setting one does not delete the previous one
+	Monster* getMonster() const noexcept {
+		return extras ? extras->monster : nullptr;
+	}
+	void setMonster(Monster* newMonster);
+	SpawnMonster* getSpawnMonster() const noexcept {
+		return extras ? extras->spawnMonster : nullptr;
+	}
+	void setSpawnMonster(SpawnMonster* newSpawnMonster);
+	Npc* getNpc() const noexcept {
+		return extras ? extras->npc : nullptr;
+	}
+	void setNpc(Npc* newNpc);
+	SpawnNpc* getSpawnNpc() const noexcept {
+		return extras ? extras->spawnNpc : nullptr;
+	}
+	void setSpawnNpc(SpawnNpc* newSpawnNpc);
+
 public: // Functions
 	// Absorb the other tile into this tile
 	void merge(Tile* other);
@@ -115,6 +162,8 @@ public: // Functions
 
 	// Get memory footprint size
 	uint32_t memsize() const;
+	// Hash of everything that gets saved, editor state (selection etc.) is left out
+	uint64_t getContentHash() const;
 	// Get number of items on the tile
 	bool empty() const {
 		return size() == 0;
@@ -186,7 +235,7 @@ public: // Functions
 		return ground != nullptr;
 	}
 	bool hasBorders() const {
-		return !items.empty() && items.front()->isBorder();
+		return !items.empty() && PackedItem::getSlotType(items.getSlot(0)).isBorder;
 	}
 
 	// Get the border brush of this tile
@@ -250,6 +299,7 @@ public: // Functions
 	HouseExitList* getHouseExits();
 	bool hasHouseExit(uint32_t houseId) const;
 	void setHouse(House* house);
+	void setHouseID(uint32_t houseId);
 
 	// Mapflags (PZ, PVPZONE etc.)
 	void setMapFlags(uint16_t flags);
@@ -261,20 +311,15 @@ public: // Functions
 	void unsetStatFlags(uint16_t flags);
 	uint16_t getStatFlags() const noexcept;
 
+	const TileZoneList &getZones() const noexcept;
 	bool hasZone(unsigned int zone) const {
-		return zones.find(zone) != zones.end();
-	}
-
-	void addZone(unsigned int zone) {
-		if (zone == 0) {
-			return;
-		}
-		zones.insert(zone);
+		return extras && std::binary_search(extras->zones.begin(), extras->zones.end(), static_cast<uint16_t>(zone));
 	}
+	void addZone(unsigned int zone);
+	void removeZone(unsigned int zone);
 
-	void removeZone(unsigned int zone) {
-		zones.erase(zone);
-	}
+private:
+	TileExtras* extras;
 
 protected:
 	union {
@@ -286,6 +331,10 @@ protected:
 	};
 
 private:
+	TileExtras* getExtras();
+	// Frees the extras once nothing is left in them
+	void compactExtras();
+
 	uint8_t minimapColor;
 
 	Tile(const Tile &tile); // No copy
@@ -302,11 +351,11 @@ inline bool Tile::hasWall() const {
 }
 
 inline bool Tile::isHouseTile() const noexcept {
-	return house_id != 0;
+	return getHouseID() != 0;
 }
 
 inline uint32_t Tile::getHouseID() const noexcept {
-	return house_id;
+	return extras ? extras->house_id : 0;
 }
 
 inline HouseExitList* Tile::getHouseExits() {
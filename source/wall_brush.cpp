@@ -260,7 +260,7 @@ void WallBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	bool b = (parameter ? *reinterpret_cast<bool*>(parameter) : false);
 	if (b) {
 		// Find a matching wall item on this tile, and shift the id
-		for (ItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
+		for (TileItemVector::iterator item_iter = tile->items.begin(); item_iter != tile->items.end(); ++item_iter) {
 			Item* item = *item_iter;
 			if (item->isWall()) {
 				WallBrush* wb = item->getWallBrush();
@@ -357,7 +357,7 @@ bool hasMatchingWallBrushAtTile(BaseMap* map, WallBrush* wall_brush, uint32_t x,
 		return false;
 	}
 
-	ItemVector::const_iterator it = t->items.begin();
+	TileItemVector::const_iterator it = t->items.begin();
 	for (; it != t->items.end(); ++it) {
 		Item* item = *it;
 		if (item->isWall()) {
@@ -382,7 +382,7 @@ void WallBrush::doWalls(BaseMap* map, Tile* tile) {
 	unsigned int z = tile->getPosition().z;
 
 	// Advance the vector to the beginning of the walls
-	ItemVector::iterator it = tile->items.begin();
+	TileItemVector::iterator it = tile->items.begin();
 	for (; it != tile->items.end() && (*it)->isBorder(); ++it)
 		;
 
@@ -616,7 +616,7 @@ void WallBrush::doWalls(BaseMap* map, Tile* tile) {
 	}
 }
 
-bool WallBrush::hasWall(Item* item) {
+bool WallBrush::hasWall(const Item* item) {
 	ASSERT(item->isWall());
 	::BorderType bt = item->getWallAlignment();
 
@@ -667,7 +667,7 @@ WallDecorationBrush::~WallDecorationBrush() {
 void WallDecorationBrush::draw(BaseMap* map, Tile* tile, void* parameter) {
 	ASSERT(tile);
 
-	ItemVector::iterator iter = tile->items.begin();
+	TileItemVector::iterator iter = tile->items.begin();
 
 	tile->cleanWalls(this);
 	while (iter != tile->items.end()) {
@@ -25,6 +25,7 @@ Waypoints::~Waypoints() {
 		delete it->second;
 	}
 	waypoints.clear();
+	positions.clear();
 }
 
 void Waypoints::addWaypoint(Waypoint* wp) {
@@ -35,6 +36,7 @@ void Waypoints::addWaypoint(Waypoint* wp) {
 			map.setTile(wp->pos, t = map.allocator(map.createTileL(wp->pos)));
 		}
 		t->getLocation()->increaseWaypointCount();
+		positions.insert(wp->pos, wp);
 	}
 	waypoints.insert(std::make_pair(as_lower_str(wp->name), wp));
 }
@@ -52,14 +54,7 @@ Waypoint* Waypoints::getWaypoint(const Position &position) {
 	if (!position.isValid()) {
 		return nullptr;
 	}
-	// TODO find waypoint by position hash.
-	for (WaypointMap::iterator it = waypoints.begin(); it != waypoints.end(); it++) {
-		Waypoint* waypoint = it->second;
-		if (waypoint && waypoint->pos == position) {
-			return waypoint;
-		}
-	}
-	return nullptr;
+	return positions.find(position);
 }
 
 void Waypoints::removeWaypoint(std::string name) {
@@ -68,6 +63,31 @@ void Waypoints::removeWaypoint(std::string name) {
 	if (iter == waypoints.end()) {
 		return;
 	}
-	delete iter->second;
+
+	Waypoint* wp = iter->second;
+	if (wp->pos.isValid()) {
+		positions.erase(wp->pos, wp);
+	}
+	delete wp;
 	waypoints.erase(iter);
 }
+
+void Waypoints::moveWaypoint(Waypoint* wp, const Position &position) {
+	if (wp->pos.isValid()) {
+		positions.erase(wp->pos, wp);
+	}
+	wp->pos = position;
+	if (position.isValid()) {
+		positions.insert(position, wp);
+	}
+}
+
+void Waypoints::rebuildIndex() {
+	positions.clear();
+	for (const auto &entry : waypoints) {
+		Waypoint* wp = entry.second;
+		if (wp->pos.isValid()) {
+			positions.insert(wp->pos, wp);
+		}
+	}
+}
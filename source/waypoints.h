@@ -19,6 +19,7 @@
 #define RME_WAYPOINTS_H_
 
 #include "position.h"
+#include "spatial_index.h"
 
 class Waypoint {
 public:
@@ -38,6 +39,10 @@ public:
 	Waypoint* getWaypoint(std::string name);
 	Waypoint* getWaypoint(const Position &position);
 	void removeWaypoint(std::string name);
+	// Waypoints have to be moved through here to stay findable by position
+	void moveWaypoint(Waypoint* wp, const Position &position);
+	// Has to be called after waypoints were added to the map directly
+	void rebuildIndex();
 
 	WaypointMap waypoints;
 
@@ -56,6 +61,7 @@ public:
 
 private:
 	Map &map;
+	SpatialIndex<Waypoint*> positions;
 };
 
 #endif
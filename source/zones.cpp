@@ -19,6 +19,7 @@
 
 #include "zones.h"
 #include "map.h"
+#include "tile.h"
 
 Zones::~Zones() {
 	zones.clear();
@@ -65,3 +66,48 @@ unsigned int Zones::generateID() {
 	}
 	return id;
 }
+
+void Zones::addTile(const Tile* tile, int x, int y) {
+	const uint32_t key = getLeafKey(x, y);
+	for (uint16_t id : tile->getZones()) {
+		++leaves[id][key];
+	}
+}
+
+void Zones::removeTile(const Tile* tile, int x, int y) {
+	const uint32_t key = getLeafKey(x, y);
+	for (uint16_t id : tile->getZones()) {
+		auto zone = leaves.find(id);
+		if (zone == leaves.end()) {
+			continue;
+		}
+
+		ZoneLeafMap &zone_leaves = zone->second;
+		auto leaf = zone_leaves.find(key);
+		if (leaf != zone_leaves.end() && --leaf->second == 0) {
+			zone_leaves.erase(leaf);
+			if (zone_leaves.empty()) {
+				leaves.erase(zone);
+			}
+		}
+	}
+}
+
+void Zones::clearTiles(unsigned int id) {
+	leaves.erase(static_cast<uint16_t>(id));
+}
+
+const ZoneLeafMap* Zones::getZoneLeaves(unsigned int id) const {
+	auto it = leaves.find(static_cast<uint16_t>(id));
+	return it != leaves.end() ? &it->second : nullptr;
+}
+
+std::vector<unsigned int> Zones::getDeletedZones() const {
+	std::vector<unsigned int> deleted;
+	for (const auto &entry : leaves) {
+		if (used_ids.find(entry.first) == used_ids.end()) {
+			deleted.push_back(entry.first);
+		}
+	}
+	return deleted;
+}
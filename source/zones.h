@@ -18,7 +18,11 @@
 #ifndef RME_ZONES_H_
 #define RME_ZONES_H_
 
+class Tile;
+
 typedef std::map<std::string, unsigned int> ZoneMap;
+// Number of tiles carrying a zone by map leaf (4x4 tiles, all floors), see Zones::getLeafKey
+typedef std::map<uint32_t, uint32_t> ZoneLeafMap;
 
 class Zones {
 public:
@@ -39,6 +43,26 @@ public:
 	bool hasZone(unsigned int id);
 	void removeZone(std::string name);
 
+	// Index of the leaves holding tiles of each zone
+	// Kept up to date by Map whenever a tile is placed, swapped or removed.
+	void addTile(const Tile* tile, int x, int y);
+	void removeTile(const Tile* tile, int x, int y);
+	// Drops a zone from the index, for when its tiles were changed in place
+	void clearTiles(unsigned int id);
+	// nullptr if no tile carries the zone
+	const ZoneLeafMap* getZoneLeaves(unsigned int id) const;
+	// Zones still carried by tiles that have been removed from the list
+	std::vector<unsigned int> getDeletedZones() const;
+
+	static uint32_t getLeafKey(int x, int y) noexcept {
+		return (static_cast<uint32_t>(x & 0xFFFF) >> 2) << 14 | (static_cast<uint32_t>(y & 0xFFFF) >> 2);
+	}
+	// First tile of a leaf
+	static void getLeafOrigin(uint32_t key, int &x, int &y) noexcept {
+		x = static_cast<int>((key >> 14) << 2);
+		y = static_cast<int>((key & 0x3FFF) << 2);
+	}
+
 	ZoneMap zones;
 
 	ZoneMap::iterator begin() {
@@ -57,6 +81,7 @@ public:
 private:
 	Map &map;
 	std::unordered_set<unsigned int> used_ids;
+	std::unordered_map<uint16_t, ZoneLeafMap> leaves;
 
 	unsigned int generateID();
 };